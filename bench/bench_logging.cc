@@ -0,0 +1,76 @@
+/* Chromium logging of the stand-alone benchmarks, every message to stderr.
+ *
+ * src/chromium/logging.cc logs through the Windows debug log and file
+ * handles, the benchmarks only need the LOG and CHECK macros of the engines
+ * under test and so build on any platform.
+ */
+
+#include "../src/chromium/logging.hh"
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace logging {
+
+static const char* const kLogSeverityNames[] = { "INFO", "WARNING", "ERROR", "FATAL" };
+
+#if !defined(_MSC_VER)
+template std::string* MakeCheckOpString<int, int>(const int&, const int&, const char* names);
+template std::string* MakeCheckOpString<unsigned long, unsigned long>(const unsigned long&, const unsigned long&, const char* names);
+template std::string* MakeCheckOpString<unsigned long, unsigned int>(const unsigned long&, const unsigned int&, const char* names);
+template std::string* MakeCheckOpString<unsigned int, unsigned long>(const unsigned int&, const unsigned long&, const char* names);
+template std::string* MakeCheckOpString<std::string, std::string>(const std::string&, const std::string&, const char* name);
+#endif
+
+int GetMinLogLevel() {
+	return LOG_INFO;
+}
+
+int GetVlogVerbosity() {
+	return -1;
+}
+
+int GetVlogLevelHelper (const char* /* file */, size_t /* N */) {
+	return GetVlogVerbosity();
+}
+
+LogMessage::LogMessage (const char* file, int line, LogSeverity severity, int /* ctr */) :
+	severity_ (severity), message_start_ (0), file_ (file), line_ (line)
+{
+}
+
+LogMessage::LogMessage (const char* file, int line) :
+	severity_ (LOG_INFO), message_start_ (0), file_ (file), line_ (line)
+{
+}
+
+LogMessage::LogMessage (const char* file, int line, LogSeverity severity) :
+	severity_ (severity), message_start_ (0), file_ (file), line_ (line)
+{
+}
+
+LogMessage::LogMessage (const char* file, int line, std::string* result) :
+	severity_ (LOG_FATAL), message_start_ (0), file_ (file), line_ (line)
+{
+	stream_ << "Check failed: " << *result;
+	delete result;
+}
+
+LogMessage::LogMessage (const char* file, int line, LogSeverity severity, std::string* result) :
+	severity_ (severity), message_start_ (0), file_ (file), line_ (line)
+{
+	stream_ << "Check failed: " << *result;
+	delete result;
+}
+
+LogMessage::~LogMessage()
+{
+	const char* severity_name = (severity_ >= LOG_INFO && severity_ <= LOG_FATAL) ? kLogSeverityNames[severity_] : "VERBOSE";
+	fprintf (stderr, "[%s:%s(%d)] %s\n", severity_name, file_, line_, stream_.str().c_str());
+	if (LOG_FATAL == severity_)
+		abort();
+}
+
+} /* namespace logging */
+
+/* eof */
@@ -0,0 +1,788 @@
+/* Engine benchmark, reference and single cursor engines over a synthetic tick
+ * source sweeping symbol count, synthetic ratio, ticks per symbol, window
+ * length and dependent crosses per leg.
+ *
+ * One CSV row, or JSON object per line, for each engine and point of the
+ * sweep so runs of different builds can be compared.  With --tick-file each
+ * window is first written to a tick file and the engines replay the mapped
+ * file instead of the generator.
+ *
+ * --verify instead compares the vectorized, fixed-point, time partitioned and
+ * sharded engines, and the streaming engine fed through the in-process tick
+ * feed, with the serial scan of the same window, exiting non-zero unless every
+ * result is bit-identical, fixed-point after bnymellon::price().
+ *
+ * usage: get_hilo_bench [--json] [--quick] [--iterations count] [--tick-file path] [--verify]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+/* Boost Posix Time */
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include "../src/bnymellon.hh"
+#include "../src/get_hilo.hh"
+#include "../src/stream_engine.hh"
+#include "../src/thread_pool.hh"
+#include "../src/tick_feed.hh"
+#include "../src/tick_file.hh"
+#include "../src/tick_source.hh"
+
+/* heap allocations by any thread, the engines under test run on the main
+ * thread only.
+ */
+static volatile uint64_t g_allocation_count = 0;
+
+void* operator new (size_t size)
+{
+	++g_allocation_count;
+	void* p = malloc (0 == size ? 1 : size);
+	if (nullptr == p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[] (size_t size)
+{
+	return operator new (size);
+}
+
+void operator delete (void* p)
+{
+	free (p);
+}
+
+void operator delete[] (void* p)
+{
+	free (p);
+}
+
+namespace {
+
+/* Start of the synthetic day, 2011-12-21 00:00:00 UTC as bin/run_query.tcl. */
+	const __time32_t kEpoch = 1324425600;
+
+	const char* kBidField = "BidPrice";
+	const char* kAskField = "AskPrice";
+
+/* elements of a static array, _countof is Microsoft only. */
+	template <class T, size_t N>
+	size_t CountOf (const T (&)[N]) { return N; }
+
+	struct sweep_t {
+		unsigned symbol_count;
+		double synthetic_ratio;
+		unsigned ticks_per_symbol;
+		unsigned window_seconds;
+		unsigned crosses_per_leg;
+	};
+
+	struct result_t {
+		uint64_t ticks;
+		uint64_t ticks_read;
+		double seconds;
+		uint64_t allocations;
+	};
+
+/* Counts every tick delivered by the wrapped source. */
+	class counting_source_t : public hilo::tick_source_t
+	{
+	public:
+		counting_source_t (std::unique_ptr<hilo::tick_source_t> source, uint64_t* count) :
+			source_ (std::move (source)),
+			count_ (count)
+		{
+		}
+
+		virtual bool Open (std::set<std::string>& symbol_set, const std::unordered_map<std::string, size_t>& field_map, std::vector<double>*const fields, __time32_t from, __time32_t till) override {
+			return source_->Open (symbol_set, field_map, fields, from, till);
+		}
+		virtual bool Next() override {
+			if (!source_->Next())
+				return false;
+			++*count_;
+			return true;
+		}
+		virtual const char* GetCurrentSymbolName() override {
+			return source_->GetCurrentSymbolName();
+		}
+		virtual __time32_t GetCurrentTime32() override {
+			return source_->GetCurrentTime32();
+		}
+		virtual void Close() override {
+			source_->Close();
+		}
+
+	private:
+		std::unique_ptr<hilo::tick_source_t> source_;
+		uint64_t* count_;
+	};
+
+	class counting_source_factory_t : public hilo::tick_source_factory_t
+	{
+	public:
+		explicit counting_source_factory_t (const hilo::tick_source_factory_t& factory) :
+			factory_ (factory),
+			count_ (0)
+		{
+		}
+
+		virtual std::unique_ptr<hilo::tick_source_t> Create() const override {
+			return std::unique_ptr<hilo::tick_source_t> (new counting_source_t (factory_.Create(), &count_));
+		}
+
+		uint64_t GetCount() const { return count_; }
+		void Reset() { count_ = 0; }
+
+	private:
+		const hilo::tick_source_factory_t& factory_;
+		mutable uint64_t count_;
+	};
+
+/* Drops the ticks of [gap_from, gap_till) so whole partitions are quiet. */
+	class gap_source_t : public hilo::tick_source_t
+	{
+	public:
+		gap_source_t (std::unique_ptr<hilo::tick_source_t> source, __time32_t gap_from, __time32_t gap_till) :
+			source_ (std::move (source)),
+			gap_from_ (gap_from),
+			gap_till_ (gap_till)
+		{
+		}
+
+		virtual bool Open (std::set<std::string>& symbol_set, const std::unordered_map<std::string, size_t>& field_map, std::vector<double>*const fields, __time32_t from, __time32_t till) override {
+			return source_->Open (symbol_set, field_map, fields, from, till);
+		}
+		virtual bool Next() override {
+			while (source_->Next()) {
+				const __time32_t timestamp = source_->GetCurrentTime32();
+				if (timestamp < gap_from_ || timestamp >= gap_till_)
+					return true;
+			}
+			return false;
+		}
+		virtual const char* GetCurrentSymbolName() override {
+			return source_->GetCurrentSymbolName();
+		}
+		virtual __time32_t GetCurrentTime32() override {
+			return source_->GetCurrentTime32();
+		}
+		virtual void Close() override {
+			source_->Close();
+		}
+
+	private:
+		std::unique_ptr<hilo::tick_source_t> source_;
+		__time32_t gap_from_, gap_till_;
+	};
+
+	class gap_source_factory_t : public hilo::tick_source_factory_t
+	{
+	public:
+		gap_source_factory_t (const hilo::tick_source_factory_t& factory, __time32_t gap_from, __time32_t gap_till) :
+			factory_ (factory),
+			gap_from_ (gap_from),
+			gap_till_ (gap_till)
+		{
+		}
+
+		virtual std::unique_ptr<hilo::tick_source_t> Create() const override {
+			return std::unique_ptr<hilo::tick_source_t> (new gap_source_t (factory_.Create(), gap_from_, gap_till_));
+		}
+
+	private:
+		const hilo::tick_source_factory_t& factory_;
+		__time32_t gap_from_, gap_till_;
+	};
+
+/* Fails to open a cursor over more than symbol_limit symbols as a tick store
+ * refusing a large binding set, the sharded engine splits the chunk.
+ */
+	class bounded_source_t : public hilo::tick_source_t
+	{
+	public:
+		bounded_source_t (std::unique_ptr<hilo::tick_source_t> source, size_t symbol_limit, std::atomic<unsigned>* failed_count) :
+			source_ (std::move (source)),
+			symbol_limit_ (symbol_limit),
+			failed_count_ (failed_count)
+		{
+		}
+
+		virtual bool Open (std::set<std::string>& symbol_set, const std::unordered_map<std::string, size_t>& field_map, std::vector<double>*const fields, __time32_t from, __time32_t till) override {
+			if (symbol_set.size() > symbol_limit_) {
+				++*failed_count_;
+				return false;
+			}
+			return source_->Open (symbol_set, field_map, fields, from, till);
+		}
+		virtual bool Next() override {
+			return source_->Next();
+		}
+		virtual const char* GetCurrentSymbolName() override {
+			return source_->GetCurrentSymbolName();
+		}
+		virtual __time32_t GetCurrentTime32() override {
+			return source_->GetCurrentTime32();
+		}
+		virtual void Close() override {
+			source_->Close();
+		}
+
+	private:
+		std::unique_ptr<hilo::tick_source_t> source_;
+		size_t symbol_limit_;
+		std::atomic<unsigned>* failed_count_;
+	};
+
+	class bounded_source_factory_t : public hilo::tick_source_factory_t
+	{
+	public:
+		bounded_source_factory_t (const hilo::tick_source_factory_t& factory, size_t symbol_limit) :
+			factory_ (factory),
+			symbol_limit_ (symbol_limit),
+			failed_count_ (0)
+		{
+		}
+
+		virtual std::unique_ptr<hilo::tick_source_t> Create() const override {
+			return std::unique_ptr<hilo::tick_source_t> (new bounded_source_t (factory_.Create(), symbol_limit_, &failed_count_));
+		}
+
+		unsigned GetFailedCount() const { return failed_count_; }
+		void Reset() { failed_count_ = 0; }
+
+	private:
+		const hilo::tick_source_factory_t& factory_;
+		size_t symbol_limit_;
+		mutable std::atomic<unsigned> failed_count_;
+	};
+
+/* Every bound field rounded to the bnymellon mantissa as the fixed-point
+ * engine converts at ingest.
+ */
+	class rounding_source_t : public hilo::tick_source_t
+	{
+	public:
+		explicit rounding_source_t (std::unique_ptr<hilo::tick_source_t> source) :
+			source_ (std::move (source)),
+			fields_ (nullptr)
+		{
+		}
+
+		virtual bool Open (std::set<std::string>& symbol_set, const std::unordered_map<std::string, size_t>& field_map, std::vector<double>*const fields, __time32_t from, __time32_t till) override {
+			fields_ = fields;
+			return source_->Open (symbol_set, field_map, fields, from, till);
+		}
+		virtual bool Next() override {
+			if (!source_->Next())
+				return false;
+			std::for_each (fields_->begin(), fields_->end(), [](double& value) {
+				value = bnymellon::round (value);
+			});
+			return true;
+		}
+		virtual const char* GetCurrentSymbolName() override {
+			return source_->GetCurrentSymbolName();
+		}
+		virtual __time32_t GetCurrentTime32() override {
+			return source_->GetCurrentTime32();
+		}
+		virtual void Close() override {
+			source_->Close();
+		}
+
+	private:
+		std::unique_ptr<hilo::tick_source_t> source_;
+		std::vector<double>* fields_;
+	};
+
+	class rounding_source_factory_t : public hilo::tick_source_factory_t
+	{
+	public:
+		explicit rounding_source_factory_t (const hilo::tick_source_factory_t& factory) :
+			factory_ (factory)
+		{
+		}
+
+		virtual std::unique_ptr<hilo::tick_source_t> Create() const override {
+			return std::unique_ptr<hilo::tick_source_t> (new rounding_source_t (factory_.Create()));
+		}
+
+	private:
+		const hilo::tick_source_factory_t& factory_;
+	};
+
+	std::vector<std::string> MakeUniverse (unsigned symbol_count)
+	{
+		std::vector<std::string> universe;
+		char symbol_name[32];
+		for (unsigned i = 0; i < symbol_count; ++i) {
+			sprintf (symbol_name, "S%04u=", i);
+			universe.push_back (symbol_name);
+		}
+		return universe;
+	}
+
+/* The first symbol_count * synthetic_ratio symbols are quoted only through
+ * crosses with the following crosses_per_leg symbols, the remainder as
+ * outrights.
+ */
+	std::vector<std::shared_ptr<hilo::hilo_t>> MakeRules (const std::vector<std::string>& universe, const sweep_t& sweep)
+	{
+		std::vector<std::shared_ptr<hilo::hilo_t>> rules;
+		const unsigned symbol_count = static_cast<unsigned> (universe.size());
+		const unsigned crossed_count = static_cast<unsigned> ((sweep.synthetic_ratio * symbol_count) + 0.5);
+		for (unsigned i = 0; i < symbol_count; ++i) {
+			if (i < crossed_count && symbol_count > 1) {
+				for (unsigned j = 0; j < sweep.crosses_per_leg; ++j) {
+					const unsigned other = (i + 1 + (j % (symbol_count - 1))) % symbol_count;
+					std::shared_ptr<hilo::hilo_t> rule (new hilo::hilo_t);
+					rule->name = universe[i] + universe[other];
+					rule->is_synthetic = true;
+					rule->math_op = (j & 1) ? hilo::MATH_OP_DIVIDE : hilo::MATH_OP_TIMES;
+					rule->legs.first.symbol_name  = universe[i];
+					rule->legs.first.bid_field    = kBidField;
+					rule->legs.first.ask_field    = kAskField;
+					rule->legs.second.symbol_name = universe[other];
+					rule->legs.second.bid_field   = kBidField;
+					rule->legs.second.ask_field   = kAskField;
+					rules.push_back (rule);
+				}
+			} else {
+				std::shared_ptr<hilo::hilo_t> rule (new hilo::hilo_t);
+				rule->name = universe[i];
+				rule->legs.first.symbol_name = universe[i];
+				rule->legs.first.bid_field   = kBidField;
+				rule->legs.first.ask_field   = kAskField;
+				rules.push_back (rule);
+			}
+		}
+		return rules;
+	}
+
+/* MakeRules() over group_count slices of the universe, one connected
+ * component of crosses per slice beside the outrights.
+ */
+	std::vector<std::shared_ptr<hilo::hilo_t>> MakeGroupedRules (const std::vector<std::string>& universe, const sweep_t& sweep, unsigned group_count)
+	{
+		std::vector<std::shared_ptr<hilo::hilo_t>> rules;
+		const size_t group_size = universe.size() / group_count;
+		for (unsigned g = 0; g < group_count; ++g) {
+			const std::vector<std::string> group (universe.begin() + (g * group_size), universe.begin() + ((g + 1) * group_size));
+			const auto group_rules = MakeRules (group, sweep);
+			rules.insert (rules.end(), group_rules.begin(), group_rules.end());
+		}
+		return rules;
+	}
+
+/* Best of iterations, each on a fresh rule set. */
+	result_t Run (int engine, const std::vector<std::string>& universe, const sweep_t& sweep, const hilo::tick_source_factory_t& factory, unsigned iterations)
+	{
+		using namespace boost::posix_time;
+
+		counting_source_factory_t counter (factory);
+		hilo::scan_options_t options;
+		options.source = &counter;
+		const __time32_t from = kEpoch, till = kEpoch + sweep.window_seconds;
+
+		result_t result;
+		result.ticks = result.ticks_read = result.allocations = 0;
+		result.seconds = 0.0;
+		for (unsigned i = 0; i < iterations; ++i) {
+			auto rules = MakeRules (universe, sweep);
+			counter.Reset();
+			const uint64_t allocation_count = g_allocation_count;
+			const ptime start (microsec_clock::universal_time());
+			if (engine < 0)
+				hilo::reference::get_hilo (rules, from, till, options);
+			else
+				hilo::get_hilo (engine, rules, from, till, options);
+			const ptime end (microsec_clock::universal_time());
+			const double seconds = static_cast<double> ((end - start).total_microseconds()) / 1000000.0;
+			if (0 == i || seconds < result.seconds) {
+				result.seconds = seconds;
+				result.ticks_read = counter.GetCount();
+				result.allocations = g_allocation_count - allocation_count;
+			}
+		}
+		return result;
+	}
+
+/* Ticks of the window across the universe, the reference engine reads the
+ * window once per rule.
+ */
+	uint64_t CountTicks (const std::vector<std::string>& universe, const sweep_t& sweep, const hilo::tick_source_factory_t& factory)
+	{
+		std::set<std::string> symbol_set (universe.begin(), universe.end());
+		std::unordered_map<std::string, size_t> field_map;
+		field_map.emplace (std::make_pair (std::string (kBidField), 0));
+		field_map.emplace (std::make_pair (std::string (kAskField), 1));
+		std::vector<double> fields (2);
+		auto source = factory.Create();
+		uint64_t tick_count = 0;
+		if (source->Open (symbol_set, field_map, &fields, kEpoch, kEpoch + sweep.window_seconds)) {
+			while (source->Next())
+				++tick_count;
+			source->Close();
+		}
+		return tick_count;
+	}
+
+	void Report (bool is_json, const char* engine_name, const sweep_t& sweep, size_t rule_count, const result_t& result)
+	{
+		const double ticks_per_second = result.seconds > 0.0 ? result.ticks / result.seconds : 0.0;
+		const double ns_per_tick = result.ticks > 0 ? (1000000000.0 * result.seconds) / result.ticks : 0.0;
+		if (is_json) {
+			printf ("{ \"engine\": \"%s\", \"symbols\": %u, \"synthetic_ratio\": %g, \"ticks_per_symbol\": %u"
+				", \"window_seconds\": %u, \"crosses_per_leg\": %u, \"rules\": %u, \"ticks\": %llu, \"ticks_read\": %llu"
+				", \"seconds\": %.6f, \"ticks_per_sec\": %.0f, \"ns_per_tick\": %.3f, \"allocs_per_query\": %llu }\n",
+				engine_name, sweep.symbol_count, sweep.synthetic_ratio, sweep.ticks_per_symbol,
+				sweep.window_seconds, sweep.crosses_per_leg, static_cast<unsigned> (rule_count),
+				static_cast<unsigned long long> (result.ticks), static_cast<unsigned long long> (result.ticks_read),
+				result.seconds, ticks_per_second, ns_per_tick, static_cast<unsigned long long> (result.allocations));
+		} else {
+			printf ("%s,%u,%g,%u,%u,%u,%u,%llu,%llu,%.6f,%.0f,%.3f,%llu\n",
+				engine_name, sweep.symbol_count, sweep.synthetic_ratio, sweep.ticks_per_symbol,
+				sweep.window_seconds, sweep.crosses_per_leg, static_cast<unsigned> (rule_count),
+				static_cast<unsigned long long> (result.ticks), static_cast<unsigned long long> (result.ticks_read),
+				result.seconds, ticks_per_second, ns_per_tick, static_cast<unsigned long long> (result.allocations));
+		}
+		fflush (stdout);
+	}
+
+/* Same bits, so NaN and signed zero are compared too. */
+	bool IsIdentical (double lhs, double rhs)
+	{
+		return 0 == memcmp (&lhs, &rhs, sizeof (double));
+	}
+
+	bool IsIdentical (const hilo::bar_t& lhs, const hilo::bar_t& rhs)
+	{
+		return IsIdentical (lhs.high, rhs.high) && IsIdentical (lhs.low, rhs.low) && lhs.is_null == rhs.is_null &&
+			lhs.high_mantissa == rhs.high_mantissa && lhs.low_mantissa == rhs.low_mantissa;
+	}
+
+	bool IsIdentical (const std::vector<std::vector<hilo::bar_t>>& lhs, const std::vector<std::vector<hilo::bar_t>>& rhs)
+	{
+		if (lhs.size() != rhs.size())
+			return false;
+		for (size_t j = 0; j < lhs.size(); ++j) {
+			if (lhs[j].size() != rhs[j].size())
+				return false;
+			for (size_t k = 0; k < lhs[j].size(); ++k)
+				if (!IsIdentical (lhs[j][k], rhs[j][k]))
+					return false;
+		}
+		return true;
+	}
+
+/* Engine result against the serial scan, fixed-point bars against the serial
+ * high and low as priced by the mantissa.
+ */
+	bool IsIdentical (int engine, const hilo::bar_t& serial, const hilo::bar_t& bar)
+	{
+		if (hilo::ENGINE_FIXED_POINT != engine)
+			return IsIdentical (serial, bar);
+		const bnymellon::mantissa_t high = bnymellon::mantissa (serial.high), low = bnymellon::mantissa (serial.low);
+		return IsIdentical (bnymellon::price (high), bar.high) && IsIdentical (bnymellon::price (low), bar.low) &&
+			serial.is_null == bar.is_null && high == bar.high_mantissa && low == bar.low_mantissa;
+	}
+
+	bool IsIdentical (int engine, const std::vector<std::vector<hilo::bar_t>>& serial, const std::vector<std::vector<hilo::bar_t>>& bars)
+	{
+		if (serial.size() != bars.size())
+			return false;
+		for (size_t j = 0; j < serial.size(); ++j) {
+			if (serial[j].size() != bars[j].size())
+				return false;
+			for (size_t k = 0; k < serial[j].size(); ++k)
+				if (!IsIdentical (engine, serial[j][k], bars[j][k]))
+					return false;
+		}
+		return true;
+	}
+
+/* Every tick of the window pushed through the in-process feed into the
+ * streaming engine, bars as closed by the watermark at the window end.
+ */
+	bool Stream (const std::vector<std::shared_ptr<hilo::hilo_t>>& rules, const hilo::tick_source_factory_t& factory, __time32_t from, __time32_t till, int interval_seconds, std::vector<std::vector<hilo::bar_t>>* bars)
+	{
+		hilo::stream_engine_t engine (rules);
+		engine.Align (from, interval_seconds);
+		hilo::memory_feed_t feed;
+		const std::unordered_map<std::string, size_t>& field_map = engine.GetFieldMap();
+		if (!feed.Subscribe (engine.GetSymbolSet(), field_map, from, &engine))
+			return false;
+		std::set<std::string> symbol_set (engine.GetSymbolSet());
+		std::vector<double> fields (field_map.size());
+		std::unordered_map<std::string, double> values;
+		auto source = factory.Create();
+		if (!source->Open (symbol_set, field_map, &fields, from, till))
+			return false;
+		while (source->Next()) {
+			values.clear();
+			std::for_each (field_map.begin(), field_map.end(), [&](const std::pair<const std::string, size_t>& field) {
+				values[field.first] = fields[field.second];
+			});
+			feed.Push (source->GetCurrentSymbolName(), source->GetCurrentTime32(), values);
+		}
+		source->Close();
+		feed.Advance (till);
+		feed.Unsubscribe();
+		return engine.Close (from, till, boost::posix_time::seconds (0), bars);
+	}
+
+/* Partitioned and sharded scans of both overloads against the serial scan
+ * over a window with a quiet gap, which leaves partitions without ticks.
+ * Sharded cursors over more than kSymbolLimit symbols fail to open so that
+ * chunks are split and retried.
+ */
+	bool Verify (hilo::thread_pool_t* pool)
+	{
+		static const unsigned kPartitionCounts[] = { 2, 3, 8 };
+		static const int kEngines[] = { hilo::ENGINE_SINGLE_ITERATOR, hilo::ENGINE_VECTORIZED, hilo::ENGINE_FIXED_POINT };
+		static const char* kEngineNames[] = { "single_iterator", "vectorized", "fixed_point" };
+		static const int kIntervalSeconds = 15 * 60;
+		static const unsigned kShardCounts[] = { 1, 2, 4 };
+		static const size_t kChunkSymbols = 24;
+		static const size_t kSymbolLimit = 8;
+		static const unsigned kGroupCount = 4;
+
+		sweep_t sweep;
+		sweep.symbol_count     = 40;
+		sweep.synthetic_ratio  = 0.5;
+		sweep.ticks_per_symbol = 500;
+		sweep.window_seconds   = 4 * 60 * 60;
+		sweep.crosses_per_leg  = 2;
+		const std::vector<std::string> universe (MakeUniverse (sweep.symbol_count));
+		const hilo::synthetic_source_factory_t synthetic (sweep.symbol_count, 2, universe);
+		const __time32_t from = kEpoch, till = kEpoch + sweep.window_seconds;
+		const gap_source_factory_t factory (synthetic, from + (60 * 60), from + (150 * 60));
+		hilo::scan_options_t options;
+		options.source = &factory;
+
+		bool is_identical = true;
+		for (size_t i = 0; i < CountOf (kPartitionCounts); ++i) {
+			auto serial = MakeRules (universe, sweep), partitioned = MakeRules (universe, sweep);
+			bool is_ok = hilo::single_iterator::get_hilo (serial, from, till, options) &&
+				hilo::partitioned::get_hilo (pool, kPartitionCounts[i], partitioned, from, till, options);
+			for (size_t j = 0; is_ok && j < serial.size(); ++j) {
+				is_ok = IsIdentical (serial[j]->high, partitioned[j]->high) &&
+					IsIdentical (serial[j]->low, partitioned[j]->low) &&
+					serial[j]->is_null == partitioned[j]->is_null;
+			}
+			printf ("verify,window,single_iterator,%u,%s\n", kPartitionCounts[i], is_ok ? "ok" : "FAIL");
+			is_identical &= is_ok;
+		}
+		for (size_t e = 0; e < CountOf (kEngines); ++e)
+		for (size_t i = 0; i < CountOf (kPartitionCounts); ++i) {
+			auto serial = MakeRules (universe, sweep), partitioned = MakeRules (universe, sweep);
+			std::vector<std::vector<hilo::bar_t>> serial_bars, partitioned_bars;
+			bool is_ok = hilo::get_hilo (kEngines[e], serial, from, till, kIntervalSeconds, false /* reset legs */, &serial_bars, options) &&
+				hilo::partitioned::get_hilo (kEngines[e], pool, kPartitionCounts[i], partitioned, from, till, kIntervalSeconds, &partitioned_bars, options) &&
+				serial_bars.size() == partitioned_bars.size();
+			for (size_t j = 0; is_ok && j < serial_bars.size(); ++j) {
+				is_ok = serial_bars[j].size() == partitioned_bars[j].size();
+				for (size_t k = 0; is_ok && k < serial_bars[j].size(); ++k)
+					is_ok = IsIdentical (serial_bars[j][k], partitioned_bars[j][k]);
+			}
+			printf ("verify,bars,%s,%u,%s\n", kEngineNames[e], kPartitionCounts[i], is_ok ? "ok" : "FAIL");
+			is_identical &= is_ok;
+		}
+/* streaming engine resets legs each interval as the timer scan */
+		{
+			auto serial = MakeRules (universe, sweep), streamed = MakeRules (universe, sweep);
+			std::vector<std::vector<hilo::bar_t>> serial_bars, stream_bars;
+			const bool is_ok = hilo::single_iterator::get_hilo (serial, from, till, kIntervalSeconds, false /* reset legs */, &serial_bars, options) &&
+				Stream (streamed, factory, from, till, kIntervalSeconds, &stream_bars) &&
+				IsIdentical (serial_bars, stream_bars);
+			printf ("verify,stream,single_iterator,1,%s\n", is_ok ? "ok" : "FAIL");
+			is_identical &= is_ok;
+		}
+/* other engines against the serial scan bit for bit, the fixed-point engine
+ * against the serial scan of the ticks as converted at ingest.
+ */
+		const rounding_source_factory_t rounding (factory);
+		hilo::scan_options_t rounding_options (options);
+		rounding_options.source = &rounding;
+		for (size_t e = 1; e < CountOf (kEngines); ++e) {
+			const hilo::scan_options_t& serial_options = (hilo::ENGINE_FIXED_POINT == kEngines[e]) ? rounding_options : options;
+			auto serial = MakeRules (universe, sweep), window = MakeRules (universe, sweep), bucketed = MakeRules (universe, sweep);
+			std::vector<std::vector<hilo::bar_t>> serial_bars, engine_bars;
+			bool is_ok = hilo::single_iterator::get_hilo (serial, from, till, serial_options) &&
+				hilo::get_hilo (kEngines[e], window, from, till, options);
+			for (size_t j = 0; is_ok && j < serial.size(); ++j)
+				is_ok = IsIdentical (kEngines[e], hilo::bar_t (*serial[j].get()), hilo::bar_t (*window[j].get()));
+			printf ("verify,window,%s,1,%s\n", kEngineNames[e], is_ok ? "ok" : "FAIL");
+			is_identical &= is_ok;
+			serial = MakeRules (universe, sweep);
+			is_ok = hilo::single_iterator::get_hilo (serial, from, till, kIntervalSeconds, false /* reset legs */, &serial_bars, serial_options) &&
+				hilo::get_hilo (kEngines[e], bucketed, from, till, kIntervalSeconds, false /* reset legs */, &engine_bars, options) &&
+				IsIdentical (kEngines[e], serial_bars, engine_bars);
+			printf ("verify,bars,%s,1,%s\n", kEngineNames[e], is_ok ? "ok" : "FAIL");
+			is_identical &= is_ok;
+		}
+/* sharded over separate synthetic components, the serial scan reads the
+ * unbounded source.
+ */
+		bounded_source_factory_t bounded (factory, kSymbolLimit);
+		hilo::scan_options_t bounded_options (options);
+		bounded_options.source = &bounded;
+		for (size_t i = 0; i < CountOf (kShardCounts); ++i) {
+			auto serial = MakeGroupedRules (universe, sweep, kGroupCount), sharded = MakeGroupedRules (universe, sweep, kGroupCount);
+			bounded.Reset();
+			bool is_ok = hilo::single_iterator::get_hilo (serial, from, till, options) &&
+				hilo::sharded::get_hilo (hilo::ENGINE_SINGLE_ITERATOR, pool, kShardCounts[i], kChunkSymbols, sharded, from, till, bounded_options) &&
+				bounded.GetFailedCount() > 0;
+			for (size_t j = 0; is_ok && j < serial.size(); ++j)
+				is_ok = IsIdentical (hilo::bar_t (*serial[j].get()), hilo::bar_t (*sharded[j].get()));
+			printf ("verify,window,sharded,%u,%s\n", kShardCounts[i], is_ok ? "ok" : "FAIL");
+			is_identical &= is_ok;
+		}
+		for (size_t i = 0; i < CountOf (kShardCounts); ++i) {
+			auto serial = MakeGroupedRules (universe, sweep, kGroupCount), sharded = MakeGroupedRules (universe, sweep, kGroupCount);
+			std::vector<std::vector<hilo::bar_t>> serial_bars, sharded_bars;
+			bounded.Reset();
+			bool is_ok = hilo::single_iterator::get_hilo (serial, from, till, kIntervalSeconds, false /* reset legs */, &serial_bars, options) &&
+				hilo::sharded::get_hilo (hilo::ENGINE_SINGLE_ITERATOR, pool, kShardCounts[i], kChunkSymbols, sharded, from, till, kIntervalSeconds, false /* reset legs */, &sharded_bars, bounded_options) &&
+				bounded.GetFailedCount() > 0 &&
+				IsIdentical (serial_bars, sharded_bars);
+			for (size_t j = 0; is_ok && j < serial.size(); ++j)
+				is_ok = IsIdentical (hilo::bar_t (*serial[j].get()), hilo::bar_t (*sharded[j].get()));
+			printf ("verify,bars,sharded,%u,%s\n", kShardCounts[i], is_ok ? "ok" : "FAIL");
+			is_identical &= is_ok;
+		}
+/* watermarks recorded by a sharded bars scan as the late tick probe reads them */
+		for (size_t i = 0; i < CountOf (kPartitionCounts); ++i) {
+			auto rules = MakeRules (universe, sweep);
+			std::vector<std::vector<hilo::bar_t>> bars;
+			std::vector<hilo::watermark_t> scan_marks, probe_marks;
+			hilo::scan_options_t marks_options (options);
+			marks_options.watermarks = &scan_marks;
+			const bool is_ok = hilo::sharded::get_hilo (hilo::ENGINE_SINGLE_ITERATOR, pool, kPartitionCounts[i], 8 /* chunk symbols */, rules, from, till, kIntervalSeconds, false /* reset legs */, &bars, marks_options) &&
+				hilo::get_watermarks (rules, from, till, kIntervalSeconds, &probe_marks, options) &&
+				scan_marks.size() == (sweep.window_seconds / kIntervalSeconds) &&
+				scan_marks == probe_marks;
+			printf ("verify,watermarks,sharded,%u,%s\n", kPartitionCounts[i], is_ok ? "ok" : "FAIL");
+			is_identical &= is_ok;
+		}
+		fflush (stdout);
+		return is_identical;
+	}
+
+} /* anonymous namespace */
+
+int
+main (
+	int		argc,
+	char*		argv[]
+	)
+{
+	bool is_json = false, is_quick = false, is_verify = false;
+	unsigned iterations = 3;
+	const char* tick_file_path = nullptr;
+	for (int i = 1; i < argc; ++i) {
+		if (0 == strcmp (argv[i], "--json"))
+			is_json = true;
+		else if (0 == strcmp (argv[i], "--quick"))
+			is_quick = true;
+		else if (0 == strcmp (argv[i], "--iterations") && (i + 1) < argc)
+			iterations = atoi (argv[++i]);
+		else if (0 == strcmp (argv[i], "--tick-file") && (i + 1) < argc)
+			tick_file_path = argv[++i];
+		else if (0 == strcmp (argv[i], "--verify"))
+			is_verify = true;
+		else {
+			fprintf (stderr, "usage: %s [--json] [--quick] [--iterations count] [--tick-file path] [--verify]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (0 == iterations)
+		iterations = 1;
+	if (is_verify) {
+		hilo::thread_pool_t pool (4);
+		return Verify (&pool) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	static const unsigned kSymbolCounts[]   = { 10, 100, 500 };
+	static const double   kSyntheticRatios[] = { 0.0, 0.5, 1.0 };
+	static const unsigned kTicksPerSymbol[] = { 100, 1000 };
+	static const unsigned kWindowSeconds[]  = { 60, 3600 };
+	static const unsigned kCrossesPerLeg[]  = { 1, 4 };
+	const size_t symbol_sweep = is_quick ? 1 : CountOf (kSymbolCounts);
+	const size_t tick_sweep   = is_quick ? 1 : CountOf (kTicksPerSymbol);
+
+/* engine index, reference first */
+	struct engine_t {
+		int engine;
+		const char* name;
+	};
+	static const engine_t kEngines[] = {
+		{ -1,                           "reference" },
+		{ hilo::ENGINE_SINGLE_ITERATOR, "single_iterator" },
+		{ hilo::ENGINE_VECTORIZED,      "vectorized" },
+		{ hilo::ENGINE_FIXED_POINT,     "fixed_point" }
+	};
+
+	if (!is_json)
+		printf ("engine,symbols,synthetic_ratio,ticks_per_symbol,window_seconds,crosses_per_leg,rules,ticks,ticks_read,seconds,ticks_per_sec,ns_per_tick,allocs_per_query\n");
+
+	for (size_t a = 0; a < symbol_sweep; ++a)
+	for (size_t b = 0; b < CountOf (kSyntheticRatios); ++b)
+	for (size_t c = 0; c < tick_sweep; ++c)
+	for (size_t d = 0; d < CountOf (kWindowSeconds); ++d)
+	for (size_t e = 0; e < CountOf (kCrossesPerLeg); ++e)
+	{
+		sweep_t sweep;
+		sweep.symbol_count     = kSymbolCounts[a];
+		sweep.synthetic_ratio  = kSyntheticRatios[b];
+		sweep.ticks_per_symbol = kTicksPerSymbol[c];
+		sweep.window_seconds   = kWindowSeconds[d];
+		sweep.crosses_per_leg  = kCrossesPerLeg[e];
+/* crosses per leg only matter with synthetics */
+		if (0.0 == sweep.synthetic_ratio && e > 0)
+			continue;
+
+		const std::vector<std::string> universe (MakeUniverse (sweep.symbol_count));
+		const uint64_t total_ticks = static_cast<uint64_t> (sweep.symbol_count) * sweep.ticks_per_symbol;
+		const unsigned ticks_per_second = static_cast<unsigned> (std::max<uint64_t> (1, (total_ticks + sweep.window_seconds - 1) / sweep.window_seconds));
+		const hilo::synthetic_source_factory_t synthetic (sweep.symbol_count + a, ticks_per_second, universe);
+		std::unique_ptr<hilo::tick_file_t> tick_file;
+		if (nullptr != tick_file_path) {
+			std::set<std::string> symbol_set (universe.begin(), universe.end());
+			std::vector<std::string> field_names;
+			field_names.push_back (kBidField);
+			field_names.push_back (kAskField);
+			auto source = synthetic.Create();
+			if (!hilo::tick_file_t::Write (tick_file_path, source.get(), symbol_set, field_names, kEpoch, kEpoch + sweep.window_seconds))
+				return EXIT_FAILURE;
+			tick_file.reset (new hilo::tick_file_t (tick_file_path));
+			if (!tick_file->is_open())
+				return EXIT_FAILURE;
+		}
+		const hilo::tick_source_factory_t& factory = (bool)tick_file ? static_cast<const hilo::tick_source_factory_t&> (*tick_file) : synthetic;
+		const uint64_t tick_count = CountTicks (universe, sweep, factory);
+		const size_t rule_count = MakeRules (universe, sweep).size();
+
+		for (size_t i = 0; i < CountOf (kEngines); ++i) {
+/* one cursor per rule, skip the larger sweeps */
+			if (kEngines[i].engine < 0 && (rule_count * tick_count) > UINT64_C(200000000))
+				continue;
+			result_t result = Run (kEngines[i].engine, universe, sweep, factory, iterations);
+			result.ticks = tick_count;
+			Report (is_json, kEngines[i].name, sweep, rule_count, result);
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/* eof */
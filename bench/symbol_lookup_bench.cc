@@ -0,0 +1,130 @@
+/* Cursor symbol lookup benchmark, legacy string keyed map versus interned
+ * symbol index.
+ *
+ * usage: symbol_lookup_bench [symbol count] [tick count]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* Boost Posix Time */
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include "../src/symbol_table.hh"
+
+namespace {
+
+/* stand in for single_iterator::symbol_t */
+	struct payload_t {
+		payload_t() : value (1.0) {}
+		double value;
+	};
+
+	typedef std::vector<std::vector<char>> buffer_list_t;
+
+/* Reader emulation: either a stable buffer per symbol or one buffer
+ * overwritten per record.
+ */
+	const char* ReadName (buffer_list_t& stable, std::vector<char>& shared, size_t symbol, bool is_shared_buffer)
+	{
+		if (!is_shared_buffer)
+			return &stable[symbol][0];
+		strcpy (&shared[0], &stable[symbol][0]);
+		return &shared[0];
+	}
+
+	void Report (const char* name, const boost::posix_time::ptime& start, const boost::posix_time::ptime& end, size_t ticks, double sink)
+	{
+		const double us = static_cast<double> ((end - start).total_microseconds());
+		printf ("%-32s %10.3f ns/tick %12.0f ticks/s (%g)\n", name, (1000.0 * us) / ticks, (1000000.0 * ticks) / us, sink);
+	}
+
+} /* anonymous namespace */
+
+int
+main (
+	int		argc,
+	char*		argv[]
+	)
+{
+	using namespace boost::posix_time;
+
+	const size_t symbol_count = (argc > 1) ? strtoul (argv[1], nullptr, 10) : 500;
+	const size_t tick_count   = (argc > 2) ? strtoul (argv[2], nullptr, 10) : 10000000;
+
+	buffer_list_t stable (symbol_count);
+	std::vector<char> shared (32);
+	std::unordered_map<std::string, std::shared_ptr<payload_t>> symbol_map;
+	hilo::symbol_index_t symbol_index;
+	std::vector<std::shared_ptr<payload_t>> symbols;
+
+	for (size_t i = 0; i < symbol_count; ++i) {
+		char ric[32];
+		sprintf (ric, "%c%c%c%03u=", static_cast<int> ('A' + (i % 26)), static_cast<int> ('A' + ((i / 26) % 26)), static_cast<int> ('A' + ((i / 676) % 26)), static_cast<unsigned> (i % 1000));
+		stable[i].assign (ric, ric + strlen (ric) + 1);
+		std::shared_ptr<payload_t> payload (new payload_t);
+		symbol_map.emplace (std::make_pair (std::string (ric), payload));
+		const size_t slot = symbol_index.Insert (hilo::symbol_table_t::Intern (ric));
+		if (slot == symbols.size())
+			symbols.push_back (payload);
+	}
+
+/* uniform random symbol sequence, FX quotes rarely repeat back to back. */
+	std::vector<unsigned> sequence (tick_count);
+	srand (1);
+	for (size_t i = 0; i < tick_count; ++i)
+		sequence[i] = static_cast<unsigned> (rand() % symbol_count);
+
+	printf ("#%u symbols, #%u ticks\n", static_cast<unsigned> (symbol_count), static_cast<unsigned> (tick_count));
+
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		const bool is_shared_buffer = (1 == pass);
+		printf ("%s reader buffer:\n", is_shared_buffer ? "shared" : "per-symbol");
+
+/* legacy: symbol_map[fr.GetCurrentSymbolName()] */
+		{
+			double sink = 0.0;
+			const ptime start (microsec_clock::universal_time());
+			for (size_t i = 0; i < tick_count; ++i) {
+				auto symbol = symbol_map[ReadName (stable, shared, sequence[i], is_shared_buffer)];
+				sink += symbol->value;
+			}
+			const ptime end (microsec_clock::universal_time());
+			Report ("  unordered_map<std::string>", start, end, tick_count, sink);
+		}
+
+/* interned: symbol_index.Find (fr.GetCurrentSymbolName()) */
+		{
+			double sink = 0.0;
+			const ptime start (microsec_clock::universal_time());
+			for (size_t i = 0; i < tick_count; ++i) {
+				const size_t slot = symbol_index.Find (ReadName (stable, shared, sequence[i], is_shared_buffer));
+				sink += symbols[slot]->value;
+			}
+			const ptime end (microsec_clock::universal_time());
+			Report ("  symbol_index_t", start, end, tick_count, sink);
+		}
+
+/* interned, repeated symbol runs to exercise the pointer cache. */
+		{
+			double sink = 0.0;
+			const ptime start (microsec_clock::universal_time());
+			for (size_t i = 0; i < tick_count; ++i) {
+				const size_t slot = symbol_index.Find (ReadName (stable, shared, sequence[i / 8], is_shared_buffer));
+				sink += symbols[slot]->value;
+			}
+			const ptime end (microsec_clock::universal_time());
+			Report ("  symbol_index_t (runs of 8)", start, end, tick_count, sink);
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/* eof */
@@ -0,0 +1,195 @@
+/* Synthetic cross fan-out benchmark, per-tick MathOperator branching versus
+ * operator grouped math_op_t kernels.
+ *
+ * usage: synthetic_kernel_bench [leg count] [rule count] [tick count]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER)
+#	include <intrin.h>
+#else
+#	include <x86intrin.h>
+#endif
+
+#include "../src/get_hilo.hh"
+#include "../src/math_op.hh"
+
+namespace {
+
+	struct leg_price_t {
+		leg_price_t() : bid (0.0), ask (0.0), is_null (true) {}
+		double bid, ask;
+		bool is_null;
+	};
+
+	struct tick_t {
+		unsigned leg;
+		double bid, ask;
+	};
+
+/* other leg and rule */
+	typedef std::vector<std::pair<unsigned, hilo::hilo_t*>> leg_list_t;
+
+	struct fanout_t {
+		leg_list_t as_first_leg, as_second_leg;
+/* grouped by operator */
+		leg_list_t as_first_leg_times, as_first_leg_divide;
+		leg_list_t as_second_leg_times, as_second_leg_divide;
+	};
+
+/* as single_iterator::query_t::UpdateSynthetic before specialization. */
+	void UpdateSyntheticLegacy (hilo::hilo_t*const query_item, const leg_price_t& first_leg, const leg_price_t& second_leg)
+	{
+		if (first_leg.is_null || second_leg.is_null)
+			return;
+		auto MathOperator = [query_item](double a, double b) -> double {
+			if (hilo::MATH_OP_TIMES == query_item->math_op)
+				return (double)(a * b);
+			else if (b == 0.0)
+				return b;
+			else
+				return (double)(a / b);
+		};
+		const double synthetic_bid_price = MathOperator (first_leg.bid, second_leg.bid);
+		const double synthetic_ask_price = MathOperator (first_leg.ask, second_leg.ask);
+		if (query_item->is_null) {
+			query_item->is_null = false;
+			query_item->low     = synthetic_bid_price;
+			query_item->high    = synthetic_ask_price;
+			return;
+		}
+		if (synthetic_bid_price < query_item->low)  query_item->low  = synthetic_bid_price;
+		if (synthetic_ask_price > query_item->high) query_item->high = synthetic_ask_price;
+	}
+
+	template <int MathOp, bool IsFirstLeg>
+	void UpdateSynthetics (const std::vector<leg_price_t>& legs, unsigned leg, const leg_list_t& leg_list)
+	{
+		for (auto it = leg_list.begin(); it != leg_list.end(); ++it) {
+			const leg_price_t& other = legs[it->first];
+			if (other.is_null)
+				continue;
+			const leg_price_t& first  = IsFirstLeg ? legs[leg] : other;
+			const leg_price_t& second = IsFirstLeg ? other : legs[leg];
+			hilo::UpdateSynthetic<MathOp> (it->second, first.bid, first.ask, second.bid, second.ask);
+		}
+	}
+
+	std::vector<std::shared_ptr<hilo::hilo_t>> MakeRules (unsigned leg_count, unsigned rule_count, std::vector<fanout_t>* fanout)
+	{
+		std::vector<std::shared_ptr<hilo::hilo_t>> rules;
+		fanout->assign (leg_count, fanout_t());
+		srand (1);
+		for (unsigned i = 0; i < rule_count; ++i) {
+			const unsigned first = rand() % leg_count;
+			const unsigned second = (first + 1 + (rand() % (leg_count - 1))) % leg_count;
+			std::shared_ptr<hilo::hilo_t> rule (new hilo::hilo_t);
+			rule->is_synthetic = true;
+			rule->math_op = (rand() & 1) ? hilo::MATH_OP_TIMES : hilo::MATH_OP_DIVIDE;
+			(*fanout)[first].as_first_leg.push_back (std::make_pair (second, rule.get()));
+			(*fanout)[second].as_second_leg.push_back (std::make_pair (first, rule.get()));
+			if (hilo::MATH_OP_TIMES == rule->math_op) {
+				(*fanout)[first].as_first_leg_times.push_back (std::make_pair (second, rule.get()));
+				(*fanout)[second].as_second_leg_times.push_back (std::make_pair (first, rule.get()));
+			} else {
+				(*fanout)[first].as_first_leg_divide.push_back (std::make_pair (second, rule.get()));
+				(*fanout)[second].as_second_leg_divide.push_back (std::make_pair (first, rule.get()));
+			}
+			rules.push_back (rule);
+		}
+		return rules;
+	}
+
+} /* anonymous namespace */
+
+int
+main (
+	int		argc,
+	char*		argv[]
+	)
+{
+	const unsigned leg_count  = (argc > 1) ? atoi (argv[1]) : 40;
+	const unsigned rule_count = (argc > 2) ? atoi (argv[2]) : 400;
+	const unsigned tick_count = (argc > 3) ? atoi (argv[3]) : 2000000;
+
+	if (leg_count < 2) {
+		fprintf (stderr, "leg count must be at least 2.\n");
+		return EXIT_FAILURE;
+	}
+
+/* random walk quote stream, USD legs tick more often than crosses. */
+	std::vector<tick_t> ticks (tick_count);
+	std::vector<double> mid (leg_count, 1.0);
+	srand (2);
+	for (unsigned i = 0; i < tick_count; ++i) {
+		const unsigned leg = (rand() & 3) ? (rand() % (1 + leg_count / 8)) : (rand() % leg_count);
+		mid[leg] *= 1.0 + ((rand() % 201) - 100) * 1e-6;
+		ticks[i].leg = leg;
+		ticks[i].bid = mid[leg] * 0.9999;
+		ticks[i].ask = mid[leg] * 1.0001;
+	}
+
+	std::vector<fanout_t> legacy_fanout, grouped_fanout;
+	auto legacy_rules  = MakeRules (leg_count, rule_count, &legacy_fanout);
+	auto grouped_rules = MakeRules (leg_count, rule_count, &grouped_fanout);
+
+	printf ("#%u legs, #%u rules, #%u ticks\n", leg_count, rule_count, tick_count);
+
+/* before: runtime operator test per rule per tick */
+	uint64_t legacy_cycles;
+	{
+		std::vector<leg_price_t> legs (leg_count);
+		const uint64_t start = __rdtsc();
+		for (unsigned i = 0; i < tick_count; ++i) {
+			const tick_t& tick = ticks[i];
+			leg_price_t& leg = legs[tick.leg];
+			leg.bid = tick.bid; leg.ask = tick.ask; leg.is_null = false;
+			const fanout_t& fanout = legacy_fanout[tick.leg];
+			for (auto it = fanout.as_first_leg.begin(); it != fanout.as_first_leg.end(); ++it)
+				UpdateSyntheticLegacy (it->second, leg, legs[it->first]);
+			for (auto it = fanout.as_second_leg.begin(); it != fanout.as_second_leg.end(); ++it)
+				UpdateSyntheticLegacy (it->second, legs[it->first], leg);
+		}
+		legacy_cycles = __rdtsc() - start;
+	}
+
+/* after: operator groups built once, fixed kernel per group */
+	uint64_t grouped_cycles;
+	{
+		std::vector<leg_price_t> legs (leg_count);
+		const uint64_t start = __rdtsc();
+		for (unsigned i = 0; i < tick_count; ++i) {
+			const tick_t& tick = ticks[i];
+			leg_price_t& leg = legs[tick.leg];
+			leg.bid = tick.bid; leg.ask = tick.ask; leg.is_null = false;
+			const fanout_t& fanout = grouped_fanout[tick.leg];
+			UpdateSynthetics<hilo::MATH_OP_TIMES,  true>  (legs, tick.leg, fanout.as_first_leg_times);
+			UpdateSynthetics<hilo::MATH_OP_DIVIDE, true>  (legs, tick.leg, fanout.as_first_leg_divide);
+			UpdateSynthetics<hilo::MATH_OP_TIMES,  false> (legs, tick.leg, fanout.as_second_leg_times);
+			UpdateSynthetics<hilo::MATH_OP_DIVIDE, false> (legs, tick.leg, fanout.as_second_leg_divide);
+		}
+		grouped_cycles = __rdtsc() - start;
+	}
+
+	unsigned mismatches = 0;
+	for (unsigned i = 0; i < rule_count; ++i) {
+		if (legacy_rules[i]->is_null != grouped_rules[i]->is_null ||
+		    legacy_rules[i]->high != grouped_rules[i]->high ||
+		    legacy_rules[i]->low != grouped_rules[i]->low)
+		{
+			++mismatches;
+		}
+	}
+
+	printf ("MathOperator lambda   %8.1f cycles/tick\n", static_cast<double> (legacy_cycles) / tick_count);
+	printf ("math_op_t<> groups    %8.1f cycles/tick\n", static_cast<double> (grouped_cycles) / tick_count);
+	printf ("#%u mismatched rules\n", mismatches);
+	return 0 == mismatches ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* eof */
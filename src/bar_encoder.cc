@@ -0,0 +1,107 @@
+/* RDM MarketPrice field list of one bar.
+ */
+
+#include "bar_encoder.hh"
+
+#include <ctime>
+
+#include "chromium/logging.hh"
+#include "bnymellon.hh"
+#include "get_hilo.hh"
+
+/* RDM FIDs. */
+static const int kRdmTimeOfUpdateId	= 5;
+static const int kRdmTodaysHighId	= 12;
+static const int kRdmTodaysLowId	= 13;
+static const int kRdmActiveDateId	= 17;
+
+static inline
+void
+SetReal (
+	rfa::data::DataBuffer*const data,
+	const rfa::data::Real32& value
+	)
+{
+	data->setReal32 (value);
+}
+
+static inline
+void
+SetReal (
+	rfa::data::DataBuffer*const data,
+	const rfa::data::Real64& value
+	)
+{
+	data->setReal64 (value);
+}
+
+hilo::bar_encoder_t::bar_encoder_t() :
+	timact_field_ (false),
+	high_field_ (false),
+	low_field_ (false),
+	activ_date_field_ (false),
+	timact_data_ (false),
+	price_data_ (false),
+	activ_date_data_ (false),
+	end_time_ (-1)
+{
+	timact_field_.setFieldID (kRdmTimeOfUpdateId);
+	high_field_.setFieldID (kRdmTodaysHighId);
+	low_field_.setFieldID (kRdmTodaysLowId);
+	activ_date_field_.setFieldID (kRdmActiveDateId);
+/* HIGH_1, LOW_1 as PRICE field type */
+	real_value_.setMagnitudeType (bnymellon::kMagnitude);
+}
+
+void
+hilo::bar_encoder_t::SetIntervalEnd (
+	__time32_t	end_time
+	)
+{
+	struct tm _tm;
+	_gmtime32_s (&_tm, &end_time);
+/* TIMACT */
+	rfa_time_.setHour   (_tm.tm_hour);
+	rfa_time_.setMinute (_tm.tm_min);
+	rfa_time_.setSecond (_tm.tm_sec);
+	rfa_time_.setMillisecond (0);
+	timact_data_.setTime (rfa_time_);
+	timact_field_.setData (timact_data_);
+/* ACTIV_DATE */
+	rfa_date_.setDay   (/* rfa(1-31) */ _tm.tm_mday        /* tm(1-31) */);
+	rfa_date_.setMonth (/* rfa(1-12) */ 1 + _tm.tm_mon     /* tm(0-11) */);
+	rfa_date_.setYear  (/* rfa(yyyy) */ 1900 + _tm.tm_year /* tm(yyyy-1900 */);
+	activ_date_data_.setDate (rfa_date_);
+	activ_date_field_.setData (activ_date_data_);
+	end_time_ = end_time;
+}
+
+/* PRICE field is a rfa::Real64 value specified as <mantissa> x 10^-6.
+ * Rfa deprecates setting via <double> data types so we publish the mantissa
+ * stored with the bar to 6 decimal places.
+ */
+void
+hilo::bar_encoder_t::Encode (
+	const bar_t&	bar,
+	__time32_t	end_time,
+	rfa::data::FieldList*const fields
+	)
+{
+	CHECK (nullptr != fields);
+	if (end_time != end_time_)
+		SetIntervalEnd (end_time);
+	it_.start (*fields);
+	it_.bind (timact_field_);
+/* HIGH_1 */
+	real_value_.setValue (static_cast<bnymellon::mantissa_t> (bar.high_mantissa));
+	SetReal (&price_data_, real_value_);
+	high_field_.setData (price_data_), it_.bind (high_field_);
+/* LOW_1 */
+	real_value_.setValue (static_cast<bnymellon::mantissa_t> (bar.low_mantissa));
+	SetReal (&price_data_, real_value_);
+	low_field_.setData (price_data_), it_.bind (low_field_);
+	it_.bind (activ_date_field_);
+	it_.complete();
+}
+
+/* eof */
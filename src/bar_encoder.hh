@@ -0,0 +1,54 @@
+/* RDM MarketPrice field list of one bar.
+ *
+ * TIMACT, HIGH_1, LOW_1 and ACTIV_DATE of a bar.  Each encoder holds its own
+ * iterator and field state so encoders on different threads never share RFA
+ * data objects, TIMACT and ACTIV_DATE are only re-encoded when the interval
+ * end time changes.
+ */
+
+#ifndef __BAR_ENCODER_HH__
+#define __BAR_ENCODER_HH__
+#pragma once
+
+#include <cstdint>
+
+/* Boost noncopyable base class. */
+#include <boost/utility.hpp>
+
+/* RFA 7.2 */
+#include <rfa/rfa.hh>
+
+namespace hilo
+{
+	class bar_t;
+
+	class bar_encoder_t : boost::noncopyable
+	{
+	public:
+		bar_encoder_t();
+
+/* fields must have the dictionary and field list identifiers set. */
+		void Encode (const bar_t& bar, __time32_t end_time, rfa::data::FieldList*const fields);
+
+	private:
+		void SetIntervalEnd (__time32_t end_time);
+
+		rfa::data::FieldListWriteIterator it_;
+		rfa::data::FieldEntry timact_field_, high_field_, low_field_, activ_date_field_;
+		rfa::data::DataBuffer timact_data_, price_data_, activ_date_data_;
+#ifdef CONFIG_32BIT_PRICE
+		rfa::data::Real32 real_value_;
+#else
+		rfa::data::Real64 real_value_;
+#endif /* CONFIG_32BIT_PRICE */
+		rfa::data::Time rfa_time_;
+		rfa::data::Date rfa_date_;
+/* end time of the encoded TIMACT and ACTIV_DATE, -1 for none. */
+		__time32_t end_time_;
+	};
+
+} /* namespace hilo */
+
+#endif /* __BAR_ENCODER_HH__ */
+
+/* eof */
@@ -0,0 +1,259 @@
+/* Memory-mapped journal of completed per-interval bars since the last reset.
+ */
+
+#include "bar_journal.hh"
+
+#include <cstring>
+#include <fstream>
+
+#include "chromium/logging.hh"
+#include "rule_plan.hh"
+
+static const char kBarJournalMagic[8] = { 'H', 'I', 'L', 'O', 'B', 'A', 'R', 'S' };
+static const uint32_t kBarJournalVersion = 1;
+
+/* Seconds per day, one session of bars. */
+static const int kSecondsPerDay = 24 * 60 * 60;
+
+hilo::bar_journal_t::bar_journal_t (
+	const std::string& path
+	) :
+	path_ (path),
+	header_ (nullptr),
+	records_ (nullptr)
+{
+}
+
+/* FNV-1a of the canonical rule set, rule order included. */
+uint64_t
+hilo::bar_journal_t::Hash (
+	const std::vector<std::shared_ptr<hilo_t>>& query
+	)
+{
+	const std::string key (rule_plan_t::MakeKey (query));
+	uint64_t hash = UINT64_C(14695981039346656037);
+	for (size_t i = 0; i < key.size(); ++i) {
+		hash ^= static_cast<uint8_t> (key[i]);
+		hash *= UINT64_C(1099511628211);
+	}
+	return hash;
+}
+
+size_t
+hilo::bar_journal_t::Open (
+	__time32_t	reset_time,
+	int		interval_seconds,
+	const std::vector<std::shared_ptr<hilo_t>>& query,
+	size_t		max_bar_count,
+	std::vector<std::vector<bar_t>>* bars
+	)
+{
+	CHECK (interval_seconds > 0);
+	CHECK (nullptr != bars);
+	Close();
+	bars->assign (query.size(), std::vector<bar_t>());
+	const uint64_t rules_hash = Hash (query);
+	if (Map() &&
+	    header_->reset_time == reset_time &&
+	    header_->interval_seconds == interval_seconds &&
+	    header_->rule_count == query.size() &&
+	    header_->rules_hash == rules_hash)
+	{
+/* clock moved backwards, later bars are recalculated */
+		if (header_->bar_count > max_bar_count) {
+			header_->bar_count = max_bar_count;
+			region_.flush (0, sizeof (header_t));
+		}
+		const size_t bar_count = static_cast<size_t> (header_->bar_count);
+		for (size_t rule_index = 0; rule_index < query.size(); ++rule_index) {
+			std::vector<bar_t>& rule_bars = (*bars)[rule_index];
+			rule_bars.resize (bar_count);
+			for (size_t bar_index = 0; bar_index < bar_count; ++bar_index) {
+				const record_t& record = records_[(bar_index * query.size()) + rule_index];
+				bar_t& bar = rule_bars[bar_index];
+				bar.high    = record.high;
+				bar.low     = record.low;
+				bar.is_null = 0 != record.is_null;
+				bar.first.last_bid  = record.first_bid;
+				bar.first.last_ask  = record.first_ask;
+				bar.first.is_null   = 0 != record.first_is_null;
+				bar.second.last_bid = record.second_bid;
+				bar.second.last_ask = record.second_ask;
+				bar.second.is_null  = 0 != record.second_is_null;
+			}
+		}
+		LOG(INFO) << "Reloaded bar journal \"" << path_ << "\" #" << bar_count << " bars.";
+		return bar_count;
+	}
+	Close();
+	if (Create (reset_time, interval_seconds, query.size(), rules_hash) && Map())
+		return 0;
+	Close();
+	return 0;
+}
+
+void
+hilo::bar_journal_t::Close()
+{
+	if (nullptr != header_)
+		region_.flush();
+	boost::interprocess::mapped_region().swap (region_);
+	boost::interprocess::file_mapping().swap (file_);
+	header_  = nullptr;
+	records_ = nullptr;
+}
+
+/* Map an existing journal read-write, false if missing or malformed.
+ */
+bool
+hilo::bar_journal_t::Map()
+{
+	using namespace boost::interprocess;
+	{
+		std::ifstream in (path_.c_str(), std::ios::binary);
+		if (!in)
+			return false;
+	}
+	file_mapping file;
+	mapped_region region;
+	try {
+		file_mapping (path_.c_str(), read_write).swap (file);
+		mapped_region (file, read_write).swap (region);
+	} catch (const interprocess_exception& e) {
+		LOG(WARNING) << "Cannot map bar journal \"" << path_ << "\": " << e.what();
+		return false;
+	}
+	const uint64_t size = region.get_size();
+	if (size < sizeof (header_t)) {
+		LOG(WARNING) << "Bar journal \"" << path_ << "\" truncated.";
+		return false;
+	}
+	header_t* header = static_cast<header_t*> (region.get_address());
+	if (0 != memcmp (header->magic, kBarJournalMagic, sizeof (kBarJournalMagic)) || kBarJournalVersion != header->version) {
+		LOG(WARNING) << "Bar journal \"" << path_ << "\" unknown format.";
+		return false;
+	}
+	if (sizeof (header_t) + (header->capacity * header->rule_count * sizeof (record_t)) > size ||
+	    header->bar_count > header->capacity)
+	{
+		LOG(WARNING) << "Bar journal \"" << path_ << "\" truncated.";
+		return false;
+	}
+	file_.swap (file);
+	region_.swap (region);
+	header_  = static_cast<header_t*> (region_.get_address());
+	records_ = reinterpret_cast<record_t*> (static_cast<char*> (region_.get_address()) + sizeof (header_t));
+	return true;
+}
+
+/* New empty journal for one session of bars.
+ */
+bool
+hilo::bar_journal_t::Create (
+	__time32_t	reset_time,
+	int		interval_seconds,
+	size_t		rule_count,
+	uint64_t	rules_hash
+	)
+{
+	header_t header;
+	memset (&header, 0, sizeof (header));
+	memcpy (header.magic, kBarJournalMagic, sizeof (kBarJournalMagic));
+	header.version          = kBarJournalVersion;
+	header.interval_seconds = interval_seconds;
+	header.reset_time       = reset_time;
+	header.rules_hash       = rules_hash;
+	header.rule_count       = static_cast<uint32_t> (rule_count);
+/* one day of bars, plus one for a reset time not aligned to the interval. */
+	header.capacity         = 1 + (kSecondsPerDay / interval_seconds);
+	header.bar_count        = 0;
+	const uint64_t size = sizeof (header_t) + (header.capacity * rule_count * sizeof (record_t));
+
+	std::ofstream out (path_.c_str(), std::ios::binary | std::ios::trunc);
+	if (!out) {
+		LOG(ERROR) << "Cannot create bar journal \"" << path_ << "\".";
+		return false;
+	}
+	out.write (reinterpret_cast<const char*> (&header), sizeof (header));
+/* zero fill to the full session */
+	if (size > sizeof (header)) {
+		out.seekp (static_cast<std::streamoff> (size - 1));
+		out.put ('\0');
+	}
+	out.close();
+	if (!out) {
+		LOG(ERROR) << "Failed writing bar journal \"" << path_ << "\".";
+		return false;
+	}
+	LOG(INFO) << "Created bar journal \"" << path_ << "\" for #" << header.capacity << " bars of #" << rule_count << " rules.";
+	return true;
+}
+
+bool
+hilo::bar_journal_t::Append (
+	const std::vector<std::vector<bar_t>>& bars,
+	size_t		bar_count
+	)
+{
+	if (nullptr == header_ || 0 == bar_count)
+		return false;
+	const size_t rule_count = header_->rule_count;
+	CHECK (bars.size() == rule_count);
+	if (header_->bar_count + bar_count > header_->capacity) {
+		LOG(WARNING) << "Bar journal \"" << path_ << "\" full at #" << header_->bar_count << " bars.";
+		return false;
+	}
+	Write (static_cast<size_t> (header_->bar_count), bars, bar_count);
+/* records reach the file before the count that exposes them */
+	header_->bar_count += bar_count;
+	region_.flush (0, sizeof (header_t));
+	return true;
+}
+
+bool
+hilo::bar_journal_t::Replace (
+	size_t		first_bar,
+	const std::vector<std::vector<bar_t>>& bars,
+	size_t		bar_count
+	)
+{
+	if (nullptr == header_ || 0 == bar_count)
+		return false;
+	CHECK (bars.size() == header_->rule_count);
+	if (first_bar + bar_count > header_->bar_count)
+		return false;
+	Write (first_bar, bars, bar_count);
+	return true;
+}
+
+/* Records of bar_count bars from first_bar flushed to the file.
+ */
+void
+hilo::bar_journal_t::Write (
+	size_t		first_bar,
+	const std::vector<std::vector<bar_t>>& bars,
+	size_t		bar_count
+	)
+{
+	const size_t rule_count = header_->rule_count;
+	for (size_t bar_index = 0; bar_index < bar_count; ++bar_index) {
+		for (size_t rule_index = 0; rule_index < rule_count; ++rule_index) {
+			const bar_t& bar = bars[rule_index][bar_index];
+			record_t& record = records_[((first_bar + bar_index) * rule_count) + rule_index];
+			memset (&record, 0, sizeof (record));
+			record.high           = bar.high;
+			record.low            = bar.low;
+			record.is_null        = bar.is_null ? 1 : 0;
+			record.first_bid      = bar.first.last_bid;
+			record.first_ask      = bar.first.last_ask;
+			record.first_is_null  = bar.first.is_null ? 1 : 0;
+			record.second_bid     = bar.second.last_bid;
+			record.second_ask     = bar.second.last_ask;
+			record.second_is_null = bar.second.is_null ? 1 : 0;
+		}
+	}
+	const size_t offset = sizeof (header_t) + (first_bar * rule_count * sizeof (record_t));
+	region_.flush (offset, bar_count * rule_count * sizeof (record_t));
+}
+
+/* eof */
@@ -0,0 +1,93 @@
+/* Memory-mapped journal of completed per-interval bars since the last reset.
+ *
+ * Layout, little-endian with every section 8-byte aligned:
+ *
+ *   header_t
+ *   record_t records[capacity][rule_count], bar-major as bar_store_t
+ *
+ * The file is sized for one session when the session starts and records are
+ * appended in place as each timer scan completes, the header bar count is
+ * only advanced once the records are flushed.  A restarted plugin reloads the
+ * bars of a journal written for the same session, interval and rules so only
+ * the intervals since the last append are scanned.
+ */
+
+#ifndef __BAR_JOURNAL_HH__
+#define __BAR_JOURNAL_HH__
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/* Boost memory mapped files. */
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+/* Boost noncopyable base class. */
+#include <boost/utility.hpp>
+
+#include "get_hilo.hh"
+
+namespace hilo
+{
+	class bar_journal_t : boost::noncopyable
+	{
+	public:
+		struct header_t {
+			char magic[8];
+			uint32_t version;
+			int32_t interval_seconds;
+			int64_t reset_time;
+			uint64_t rules_hash;
+			uint32_t rule_count;
+			uint32_t reserved;
+			uint64_t capacity;
+			uint64_t bar_count;
+		};
+
+		struct record_t {
+			double high, low;
+			double first_bid, first_ask;
+			double second_bid, second_ask;
+			uint8_t is_null, first_is_null, second_is_null;
+			uint8_t reserved[5];
+		};
+
+		explicit bar_journal_t (const std::string& path);
+
+/* Reload at most max_bar_count bars indexed [rule][bar] of a journal for the
+ * same session, interval and rules, otherwise start an empty journal.
+ * Returns the number of bars loaded, bars beyond max_bar_count are dropped.
+ */
+		size_t Open (__time32_t reset_time, int interval_seconds, const std::vector<std::shared_ptr<hilo_t>>& query, size_t max_bar_count, std::vector<std::vector<bar_t>>* bars);
+		void Close();
+
+		bool is_open() const {
+			return nullptr != header_;
+		}
+
+/* Append bar_count consecutive bars indexed [rule][bar]. */
+		bool Append (const std::vector<std::vector<bar_t>>& bars, size_t bar_count);
+/* Overwrite bar_count appended bars from first_bar, bars indexed [rule][bar]. */
+		bool Replace (size_t first_bar, const std::vector<std::vector<bar_t>>& bars, size_t bar_count);
+
+	private:
+		void Write (size_t first_bar, const std::vector<std::vector<bar_t>>& bars, size_t bar_count);
+		static uint64_t Hash (const std::vector<std::shared_ptr<hilo_t>>& query);
+		bool Map();
+		bool Create (__time32_t reset_time, int interval_seconds, size_t rule_count, uint64_t rules_hash);
+
+		std::string path_;
+		boost::interprocess::file_mapping file_;
+		boost::interprocess::mapped_region region_;
+		header_t* header_;
+		record_t* records_;
+	};
+
+} /* namespace hilo */
+
+#endif /* __BAR_JOURNAL_HH__ */
+
+/* eof */
@@ -0,0 +1,129 @@
+/* Completed per-interval high-low bars since the last reset.
+ */
+
+#include "bar_store.hh"
+
+#include <algorithm>
+
+#include "chromium/logging.hh"
+#include "bnymellon.hh"
+
+/* Publish mantissas of the bar, converted once when stored unless held by
+ * the fixed-point engine.
+ */
+static inline
+hilo::bar_t
+SetMantissa (
+	hilo::bar_t	bar
+	)
+{
+	if (bar.has_mantissa)
+		return bar;
+	bar.high_mantissa = bnymellon::mantissa (bar.high);
+	bar.low_mantissa  = bnymellon::mantissa (bar.low);
+	bar.has_mantissa  = true;
+	return bar;
+}
+
+/* Seconds per day, capacity hint for one session of bars. */
+static const int kSecondsPerDay = 24 * 60 * 60;
+
+hilo::bar_store_t::bar_store_t() :
+	reset_time_ (0),
+	interval_seconds_ (0),
+	rule_count_ (0),
+	bar_count_ (0)
+{
+}
+
+void
+hilo::bar_store_t::Reset (
+	__time32_t	reset_time,
+	int		interval_seconds,
+	size_t		rule_count
+	)
+{
+	CHECK (interval_seconds > 0);
+	reset_time_       = reset_time;
+	interval_seconds_ = interval_seconds;
+	rule_count_       = rule_count;
+	bar_count_        = 0;
+	bars_.clear();
+/* one day of bars, plus one for a reset time not aligned to the interval. */
+	bars_.reserve ((1 + (kSecondsPerDay / interval_seconds)) * rule_count);
+	DVLOG(1) << "Bar store reset, interval " << interval_seconds << "s, #" << rule_count << " rules.";
+}
+
+void
+hilo::bar_store_t::Clear()
+{
+	reset_time_       = 0;
+	interval_seconds_ = 0;
+	rule_count_       = 0;
+	bar_count_        = 0;
+	bars_.clear();
+}
+
+void
+hilo::bar_store_t::Append (
+	const std::vector<std::shared_ptr<hilo_t>>& query
+	)
+{
+	CHECK (query.size() == rule_count_);
+	std::for_each (query.begin(), query.end(), [this](const std::shared_ptr<hilo_t>& it) {
+		bars_.push_back (SetMantissa (bar_t (*it.get())));
+	});
+	++bar_count_;
+}
+
+void
+hilo::bar_store_t::Append (
+	const std::vector<std::vector<bar_t>>& bars,
+	size_t bar_count
+	)
+{
+	CHECK (bars.size() == rule_count_);
+	for (size_t bar_index = 0; bar_index < bar_count; ++bar_index)
+	{
+		std::for_each (bars.begin(), bars.end(), [&](const std::vector<bar_t>& rule_bars) {
+			CHECK (rule_bars.size() == bar_count);
+			bars_.push_back (SetMantissa (rule_bars[bar_index]));
+		});
+		++bar_count_;
+	}
+}
+
+void
+hilo::bar_store_t::Replace (
+	size_t first_bar,
+	const std::vector<std::vector<bar_t>>& bars,
+	size_t bar_count
+	)
+{
+	CHECK (bars.size() == rule_count_);
+	CHECK (first_bar + bar_count <= bar_count_);
+	for (size_t rule_index = 0; rule_index < rule_count_; ++rule_index)
+	{
+		const std::vector<bar_t>& rule_bars = bars[rule_index];
+		CHECK (rule_bars.size() == bar_count);
+		for (size_t bar_index = 0; bar_index < bar_count; ++bar_index)
+			bars_[((first_bar + bar_index) * rule_count_) + rule_index] = SetMantissa (rule_bars[bar_index]);
+	}
+}
+
+void
+hilo::bar_store_t::Restore (
+	size_t bar_index,
+	const std::vector<std::shared_ptr<hilo_t>>& query
+	) const
+{
+	CHECK (bar_index < bar_count_);
+	CHECK (query.size() == rule_count_);
+	auto bar_it = bars_.begin() + (bar_index * rule_count_);
+	std::for_each (query.begin(), query.end(), [&bar_it](const std::shared_ptr<hilo_t>& it) {
+		bar_it->Restore (it.get());
+		++bar_it;
+	});
+}
+
+/* eof */
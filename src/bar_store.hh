@@ -0,0 +1,87 @@
+/* Completed per-interval high-low bars since the last reset.
+ *
+ * Each timer tick only needs to calculate the newest interval, every earlier
+ * interval is immutable and replayed from this store.
+ */
+
+#ifndef __BAR_STORE_HH__
+#define __BAR_STORE_HH__
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/* Boost noncopyable base class. */
+#include <boost/utility.hpp>
+
+#include "get_hilo.hh"
+
+namespace hilo
+{
+	class bar_store_t : boost::noncopyable
+	{
+	public:
+		bar_store_t();
+
+/* Discard all bars and start a new session at reset_time. */
+		void Reset (__time32_t reset_time, int interval_seconds, size_t rule_count);
+		void Clear();
+
+		__time32_t GetResetTime() const {
+			return reset_time_;
+		}
+		int GetIntervalSeconds() const {
+			return interval_seconds_;
+		}
+		size_t GetRuleCount() const {
+			return rule_count_;
+		}
+/* Number of completed bars held, consecutive from reset time. */
+		size_t GetBarCount() const {
+			return bar_count_;
+		}
+		bool empty() const {
+			return 0 == bar_count_;
+		}
+
+/* Window of the nth bar, [start, end). */
+		__time32_t GetBarStartTime (size_t bar_index) const {
+			return reset_time_ + static_cast<__time32_t> (bar_index * interval_seconds_);
+		}
+		__time32_t GetBarEndTime (size_t bar_index) const {
+			return GetBarStartTime (bar_index + 1);
+		}
+/* End of the last held bar, equal to reset time when empty. */
+		__time32_t GetEndTime() const {
+			return GetBarStartTime (bar_count_);
+		}
+
+/* Save the query result as the next bar, query must be in rule order. */
+		void Append (const std::vector<std::shared_ptr<hilo_t>>& query);
+/* Save bar_count consecutive bars indexed [rule][bar]. */
+		void Append (const std::vector<std::vector<bar_t>>& bars, size_t bar_count);
+/* Overwrite bar_count held bars from first_bar, bars indexed [rule][bar]. */
+		void Replace (size_t first_bar, const std::vector<std::vector<bar_t>>& bars, size_t bar_count);
+/* Load the nth bar into the query. */
+		void Restore (size_t bar_index, const std::vector<std::shared_ptr<hilo_t>>& query) const;
+
+		const bar_t& GetBar (size_t bar_index, size_t rule_index) const {
+			return bars_[(bar_index * rule_count_) + rule_index];
+		}
+
+	private:
+		__time32_t reset_time_;
+		int interval_seconds_;
+		size_t rule_count_;
+		size_t bar_count_;
+
+/* bar-major: all rules for bar #0, then all rules for bar #1, ... */
+		std::vector<bar_t> bars_;
+	};
+
+} /* namespace hilo */
+
+#endif /* __BAR_STORE_HH__ */
+
+/* eof */
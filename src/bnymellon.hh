@@ -8,8 +8,10 @@
 #include <cmath>
 #include <cstdint>
 
-/* RFA 7.2 */
-#include <rfa/rfa.hh>
+/* RFA 7.2, the stand-alone benchmarks build the engines without it. */
+#ifndef CONFIG_WITHOUT_RFA
+#	include <rfa/rfa.hh>
+#endif
 
 namespace bnymellon
 {
@@ -21,11 +23,24 @@ round_half_up (double x)
 	return std::floor (x + 0.5);
 }
 
+/* Integer division rounded towards negative infinity, divisor positive. */
+static inline
+int64_t
+floor_div (int64_t x, int64_t divisor)
+{
+	const int64_t q = x / divisor;
+	return (q * divisor > x) ? q - 1 : q;
+}
+
 #ifdef CONFIG_32BIT_PRICE
 
 /* 32-bit: mantissa of 10E4, 4 decimal places
  */
+#ifndef CONFIG_WITHOUT_RFA
 static const int kMagnitude = rfa::data::ExponentNeg4;
+#endif
+
+typedef int32_t mantissa_t;
 
 static inline
 int32_t
@@ -34,6 +49,13 @@ mantissa (double x)
 	return (int32_t) round_half_up (x * 10000.0);
 }
 
+static inline
+double
+price (int32_t m)
+{
+	return (double) m / 10000.0;
+}
+
 static inline
 double
 round (double x)
@@ -41,11 +63,23 @@ round (double x)
 	return (double) mantissa (x) / 10000.0;
 }
 
+/* product of two mantissas rounded half up as mantissa(), exact in 64 bits. */
+static inline
+int32_t
+multiply (int32_t lhs, int32_t rhs)
+{
+	return (int32_t) floor_div (((int64_t) lhs * rhs) + 5000, 10000);
+}
+
 #else /* CONFIG_32BIT_PRICE */
 
 /* 64-bit: mantissa of 10E6, 6 decimal places
  */
+#ifndef CONFIG_WITHOUT_RFA
 static const int kMagnitude = rfa::data::ExponentNeg6;
+#endif
+
+typedef int64_t mantissa_t;
 
 static inline
 int64_t
@@ -54,6 +88,13 @@ mantissa (double x)
 	return (int64_t) round_half_up (x * 1000000.0);
 }
 
+static inline
+double
+price (int64_t m)
+{
+	return (double) m / 1000000.0;
+}
+
 static inline
 double
 round (double x)
@@ -61,6 +102,19 @@ round (double x)
 	return (double) mantissa (x) / 1000000.0;
 }
 
+/* product of two mantissas rounded half up as mantissa(), lhs is split at the
+ * magnitude so that only the remainder product is carried, exact in 64 bits
+ * for any rhs below 9.2E12.
+ */
+static inline
+int64_t
+multiply (int64_t lhs, int64_t rhs)
+{
+	const int64_t q = floor_div (lhs, 1000000);
+	const int64_t r = lhs - (q * 1000000);
+	return (q * rhs) + floor_div ((r * rhs) + 500000, 1000000);
+}
+
 #endif /* CONFIG_32BIT_PRICE */
 
 } // namespace bnymellon
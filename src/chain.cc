@@ -0,0 +1,59 @@
+/* Marketfeed chain of the historical item streams of one rule.
+ */
+
+#include "chain.hh"
+
+#include <sstream>
+
+#include "chromium/logging.hh"
+
+hilo::chain_t::chain_t (
+	const std::string& symbol_name,
+	const std::vector<std::string>& link_names,
+	size_t		page_size
+	) :
+	link_names_ (link_names),
+	page_size_ (page_size),
+	link_count_ (0)
+{
+	CHECK (page_size_ > 0);
+	const size_t page_count = link_names_.empty() ? 1 : ((link_names_.size() - 1) / page_size_) + 1;
+	pages_.resize (page_count);
+	for (size_t i = 0; i < page_count; ++i) {
+		std::ostringstream ss;
+		ss << i
+		   << '#'
+		   << symbol_name;
+		pages_[i].name = ss.str();
+	}
+}
+
+void
+hilo::chain_t::SetLinkCount (
+	size_t		link_count
+	)
+{
+	if (link_count > link_names_.size())
+		link_count = link_names_.size();
+	if (link_count == link_count_)
+		return;
+/* growing changes the old tail and every page after it, a new day all */
+	const size_t first_page = (link_count > link_count_) ? GetTailPage() : 0;
+	link_count_ = link_count;
+	const size_t last_page = GetTailPage();
+	for (size_t i = first_page; i <= last_page; ++i)
+		pages_[i].is_dirty = true;
+}
+
+size_t
+hilo::chain_t::GetLinkCount (
+	size_t		page
+	) const
+{
+	const size_t first_link = page * page_size_;
+	if (first_link >= link_count_)
+		return 0;
+	return (link_count_ - first_link) < page_size_ ? (link_count_ - first_link) : page_size_;
+}
+
+/* eof */
@@ -0,0 +1,72 @@
+/* Marketfeed chain of the historical item streams of one rule.
+ *
+ * Link names of the whole day and the page names, e.g. 0#.DJI .. 6#.DJI, are
+ * formatted once at start-up.  Each refresh sets the count of published links
+ * and only the pages whose fields changed are marked dirty: the tail page
+ * gaining a link, the page before a new page gaining its next link, and every
+ * page when the chain restarts at the reset time.
+ */
+
+#ifndef __CHAIN_HH__
+#define __CHAIN_HH__
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/* Boost noncopyable base class. */
+#include <boost/utility.hpp>
+
+namespace hilo
+{
+	class item_stream_t;
+
+	class chain_page_t
+	{
+	public:
+		chain_page_t() : is_dirty (true) {}
+
+		std::string name;
+		std::shared_ptr<item_stream_t> stream;
+/* fields changed since the page was last published. */
+		bool is_dirty;
+	};
+
+	class chain_t : boost::noncopyable
+	{
+	public:
+		chain_t (const std::string& symbol_name, const std::vector<std::string>& link_names, size_t page_size);
+
+/* Published links, marking every page whose fields change. */
+		void SetLinkCount (size_t link_count);
+
+		size_t GetPageCount() const {
+			return pages_.size();
+		}
+		chain_page_t& GetPage (size_t page) {
+			return pages_[page];
+		}
+/* last page holding a published link, or the first page of an empty chain. */
+		size_t GetTailPage() const {
+			return link_count_ > 0 ? (link_count_ - 1) / page_size_ : 0;
+		}
+/* published links of a page, zero after the tail page. */
+		size_t GetLinkCount (size_t page) const;
+		const std::string& GetLinkName (size_t page, size_t link) const {
+			return link_names_[(page * page_size_) + link];
+		}
+
+	private:
+		std::vector<std::string> link_names_;
+		size_t page_size_;
+		size_t link_count_;
+		std::vector<chain_page_t> pages_;
+	};
+
+} /* namespace hilo */
+
+#endif /* __CHAIN_HH__ */
+
+/* eof */
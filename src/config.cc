@@ -3,7 +3,10 @@
 
 #include "config.hh"
 
+#include <limits>
+
 #include "chromium/logging.hh"
+#include "get_hilo.hh"
 
 hilo::config_t::config_t() :
 /* default values */
@@ -89,6 +92,60 @@ hilo::config_t::Validate()
 		LOG(ERROR) << "Undefined FX currency cross rules.";
 		return false;
 	}
+	int engine_id;
+	if (!ParseEngine (engine, &engine_id)) {
+		LOG(ERROR) << "Invalid engine \"" << engine << "\".";
+		return false;
+	}
+	size_t value;
+	if (!ParseNonNegative ("shards", shards, 1, &value) ||
+	    !ParseNonNegative ("encode threads", encode_threads, 1, &value) ||
+	    !ParseNonNegative ("chunk symbols", chunk_symbols, 0, &value) ||
+	    !ParseNonNegative ("tick cache size", tick_cache, 0, &value) ||
+	    !ParseNonNegative ("result cache size", result_cache, 0, &value) ||
+	    !ParseNonNegative ("late window", late_window, 0, &value) ||
+	    !ParseNonNegative ("refresh interval", refresh_interval, 0, &value))
+	{
+		return false;
+	}
+	if (!historical_publish.empty() && 0 != historical_publish.compare ("all") && 0 != historical_publish.compare ("once")) {
+		LOG(ERROR) << "Invalid historical publish \"" << historical_publish << "\".";
+		return false;
+	}
+	if (!feed.empty() && 0 != feed.compare ("flexrec")) {
+		LOG(ERROR) << "Invalid feed \"" << feed << "\".";
+		return false;
+	}
+	return true;
+}
+
+bool
+hilo::ParseNonNegative (
+	const char*		name,
+	const std::string&	text,
+	size_t			min,
+	size_t*			value
+	)
+{
+	if (text.empty())
+		return true;
+/* std::stoul accepts a sign and trailing text, digits only. */
+	if (std::string::npos != text.find_first_not_of ("0123456789") ||
+	    text.size() > 10)
+	{
+		LOG(ERROR) << "Invalid " << name << " \"" << text << "\".";
+		return false;
+	}
+	const unsigned long long parsed = std::stoull (text);
+	if (parsed > static_cast<unsigned long long> (std::numeric_limits<int>::max())) {
+		LOG(ERROR) << "Invalid " << name << " \"" << text << "\", out of range.";
+		return false;
+	}
+	if (parsed < min) {
+		LOG(ERROR) << "Invalid " << name << " \"" << text << "\", expecting " << min << " or more.";
+		return false;
+	}
+	*value = static_cast<size_t> (parsed);
 	return true;
 }
 
@@ -522,6 +579,50 @@ hilo::config_t::ParseCrossesNode (
 	attr = xml.transcode (elem->getAttribute (L"suffix"));
 	if (!attr.empty())
 		suffix = attr;
+/* engine="single_iterator|vectorized|fixed_point" */
+	attr = xml.transcode (elem->getAttribute (L"engine"));
+	if (!attr.empty())
+		engine = attr;
+/* shards="count" */
+	attr = xml.transcode (elem->getAttribute (L"shards"));
+	if (!attr.empty())
+		shards = attr;
+/* chunkSymbols="count" */
+	attr = xml.transcode (elem->getAttribute (L"chunkSymbols"));
+	if (!attr.empty())
+		chunk_symbols = attr;
+/* encodeThreads="count" */
+	attr = xml.transcode (elem->getAttribute (L"encodeThreads"));
+	if (!attr.empty())
+		encode_threads = attr;
+/* tickCache="megabytes" */
+	attr = xml.transcode (elem->getAttribute (L"tickCache"));
+	if (!attr.empty())
+		tick_cache = attr;
+/* resultCache="entries" */
+	attr = xml.transcode (elem->getAttribute (L"resultCache"));
+	if (!attr.empty())
+		result_cache = attr;
+/* journal="path" */
+	attr = xml.transcode (elem->getAttribute (L"journal"));
+	if (!attr.empty())
+		journal = attr;
+/* lateWindow="seconds" */
+	attr = xml.transcode (elem->getAttribute (L"lateWindow"));
+	if (!attr.empty())
+		late_window = attr;
+/* refreshInterval="seconds" */
+	attr = xml.transcode (elem->getAttribute (L"refreshInterval"));
+	if (!attr.empty())
+		refresh_interval = attr;
+/* historicalPublish="all|once" */
+	attr = xml.transcode (elem->getAttribute (L"historicalPublish"));
+	if (!attr.empty())
+		historical_publish = attr;
+/* feed="flexrec" */
+	attr = xml.transcode (elem->getAttribute (L"feed"));
+	if (!attr.empty())
+		feed = attr;
 
 /* reset all rules */
 	rules.clear();
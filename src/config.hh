@@ -132,10 +132,49 @@ namespace hilo
 //  FX symbol name suffix for every publish.
 		std::string suffix;
 
+//  FX High-Low calculation engine: single_iterator (default), vectorized, or fixed_point.
+		std::string engine;
+
+//  Parallel cursor shards over independent symbol groups, default 1 for serial.
+		std::string shards;
+
+//  Maximum symbols per cursor, default 0 for one cursor per shard.
+		std::string chunk_symbols;
+
+//  Threads encoding published messages, default 1 to encode on the timer thread.
+		std::string encode_threads;
+
+//  Intraday tick cache size in megabytes, default 0 for none.
+		std::string tick_cache;
+
+//  Window query results held for hilo_query, default 0 for none.
+		std::string result_cache;
+
+//  Completed bar journal file reloaded on restart, default none.
+		std::string journal;
+
+//  Seconds of closed intervals re-checked for late ticks each refresh, default 0 for none.
+//  Every refresh re-reads every tick of the window from the tick store, cost grows with the window length.
+		std::string late_window;
+
+//  Seconds between full refreshes of an item when publishing updates of changed items, default 0 to always refresh.
+		std::string refresh_interval;
+
+//  Historical bar publishing: all to republish every bar since reset each interval, once to send each bar when it closes and on re-login or hilo_republish, default all.
+		std::string historical_publish;
+
+//  Live tick feed for the streaming engine: flexrec, default none to scan each interval.
+		std::string feed;
+
 //  FX currency cross rules.
 		std::vector<std::string> rules;
 	};
 
+/* Parse a decimal count setting of at least min and at most INT_MAX, empty
+ * text leaves value at its default.  Logs and returns false when invalid.
+ */
+	bool ParseNonNegative (const char* name, const std::string& text, size_t min, size_t* value);
+
 	inline
 	std::ostream& operator<< (std::ostream& o, const session_config_t& session) {
 		o << "{ "
@@ -187,6 +226,17 @@ namespace hilo
 			", \"tolerable_delay\": \"" << config.tolerable_delay << "\""
 			", \"reset_time\": \"" << config.reset_time << "\""
 			", \"suffix\": \"" << config.suffix << "\""
+			", \"engine\": \"" << config.engine << "\""
+			", \"shards\": \"" << config.shards << "\""
+			", \"chunk_symbols\": \"" << config.chunk_symbols << "\""
+			", \"encode_threads\": \"" << config.encode_threads << "\""
+			", \"tick_cache\": \"" << config.tick_cache << "\""
+			", \"result_cache\": \"" << config.result_cache << "\""
+			", \"journal\": \"" << config.journal << "\""
+			", \"late_window\": \"" << config.late_window << "\""
+			", \"refresh_interval\": \"" << config.refresh_interval << "\""
+			", \"historical_publish\": \"" << config.historical_publish << "\""
+			", \"feed\": \"" << config.feed << "\""
 			", \"rules\": [ ";
 		for (auto it = config.rules.begin();
 			it != config.rules.end();
@@ -0,0 +1,112 @@
+/* Velocity Analytics FlexRecReader tick source.
+ */
+
+#include "flexrec_source.hh"
+
+#include <algorithm>
+
+#include "chromium/logging.hh"
+
+/* FlexRecord Quote identifier. */
+static const uint32_t kQuoteId = 40002;
+
+/* FlexRecReader::Open status, 1 for an open cursor and 0 when the first
+ * symbol of the set has no ticks in the window, any other status is a store
+ * failure.
+ */
+static const int kCursorOpen = 1;
+static const int kCursorFirstSymbolEmpty = 0;
+
+hilo::flexrec_source_t::flexrec_source_t()
+{
+}
+
+/* Open a forward cursor on the symbol set binding every field by name to its
+ * value slot.  A set without ticks in the window opens with no reader, a
+ * store failure or exception fails so the caller can retry or isolate.
+ */
+bool
+hilo::flexrec_source_t::Open (
+	std::set<std::string>& symbol_set,
+	const std::unordered_map<std::string, size_t>& field_map,
+	std::vector<double>*const fields,
+	__time32_t	from,
+	__time32_t	till
+	)
+{
+	std::set<FlexRecBinding> binding_set;
+	FlexRecBinding binding (kQuoteId);
+
+/* copy finalized bindings into new set */
+	std::for_each (field_map.begin(), field_map.end(), [&](const std::pair<const std::string, size_t>& field_pair) {
+		binding.Bind (field_pair.first.c_str(), &(*fields)[field_pair.second]);
+	});
+	binding_set.insert (binding);
+
+	symbol_set_ = symbol_set;
+	fr_.reset();
+	try {
+		while (!symbol_set_.empty()) {
+			std::unique_ptr<FlexRecReader> fr (new FlexRecReader());
+			char error_text[1024];
+			const int cursor_status = fr->Open (symbol_set_, binding_set, from, till, 0 /* forward */, 0 /* no limit */, error_text);
+			if (kCursorOpen == cursor_status) {
+				fr_.swap (fr);
+				break;
+			}
+			if (kCursorFirstSymbolEmpty != cursor_status) {
+				LOG(ERROR) << "FlexRecReader::Open failed { \"code\": " << cursor_status
+					<< ", \"text\": \"" << error_text << "\" }";
+				return false;
+			}
+/* first symbol without ticks */
+			DVLOG(2) << "FlexRecReader::Open without \"" << *symbol_set_.begin() << "\" { \"code\": " << cursor_status
+				<< ", \"text\": \"" << error_text << "\" }";
+			symbol_set_.erase (symbol_set_.begin());
+		}
+	} catch (std::exception& e) {
+		LOG(ERROR) << "FlexRecReader::Open raised exception " << e.what();
+		return false;
+	}
+	return true;
+}
+
+bool
+hilo::flexrec_source_t::Next()
+{
+	return (bool)fr_ && fr_->Next();
+}
+
+const char*
+hilo::flexrec_source_t::GetCurrentSymbolName()
+{
+	return fr_->GetCurrentSymbolName();
+}
+
+/* Server receipt time of the current cursor record in Unix Epoch seconds.
+ */
+__time32_t
+hilo::flexrec_source_t::GetCurrentTime32()
+{
+	VHTime vhtime = fr_->GetCurrentTimeStamp();
+	__time32_t timestamp;
+	VHTimeProcessor::VHToTTTime (&vhtime, &timestamp);
+	return timestamp;
+}
+
+void
+hilo::flexrec_source_t::Close()
+{
+	if ((bool)fr_) {
+		fr_->Close();
+		fr_.reset();
+	}
+}
+
+std::unique_ptr<hilo::tick_source_t>
+hilo::flexrec_source_factory_t::Create() const
+{
+	return std::unique_ptr<tick_source_t> (new flexrec_source_t());
+}
+
+/* eof */
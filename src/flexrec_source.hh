@@ -0,0 +1,49 @@
+/* Velocity Analytics FlexRecReader tick source.
+ */
+
+#ifndef __FLEXREC_SOURCE_HH__
+#define __FLEXREC_SOURCE_HH__
+#pragma once
+
+#include "tick_source.hh"
+
+/* Velocity Analytics Plugin Framework */
+#include <vpf/vpf.h>
+#include <FlexRecReader.h>
+
+namespace hilo
+{
+/* A new reader is required per window as FlexRecReader caches the last
+ * binding set.  FlexRecReader fails to open when the first symbol of the set
+ * has no ticks in the window, each attempt re-opens a new reader without it so
+ * a window without any ticks opens as an empty cursor.  Any other failure
+ * fails Open.
+ */
+	class flexrec_source_t : public tick_source_t
+	{
+	public:
+		flexrec_source_t();
+
+		virtual bool Open (std::set<std::string>& symbol_set, const std::unordered_map<std::string, size_t>& field_map, std::vector<double>*const fields, __time32_t from, __time32_t till) override;
+		virtual bool Next() override;
+		virtual const char* GetCurrentSymbolName() override;
+		virtual __time32_t GetCurrentTime32() override;
+		virtual void Close() override;
+
+	private:
+/* symbols of the open reader, quiet leading symbols removed. */
+		std::set<std::string> symbol_set_;
+		std::unique_ptr<FlexRecReader> fr_;
+	};
+
+	class flexrec_source_factory_t : public tick_source_factory_t
+	{
+	public:
+		virtual std::unique_ptr<tick_source_t> Create() const override;
+	};
+
+} /* namespace hilo */
+
+#endif /* __FLEXREC_SOURCE_HH__ */
+
+/* eof */
@@ -3,20 +3,21 @@
 
 #include "get_hilo.hh"
 
+#include <algorithm>
 #include <cstdint>
-#include <forward_list>
 #include <functional>
 #include <list>
 #include <unordered_map>
 
-/* Velocity Analytics Plugin Framework */
-#include <vpf/vpf.h>
-#include <FlexRecReader.h>
-
 #include "chromium/logging.hh"
-
-/* FlexRecord Quote identifier. */
-static const uint32_t kQuoteId = 40002;
+#include "bnymellon.hh"
+#include "math_op.hh"
+#include "minmax_kernel.hh"
+#include "rule_plan.hh"
+#include "symbol_table.hh"
+#include "thread_pool.hh"
+#include "tick_cache.hh"
+#include "tick_source.hh"
 
 /*  IN: hilo populated with symbol names.
  * OUT: hilo populated with high-low values from start to end.
@@ -26,16 +27,147 @@ static const uint32_t kQuoteId = 40002;
  */
 
 namespace hilo {
+
+/* Cursor of the configured tick source, the registered default otherwise.
+ */
+static
+std::unique_ptr<tick_source_t>
+CreateSource (
+	const scan_options_t& options
+	)
+{
+	const tick_source_factory_t* factory = (nullptr != options.source) ? options.source : GetDefaultTickSourceFactory();
+	CHECK (nullptr != factory) << "No tick source registered.";
+	return factory->Create();
+}
 
 /* Reference implementation walking through each symbol.
  */
 
 namespace reference {
+
+/* Synthetic scan of one rule over an open cursor, specialized by operator and
+ * whether the second leg binds its own bid and ask fields.
+ */
+template <int MathOp, bool HaveAltBid, bool HaveAltAsk>
+static
+void
+ScanSynthetic (
+	tick_source_t&	fr,
+	hilo_t*const	it,
+	const double&	bid_price,
+	const double&	ask_price,
+	const double&	alt_bid_price,
+	const double&	alt_ask_price
+	)
+{
+/* does this analytic update the query state */
+	bool is_updated = false;
+
+	DLOG(INFO) << it->name 
+		<< " 1st: bid=" << it->legs.first.bid_field
+		<<      " ask=" << it->legs.first.ask_field
+		<< " 2nd: bid=" << it->legs.second.bid_field
+		<<      " ask=" << it->legs.second.ask_field;
+
+	double first_leg_bid_price  = it->legs.first.last_bid,
+	       first_leg_ask_price  = it->legs.first.last_ask,
+	       second_leg_bid_price = it->legs.second.last_bid,
+	       second_leg_ask_price = it->legs.second.last_ask;
+
+	if (it->legs.first.is_null &&
+	    it->legs.second.is_null &&
+	    fr.Next())
+	{
+/* find first value for both legs */
+		if (fr.GetCurrentSymbolName() == it->legs.first.symbol_name)
+		{
+			it->legs.first.is_null = false;
+			do {
+				first_leg_bid_price = bid_price;
+				first_leg_ask_price = ask_price;
+			} while (fr.Next() && fr.GetCurrentSymbolName() == it->legs.first.symbol_name);
+/* follow */
+			if (fr.GetCurrentSymbolName() == it->legs.second.symbol_name) {
+				is_updated = true;
+				second_leg_bid_price = HaveAltBid ? alt_bid_price : bid_price;
+				second_leg_ask_price = HaveAltAsk ? alt_ask_price : ask_price;
+				it->low  = math_op_t<MathOp>::Apply (first_leg_bid_price, second_leg_bid_price);
+				it->high = math_op_t<MathOp>::Apply (first_leg_ask_price, second_leg_ask_price);
+				DLOG(INFO) << it->name << " start low=" << it->low << " high=" << it->high;
+				DLOG(INFO) << fr.GetCurrentSymbolName() << " bid " << bid_price << " alt-bid " << alt_bid_price << " ask " << ask_price << " alt-ask " << alt_ask_price;
+			}
+		}
+		else
+		{
+			it->legs.second.is_null = false;
+			do {
+				DLOG(INFO) << fr.GetCurrentSymbolName() << " bid " << bid_price << " alt-bid " << alt_bid_price << " ask " << ask_price << " alt-ask " << alt_ask_price;
+				second_leg_bid_price = HaveAltBid ? alt_bid_price : bid_price;
+				second_leg_ask_price = HaveAltAsk ? alt_ask_price : ask_price;
+			} while (fr.Next() && fr.GetCurrentSymbolName() == it->legs.second.symbol_name);
+/* follow */
+			if (fr.GetCurrentSymbolName() == it->legs.first.symbol_name) {
+				is_updated = true;
+				first_leg_bid_price = bid_price;
+				first_leg_ask_price = ask_price;
+				it->low  = math_op_t<MathOp>::Apply (first_leg_bid_price, second_leg_bid_price);
+				it->high = math_op_t<MathOp>::Apply (first_leg_ask_price, second_leg_ask_price);
+				DLOG(INFO) << it->name << " start low=" << it->low << " high=" << it->high;
+			}
+		}
+	}
+
+/* till end */
+	while (fr.Next())
+	{
+		is_updated = true;
+
+		if (fr.GetCurrentSymbolName() == it->legs.first.symbol_name) {
+			first_leg_bid_price = bid_price;
+			first_leg_ask_price = ask_price;
+		} else {
+			second_leg_bid_price = HaveAltBid ? alt_bid_price : bid_price;
+			second_leg_ask_price = HaveAltAsk ? alt_ask_price : ask_price;
+		}
+	
+		const double synthetic_bid_price = math_op_t<MathOp>::Apply (first_leg_bid_price, second_leg_bid_price),
+			     synthetic_ask_price = math_op_t<MathOp>::Apply (first_leg_ask_price, second_leg_ask_price);
+		if (synthetic_bid_price < it->low) {
+			it->low  = synthetic_bid_price;
+			DLOG(INFO) << it->name << " new low=" << it->low;
+		}
+		if (synthetic_ask_price > it->high) {
+			it->high = synthetic_ask_price;
+			DLOG(INFO) << it->name << " new high=" << it->high;
+		}
+	}
+
+	if (is_updated) {
+		it->legs.first.is_null = it->legs.second.is_null = false;
+		it->legs.first.last_bid = first_leg_bid_price;
+		it->legs.first.last_ask = first_leg_ask_price;
+		it->legs.second.last_bid = second_leg_bid_price;
+		it->legs.second.last_ask = second_leg_ask_price;
+	}
+}
+
+typedef void (*scan_synthetic_t) (tick_source_t&, hilo_t*const, const double&, const double&, const double&, const double&);
+
+/* [MATH_OP_DIVIDE group][HaveAltBid][HaveAltAsk] */
+static const scan_synthetic_t kScanSynthetic[2][2][2] = {
+	{ { &ScanSynthetic<MATH_OP_TIMES, false, false>,  &ScanSynthetic<MATH_OP_TIMES, false, true> },
+	  { &ScanSynthetic<MATH_OP_TIMES, true, false>,   &ScanSynthetic<MATH_OP_TIMES, true, true> } },
+	{ { &ScanSynthetic<MATH_OP_DIVIDE, false, false>, &ScanSynthetic<MATH_OP_DIVIDE, false, true> },
+	  { &ScanSynthetic<MATH_OP_DIVIDE, true, false>,  &ScanSynthetic<MATH_OP_DIVIDE, true, true> } }
+};
+
 void
 get_hilo (
 	const std::vector<std::shared_ptr<hilo_t>>& query,
 	__time32_t	from,		/* legacy from before 2003, yay. */
-	__time32_t	till
+	__time32_t	till,
+	const scan_options_t& options
 	)
 {
 // BUG: FlexRecReader caches last cursor binding_set, create new reader per iteration.
@@ -45,146 +177,53 @@ get_hilo (
 
 	std::for_each (query.begin(), query.end(), [&](const std::shared_ptr<hilo_t>& it)
 	{
-		FlexRecReader fr;
-		std::set<FlexRecBinding> binding_set;
-		FlexRecBinding binding (kQuoteId);
-		double bid_price, ask_price, alt_bid_price, alt_ask_price;
+		it->has_mantissa = false;
+		std::unique_ptr<tick_source_t> source (CreateSource (options));
+		tick_source_t& fr = *source.get();
+		std::unordered_map<std::string, size_t> field_map;
+		std::vector<double> fields;
 		bool have_alt_bid_price = false, have_alt_ask_price = false;
+		auto BindField = [&](const std::string& name) -> size_t {
+			auto field_it = field_map.find (name);
+			if (field_map.end() != field_it)
+				return field_it->second;
+			field_map.emplace (std::make_pair (name, fields.size()));
+			fields.push_back (0.0);
+			return fields.size() - 1;
+		};
 
 /* source instruments */
 		std::set<std::string> symbol_set;
 		symbol_set.insert (it->legs.first.symbol_name);
-		binding.Bind (it->legs.first.bid_field.c_str(), &bid_price);
-		binding.Bind (it->legs.first.ask_field.c_str(), &ask_price);
+		const size_t bid_idx = BindField (it->legs.first.bid_field);
+		const size_t ask_idx = BindField (it->legs.first.ask_field);
+		size_t alt_bid_idx = bid_idx, alt_ask_idx = ask_idx;
 
 		if (it->is_synthetic) {
 			symbol_set.insert (it->legs.second.symbol_name);
 			if (it->legs.first.bid_field != it->legs.second.bid_field) {
-				binding.Bind (it->legs.second.bid_field.c_str(), &alt_bid_price);
+				alt_bid_idx = BindField (it->legs.second.bid_field);
 				have_alt_bid_price = true;
 			}
 			if (it->legs.first.ask_field != it->legs.second.ask_field) {
-				binding.Bind (it->legs.second.ask_field.c_str(), &alt_ask_price);
+				alt_ask_idx = BindField (it->legs.second.ask_field);
 				have_alt_ask_price = true;
 			}
 		}
 
-		binding_set.insert (binding);
-
-/* lambda to function pointer is incomplete in MSVC2010, punt to the compiler to clean up. */
-		auto MathOperator = [&it](double a, double b) -> double {
-			if (MATH_OP_TIMES == it->math_op)
-				return (double)(a * b);
-			else if (b == 0.0)
-				return b;
-			else
-				return (double)(a / b);
-		};
-
 /* does this analytic update the query state */
 		bool is_updated = false;
 
-		try {
-			char error_text[1024];
-			const int cursor_status = fr.Open (symbol_set, binding_set, from, till, 0 /* forward */, 0 /* no limit */, error_text);
-			if (1 != cursor_status) {
-				LOG(ERROR) << "FlexRecReader::Open failed { \"code\": " << cursor_status
-					<< ", \"text\": \"" << error_text << "\" }";
-				return;
-			}
-		} catch (const std::exception& e) {
-			LOG(ERROR) << "FlexRecReader::Open raised exception " << e.what();
+		if (!fr.Open (symbol_set, field_map, &fields, from, till))
 			return;
-		}
+/* slots are fixed once the cursor is open */
+		const double &bid_price = fields[bid_idx], &ask_price = fields[ask_idx];
+		const double &alt_bid_price = fields[alt_bid_idx], &alt_ask_price = fields[alt_ask_idx];
 
 		if (it->is_synthetic)
 		{
-			DLOG(INFO) << it->name 
-				<< " 1st: bid=" << it->legs.first.bid_field
-				<<      " ask=" << it->legs.first.ask_field
-				<< " 2nd: bid=" << it->legs.second.bid_field
-				<<      " ask=" << it->legs.second.ask_field;
-
-			double first_leg_bid_price  = it->legs.first.last_bid,
-			       first_leg_ask_price  = it->legs.first.last_ask,
-			       second_leg_bid_price = it->legs.second.last_bid,
-			       second_leg_ask_price = it->legs.second.last_ask;
-
-			if (it->legs.first.is_null &&
-			    it->legs.second.is_null &&
-			    fr.Next())
-			{
-/* find first value for both legs */
-				if (fr.GetCurrentSymbolName() == it->legs.first.symbol_name)
-				{
-					it->legs.first.is_null = false;
-					do {
-						first_leg_bid_price = bid_price;
-						first_leg_ask_price = ask_price;
-					} while (fr.Next() && fr.GetCurrentSymbolName() == it->legs.first.symbol_name);
-/* follow */
-					if (fr.GetCurrentSymbolName() == it->legs.second.symbol_name) {
-						is_updated = true;
-						second_leg_bid_price = have_alt_bid_price ? alt_bid_price : bid_price;
-						second_leg_ask_price = have_alt_ask_price ? alt_ask_price : ask_price;
-						it->low  = MathOperator (first_leg_bid_price, second_leg_bid_price);
-						it->high = MathOperator (first_leg_ask_price, second_leg_ask_price);
-						DLOG(INFO) << it->name << " start low=" << it->low << " high=" << it->high;
-						DLOG(INFO) << fr.GetCurrentSymbolName() << " bid " << bid_price << " alt-bid " << alt_bid_price << " ask " << ask_price << " alt-ask " << alt_ask_price;
-					}
-				}
-				else
-				{
-					it->legs.second.is_null = false;
-					do {
-						DLOG(INFO) << fr.GetCurrentSymbolName() << " bid " << bid_price << " alt-bid " << alt_bid_price << " ask " << ask_price << " alt-ask " << alt_ask_price;
-						second_leg_bid_price = have_alt_bid_price ? alt_bid_price : bid_price;
-						second_leg_ask_price = have_alt_ask_price ? alt_ask_price : ask_price;
-					} while (fr.Next() && fr.GetCurrentSymbolName() == it->legs.second.symbol_name);
-/* follow */
-					if (fr.GetCurrentSymbolName() == it->legs.first.symbol_name) {
-						is_updated = true;
-						first_leg_bid_price = bid_price;
-						first_leg_ask_price = ask_price;
-						it->low  = MathOperator (first_leg_bid_price, second_leg_bid_price);
-						it->high = MathOperator (first_leg_ask_price, second_leg_ask_price);
-						DLOG(INFO) << it->name << " start low=" << it->low << " high=" << it->high;
-					}
-				}
-			}
-
-/* till end */
-			while (fr.Next())
-			{
-				is_updated = true;
-
-				if (fr.GetCurrentSymbolName() == it->legs.first.symbol_name) {
-					first_leg_bid_price = bid_price;
-					first_leg_ask_price = ask_price;
-				} else {
-					second_leg_bid_price = have_alt_bid_price ? alt_bid_price : bid_price;
-					second_leg_ask_price = have_alt_ask_price ? alt_ask_price : ask_price;
-				}
-			
-				const double synthetic_bid_price = MathOperator (first_leg_bid_price, second_leg_bid_price),
-					     synthetic_ask_price = MathOperator (first_leg_ask_price, second_leg_ask_price);
-				if (synthetic_bid_price < it->low) {
-					it->low  = synthetic_bid_price;
-					DLOG(INFO) << it->name << " new low=" << it->low;
-				}
-				if (synthetic_ask_price > it->high) {
-					it->high = synthetic_ask_price;
-					DLOG(INFO) << it->name << " new high=" << it->high;
-				}
-			}
-
-			if (is_updated) {
-				it->legs.first.is_null = it->legs.second.is_null = false;
-				it->legs.first.last_bid = first_leg_bid_price;
-				it->legs.first.last_ask = first_leg_ask_price;
-				it->legs.second.last_bid = second_leg_bid_price;
-				it->legs.second.last_ask = second_leg_ask_price;
-			}
+			const scan_synthetic_t scan = kScanSynthetic[MATH_OP_TIMES == GetSyntheticOp (*it.get()) ? 0 : 1][have_alt_bid_price ? 1 : 0][have_alt_ask_price ? 1 : 0];
+			scan (fr, it.get(), bid_price, ask_price, alt_bid_price, alt_ask_price);
 		}
 		else
 /* non-synthetic */
@@ -226,233 +265,2019 @@ get_hilo (
 }
 
 } // namespace reference
-
-/* Single iterator implementation.
- */
-namespace single_iterator {
-class symbol_t : boost::noncopyable
+
+/* Tick source with the cursor interface of tick_cache_t::reader_t, every
+ * record of a completed scan is appended to the cache when recording.
+ */
+class source_cursor_t : boost::noncopyable
 {
 public:
-	symbol_t() :
-		is_null (true)
+	explicit source_cursor_t (const scan_options_t& options) :
+		source_ (CreateSource (options)),
+		timestamp_ (0),
+		is_timestamp_ (false),
+		is_complete_ (false)
 	{
+		if (nullptr != options.cache && options.is_record)
+			writer_.reset (new tick_cache_t::writer_t (options.cache, options.stream));
 	}
 
-	symbol_t (bool is_null_) :
-		is_null (is_null_)
-	{
+	bool Open (std::set<std::string>& symbol_set, const std::unordered_map<std::string, size_t>& field_map, std::vector<double>*const fields, __time32_t from, __time32_t till) {
+		if ((bool)writer_)
+			writer_->Open (symbol_set, field_map, fields, from, till);
+		return source_->Open (symbol_set, field_map, fields, from, till);
+	}
+	bool Next() {
+		is_timestamp_ = false;
+		if (!source_->Next()) {
+			is_complete_ = true;
+			return false;
+		}
+		if ((bool)writer_)
+			writer_->Append (source_->GetCurrentSymbolName(), GetCurrentTime32());
+		return true;
+	}
+	const char* GetCurrentSymbolName() {
+		return source_->GetCurrentSymbolName();
+	}
+	__time32_t GetCurrentTime32() {
+		if (!is_timestamp_) {
+			timestamp_ = source_->GetCurrentTime32();
+			is_timestamp_ = true;
+		}
+		return timestamp_;
 	}
+/* only a scan read to the end is recorded. */
+	void Close() {
+		source_->Close();
+		if ((bool)writer_ && is_complete_)
+			writer_->Commit();
+	}
+
+private:
+	std::unique_ptr<tick_source_t> source_;
+	std::unique_ptr<tick_cache_t::writer_t> writer_;
+	__time32_t timestamp_;
+	bool is_timestamp_;
+	bool is_complete_;
+};
+
+/* Cursor drivers shared by the single cursor engines, Query implements:
+ *
+ *   explicit Query (const std::vector<std::shared_ptr<hilo_t>>& query);
+ *   template <class Cursor> bool Open (Cursor* cursor, __time32_t from, __time32_t till);
+ *   void OnTick (const char* symbol_name);
+ *   void ClearRules();
+ *   void ClearLegs();
+ *   void Save (size_t rule_index);
+ *   void Save();
+ */
+namespace {
 
-	void SetLastValue (size_t idx_, double value_) {
-		if (idx_ >= last_value.size())
-			last_value.resize (1 + idx_);
-		last_value[idx_] = value_;
+/* Feed every cursor record in [from, till) to the query.  If IsTimed OnTime is
+ * called first with the record timestamp and returns false to stop.
+ */
+template <bool IsTimed, class Query, class Cursor, class OnTime>
+bool
+Drain (
+	Query*		query_expression,
+	Cursor*		cursor,
+	__time32_t	from,
+	__time32_t	till,
+	OnTime&		on_time
+	)
+{
+	if (!query_expression->Open (cursor, from, till))
+		return false;
+	while (cursor->Next()) {
+		if (IsTimed && !on_time (cursor->GetCurrentTime32()))
+			break;
+		query_expression->OnTick (cursor->GetCurrentSymbolName());
 	}
+	cursor->Close();
+	return true;
+}
 
-	std::forward_list<std::shared_ptr<hilo_t>> non_synthetic_list;
-/* synthetic members */
-	std::vector<double> last_value;
-	bool is_null;
-	std::list<std::pair<std::shared_ptr<symbol_t>, std::shared_ptr<hilo_t>>> as_first_leg_list, as_second_leg_list;
-};
-
-void
-get_hilo (
-	const std::vector<std::shared_ptr<hilo_t>>& query,
-	__time32_t	from,		/* legacy from before 2003, yay. */
-	__time32_t	till
-	)
-{
-	DLOG(INFO) << "get_hilo(from=" << from << " till=" << till << ")";
-
-	std::unordered_map<std::string, std::shared_ptr<symbol_t>> symbol_map;
-	std::set<std::string> symbol_set;
-	std::set<FlexRecBinding> binding_set;
-	std::unordered_map<std::string, size_t> field_map;
-	std::vector<double> fields;
-
-/* convert multiple queries into a single query expression */
-	std::for_each (query.begin(), query.end(), [&](const std::shared_ptr<hilo_t>& query_it)
+/* Feed [from, till) from the tick cache where it holds every symbol of the
+ * query and the tick source before and after.  A new cursor is required per
+ * window as FlexRecReader caches the last binding set.  False if a tick
+ * source failed, a window without ticks is an empty result.
+ */
+template <bool IsTimed, class Query, class OnTime>
+bool
+Scan (
+	Query*		query_expression,
+	const std::vector<std::shared_ptr<hilo_t>>& query,
+	__time32_t	from,
+	__time32_t	till,
+	const scan_options_t& options,
+	OnTime&		on_time
+	)
+{
+	__time32_t cache_from = till, cache_till = till;
+	if (nullptr == options.cache || options.is_record ||
+	    !options.cache->GetCoverage (query, from, till, &cache_from, &cache_till))
 	{
-		auto symbol_it = symbol_map.find (query_it->legs.first.symbol_name);
-/* add new symbol into set */
-		if (symbol_map.end() == symbol_it) {
-			std::shared_ptr<symbol_t> new_symbol (new symbol_t (query_it->legs.first.is_null));
-			auto status = symbol_map.emplace (std::make_pair (query_it->legs.first.symbol_name, std::move (new_symbol)));
-			symbol_it = status.first;
-			symbol_set.emplace (symbol_it->first);
+		cache_from = cache_till = till;
+	}
+	bool is_open = true;
+	if (from < cache_from) {
+		source_cursor_t fr (options);
+		if (!Drain<IsTimed> (query_expression, &fr, from, cache_from, on_time))
+			is_open = false;
+	}
+	if (cache_from < cache_till) {
+		tick_cache_t::reader_t reader (*options.cache);
+		if (!Drain<IsTimed> (query_expression, &reader, cache_from, cache_till, on_time)) {
+/* evicted since the coverage check */
+			source_cursor_t fr (options);
+			if (!Drain<IsTimed> (query_expression, &fr, cache_from, cache_till, on_time))
+				is_open = false;
 		}
+	}
+	if (cache_till < till) {
+		source_cursor_t fr (options);
+		if (!Drain<IsTimed> (query_expression, &fr, cache_till, till, on_time))
+			is_open = false;
+	}
+	return is_open;
+}
 
-/* map field into binding index and set last value cache */
-		auto AddField = [&](const std::string& name) -> size_t {
-			auto it = field_map.find (name);
-			size_t idx;
-			if (field_map.end() == it) {
-				idx = fields.size();
-				fields.resize (idx + 1);
-				field_map[name] = idx;
-			} else {
-				idx = it->second;
-			}
-			return idx;
-		};
+/* Floating-point engines update high and low in place, only the fixed-point
+ * engine sets the mantissas again on Save.
+ */
+static inline
+void
+ClearMantissas (
+	const std::vector<std::shared_ptr<hilo_t>>& query
+	)
+{
+	std::for_each (query.begin(), query.end(), [](const std::shared_ptr<hilo_t>& it) {
+		it->has_mantissa = false;
+	});
+}
 
-		query_it->legs.first.bid_field_idx = AddField (query_it->legs.first.bid_field);
-		symbol_it->second->SetLastValue (query_it->legs.first.bid_field_idx, query_it->legs.first.last_bid);
+template <class Query>
+bool
+ScanWindow (
+	const std::vector<std::shared_ptr<hilo_t>>& query,
+	__time32_t	from,
+	__time32_t	till,
+	const scan_options_t& options
+	)
+{
+	DLOG(INFO) << "get_hilo(from=" << from << " till=" << till << ")";
 
-		query_it->legs.first.ask_field_idx = AddField (query_it->legs.first.ask_field);
-		symbol_it->second->SetLastValue (query_it->legs.first.ask_field_idx, query_it->legs.first.last_ask);
+	ClearMantissas (query);
+	Query query_expression (query);
+	auto OnTime = [](__time32_t) -> bool { return true; };
+	const bool is_open = Scan<false> (&query_expression, query, from, till, options, OnTime);
 
-		if (!query_it->is_synthetic) {
-			symbol_it->second->non_synthetic_list.push_front (query_it);
-			return;
-		}
+	query_expression.Save();
 
-/* this ric is a synthetic pair, XxxYyy, add to list of Xxx a link to -Yyy and add to Yyy a link to Xxx- */
-		assert (query_it->legs.first.symbol_name != query_it->legs.second.symbol_name);
-
-/* Xxx */
-		auto first_it = std::ref (symbol_it).get();
-/* Yyy */
-		auto second_it = symbol_map.find (query_it->legs.second.symbol_name);
-		if (symbol_map.end() == second_it) {
-			std::shared_ptr<symbol_t> new_symbol (new symbol_t (query_it->legs.second.is_null));
-			auto status = symbol_map.emplace (std::make_pair (query_it->legs.second.symbol_name, std::move (new_symbol)));
-			second_it = status.first;
-			symbol_set.emplace (second_it->first);
-		}
+	DLOG(INFO) << "get_hilo() finished.";
+	return is_open;
+}
 
-		query_it->legs.second.bid_field_idx = AddField (query_it->legs.second.bid_field);
-		second_it->second->SetLastValue (query_it->legs.second.bid_field_idx, query_it->legs.second.last_bid);
+/*  IN: hilo populated with symbol names.
+ * OUT: bars populated with one high-low bar per rule per interval from start,
+ *      hilo populated with the last interval.
+ *
+ * Equivalent to calling get_hilo() for each interval, resetting the rule high
+ * and low before each call.  If is_carry_legs is false leg state is also reset
+ * as per hilo_t::Clear(), otherwise leg values carry across intervals.
+ */
+template <class Query>
+bool
+ScanBuckets (
+	const std::vector<std::shared_ptr<hilo_t>>& query,
+	__time32_t	start,
+	__time32_t	end,
+	int		interval_seconds,
+	bool		is_carry_legs,
+	std::vector<std::vector<bar_t>>* bars,
+	const scan_options_t& options
+	)
+{
+	DLOG(INFO) << "get_hilo(start=" << start << " end=" << end << " interval=" << interval_seconds << ")";
+	CHECK (interval_seconds > 0);
+	CHECK (nullptr != bars);
 
-		query_it->legs.second.ask_field_idx = AddField (query_it->legs.second.ask_field);
-		second_it->second->SetLastValue (query_it->legs.second.ask_field_idx, query_it->legs.second.last_ask);
+/* complete intervals only */
+	const size_t bucket_count = (end > start) ? ((end - start) / interval_seconds) : 0;
+	const __time32_t till = start + static_cast<__time32_t> (bucket_count * interval_seconds);
 
-		first_it->second->as_first_leg_list.emplace_back (std::make_pair (second_it->second, query_it));
-		second_it->second->as_second_leg_list.emplace_back (std::make_pair (first_it->second, query_it));
+	bars->resize (query.size());
+	std::for_each (bars->begin(), bars->end(), [bucket_count](std::vector<bar_t>& rule_bars) {
+		rule_bars.clear();
+		rule_bars.reserve (bucket_count);
 	});
+	std::vector<watermark_t>*const marks = options.watermarks;
+	if (nullptr != marks)
+		marks->assign (bucket_count, watermark_t());
+	if (0 == bucket_count)
+		return true;
 
-	FlexRecReader fr;
-	FlexRecBinding binding (kQuoteId);
+	ClearMantissas (query);
+	Query query_expression (query);
 
-/* copy finalized bindings into new set */
-	std::for_each (field_map.begin(), field_map.end(), [&](std::pair<const std::string, size_t>& field_pair) {
-		binding.Bind (field_pair.first.c_str(), &fields[field_pair.second]);
-	});
-	binding_set.insert (binding);
-
-	auto UpdateNonSynthetic = [&fields](hilo_t*const query_item) {
-		const double bid_price = fields[query_item->legs.first.bid_field_idx];
-		const double ask_price = fields[query_item->legs.first.ask_field_idx];
-		if (query_item->is_null) {
-			query_item->is_null = false;
-			query_item->low     = bid_price;
-			query_item->high    = ask_price;
-			DLOG(INFO) << query_item->name << " start low=" << bid_price << " high=" << ask_price;
-			return;
-		}
-		if (bid_price < query_item->low) {
-			query_item->low     = bid_price;
-			DLOG(INFO) << query_item->name << " new low=" << bid_price;
+/* close the current bucket into the bar vectors and start the next */
+	size_t bucket = 0;
+	__time32_t bucket_end = start + interval_seconds;
+	auto CloseBucket = [&]() {
+		for (size_t rule_index = 0; rule_index < query.size(); ++rule_index) {
+			query_expression.Save (rule_index);
+			(*bars)[rule_index].push_back (bar_t (*query[rule_index].get()));
 		}
-		if (ask_price > query_item->high) {
-			query_item->high    = ask_price;
-			DLOG(INFO) << query_item->name << " new high=" << ask_price;
-		}
-	};
-
-	auto UpdateSynthetic = [](hilo_t*const query_item, const symbol_t& first_leg, const symbol_t& second_leg) {
-		if (first_leg.is_null || second_leg.is_null)
+		if (++bucket == bucket_count)
 			return;
+		query_expression.ClearRules();
+		if (!is_carry_legs)
+			query_expression.ClearLegs();
+		bucket_end += interval_seconds;
+	};
 
-/* lambda to function pointer is incomplete in MSVC2010, punt to the compiler to clean up. */
-		auto MathOperator = [query_item](double a, double b) -> double {
-			if (MATH_OP_TIMES == query_item->math_op)
-				return (double)(a * b);
-			else if (b == 0.0)
-				return b;
-			else
-				return (double)(a / b);
-		};
+	query_expression.ClearRules();
+	if (!is_carry_legs)
+		query_expression.ClearLegs();
 
-		const double synthetic_bid_price = MathOperator (first_leg.last_value[query_item->legs.first.bid_field_idx], second_leg.last_value[query_item->legs.second.bid_field_idx]);
-		const double synthetic_ask_price = MathOperator (first_leg.last_value[query_item->legs.first.ask_field_idx], second_leg.last_value[query_item->legs.second.ask_field_idx]);
+	auto OnTime = [&](__time32_t timestamp) -> bool {
+		while (timestamp >= bucket_end && bucket < bucket_count)
+			CloseBucket();
+		if (bucket == bucket_count)
+			return false;
+		if (nullptr != marks)
+			(*marks)[bucket].Add (timestamp);
+		return true;
+	};
+	const bool is_open = Scan<true> (&query_expression, query, start, till, options, OnTime);
 
-		if (query_item->is_null) {
-			query_item->is_null = false;
-			query_item->low     = synthetic_bid_price;
-			query_item->high    = synthetic_ask_price;
-			DLOG(INFO) << query_item->name << "start low=" << synthetic_bid_price << " high=" << synthetic_ask_price;
-			return;
-		}
+/* trailing empty buckets */
+	while (bucket < bucket_count)
+		CloseBucket();
 
-		if (synthetic_bid_price < query_item->low) {
-			query_item->low     = synthetic_bid_price;
-			DLOG(INFO) << query_item->name << "new low=" << query_item->low;
-		}
-		if (synthetic_ask_price > query_item->high) {
-			query_item->high    = synthetic_ask_price;
-			DLOG(INFO) << query_item->name << "new high=" << query_item->high;
-		}
-	};
+	DLOG(INFO) << "get_hilo() finished, #" << bucket_count << " bars.";
+	return is_open;
+}
 
+} /* anonymous namespace */
+
+/* Single iterator implementation.
+ */
+namespace single_iterator {
+/* Multiple rules converted into a single query expression over one cursor,
+ * leg fan-out walks the shared compiled plan of the rule set.
+ */
+class query_t : boost::noncopyable
+{
+public:
+	explicit query_t (const std::vector<std::shared_ptr<hilo_t>>& query);
+
 /* run one single big query:
  *
- * HUGE WARNING: if the first symbol has no trades then the cursor will not open.
+ * HUGE WARNING: if the first symbol has no trades then FlexRecReader will not
+ * open, the tick source re-opens without it.
  */
-	try {
-		char error_text[1024];
-		const int cursor_status = fr.Open (symbol_set, binding_set, from, till, 0 /* forward */, 0 /* no limit */, error_text);
-		if (1 != cursor_status) {
-			LOG(ERROR) << "FlexRecReader::Open failed { \"code\": " << cursor_status
-				<< ", \"text\": \"" << error_text << "\" }";
-			return;
-		}
-	} catch (std::exception& e) {
-		LOG(ERROR) << "FlexRecReader::Open raised exception " << e.what();
-		return;
+	template <class Cursor>
+	bool Open (Cursor* cursor, __time32_t from, __time32_t till) {
+		return cursor->Open (symbol_set_, plan_->GetFieldMap(), &fields_, from, till);
 	}
+
+/* Apply the current cursor record to every dependent rule. */
+	void OnTick (const char* symbol_name);
+	void OnTick (size_t slot);
 
-	while (fr.Next()) {
-		auto symbol = symbol_map[fr.GetCurrentSymbolName()];
-/* non-synthetic */
-		std::for_each (symbol->non_synthetic_list.begin(), symbol->non_synthetic_list.end(), [&](const std::shared_ptr<hilo_t>& query_it) {
-			UpdateNonSynthetic (query_it.get());
-		});
-/* synthetics */
-		symbol->is_null = false;
-/* cache last value */
-		for (int i = fields.size() - 1; i >= 0; i--) {
-			symbol->last_value[i] = fields[i];
-		}
-		std::for_each (symbol->as_first_leg_list.begin(), symbol->as_first_leg_list.end(), [&](std::pair<std::shared_ptr<symbol_t>, std::shared_ptr<hilo_t>>& second_leg) {
-			UpdateSynthetic (second_leg.second.get(), *symbol.get(), *second_leg.first.get());
-		});
-		std::for_each (symbol->as_second_leg_list.begin(), symbol->as_second_leg_list.end(), [&](std::pair<std::shared_ptr<symbol_t>, std::shared_ptr<hilo_t>>& first_leg) {
-			UpdateSynthetic (first_leg.second.get(), *first_leg.first.get(), *symbol.get());
-		});
-	}	
-	fr.Close();
+/* Resolve the cursor symbol name, symbol_index_t::npos if unknown. */
+	size_t Find (const char* symbol_name) {
+		return symbol_index_.Find (symbol_name);
+	}
+
+/* Reset high-low state of every rule, leg state is unchanged. */
+	void ClearRules();
+/* Reset last values of every symbol, equivalent to hilo_t::Clear() on legs. */
+	void ClearLegs();
 
 /* cache symbol last values back into query vector, 1:M operation */
-	std::for_each (query.begin(), query.end(), [&](const std::shared_ptr<hilo_t>& query_it)
+	void Save (size_t rule_index);
+	void Save();
+
+private:
+	void UpdateNonSynthetic (hilo_t*const query_item, double bid_price, double ask_price);
+	template <int MathOp, bool IsFirstLeg>
+	void UpdateSynthetics (size_t slot, int group);
+
+	const double* GetLastValues (size_t slot) const {
+		return last_values_.data() + (slot * field_count_);
+	}
+
+	const std::vector<std::shared_ptr<hilo_t>>& query_;
+	const std::shared_ptr<const rule_plan_t> plan_;
+	const size_t field_count_;
+/* slots in plan order. */
+	symbol_index_t symbol_index_;
+/* field_count_ last values per slot. */
+	std::vector<double> last_values_;
+	std::vector<char> is_null_;
+	std::set<std::string> symbol_set_;
+	std::vector<double> fields_;
+};
+
+query_t::query_t (
+	const std::vector<std::shared_ptr<hilo_t>>& query
+	) :
+	query_ (query),
+	plan_ (rule_plan_t::Get (query)),
+	field_count_ (plan_->GetFieldCount()),
+	symbol_set_ (plan_->GetSymbolSet()),
+	fields_ (plan_->GetFieldCount())
+{
+	const size_t symbol_count = plan_->GetSymbolCount();
+	for (size_t slot = 0; slot < symbol_count; ++slot) {
+		const size_t index = symbol_index_.Insert (plan_->GetSymbolId (slot));
+		DCHECK (index == slot);
+	}
+	last_values_.assign (symbol_count * field_count_, 0.0);
+	is_null_.assign (symbol_count, -1);
+
+/* seed leg state in rule order, null state from the first rule of a symbol */
+	for (size_t rule_index = 0; rule_index < query.size(); ++rule_index) {
+		const hilo_t& rule = *query[rule_index].get();
+		const rule_plan_t::rule_t& slots = plan_->GetRule (rule_index);
+		if (-1 == is_null_[slots.first])
+			is_null_[slots.first] = rule.legs.first.is_null;
+		last_values_[(slots.first * field_count_) + slots.first_bid] = rule.legs.first.last_bid;
+		last_values_[(slots.first * field_count_) + slots.first_ask] = rule.legs.first.last_ask;
+		if (symbol_index_t::npos == slots.second)
+			continue;
+		if (-1 == is_null_[slots.second])
+			is_null_[slots.second] = rule.legs.second.is_null;
+		last_values_[(slots.second * field_count_) + slots.second_bid] = rule.legs.second.last_bid;
+		last_values_[(slots.second * field_count_) + slots.second_ask] = rule.legs.second.last_ask;
+	}
+}
+
+void
+query_t::UpdateNonSynthetic (
+	hilo_t*const query_item,
+	double		bid_price,
+	double		ask_price
+	)
+{
+	if (query_item->is_null) {
+		query_item->is_null = false;
+		query_item->low     = bid_price;
+		query_item->high    = ask_price;
+		DLOG(INFO) << query_item->name << " start low=" << bid_price << " high=" << ask_price;
+		return;
+	}
+	if (bid_price < query_item->low) {
+		query_item->low     = bid_price;
+		DLOG(INFO) << query_item->name << " new low=" << bid_price;
+	}
+	if (ask_price > query_item->high) {
+		query_item->high    = ask_price;
+		DLOG(INFO) << query_item->name << " new high=" << ask_price;
+	}
+}
+
+/* Fan-out to every synthetic of one edge group where slot is the IsFirstLeg
+ * leg, slot is non-null.
+ */
+template <int MathOp, bool IsFirstLeg>
+void
+query_t::UpdateSynthetics (
+	size_t		slot,
+	int		group
+	)
+{
+	const double*const values = GetLastValues (slot);
+	for (const rule_plan_t::edge_t* it = plan_->begin (slot, group); it != plan_->end (slot, group); ++it)
 	{
-		auto first_leg = symbol_map[query_it->legs.first.symbol_name];
-		query_it->legs.first.is_null  = first_leg->is_null;
-		query_it->legs.first.last_bid = first_leg->last_value[query_it->legs.first.bid_field_idx];
-		query_it->legs.first.last_ask = first_leg->last_value[query_it->legs.first.ask_field_idx];
+		if (is_null_[it->other])
+			continue;
+		const double*const other = GetLastValues (it->other);
+		const double*const first_leg  = IsFirstLeg ? values : other;
+		const double*const second_leg = IsFirstLeg ? other : values;
+		UpdateSynthetic<MathOp> (query_[it->rule].get(),
+					 first_leg[it->first_bid],
+					 first_leg[it->first_ask],
+					 second_leg[it->second_bid],
+					 second_leg[it->second_ask]);
+	}
+}
+
+void
+query_t::OnTick (
+	const char* symbol_name
+	)
+{
+	const size_t slot = symbol_index_.Find (symbol_name);
+	if (symbol_index_t::npos == slot) {
+		LOG(WARNING) << "Unexpected symbol \"" << symbol_name << "\" in cursor.";
+		return;
+	}
+	OnTick (slot);
+}
 
-		if (!query_it->is_synthetic) return;
+void
+query_t::OnTick (
+	size_t slot
+	)
+{
+/* non-synthetic */
+	for (const rule_plan_t::edge_t* it = plan_->begin (slot, rule_plan_t::EDGE_NON_SYNTHETIC); it != plan_->end (slot, rule_plan_t::EDGE_NON_SYNTHETIC); ++it)
+		UpdateNonSynthetic (query_[it->rule].get(), fields_[it->first_bid], fields_[it->first_ask]);
+/* synthetics */
+	is_null_[slot] = false;
+/* cache last value of the fields this symbol's rules read */
+	double*const last_values = last_values_.data() + (slot * field_count_);
+	for (const uint32_t* field = plan_->field_begin (slot); field != plan_->field_end (slot); ++field)
+		last_values[*field] = fields_[*field];
+	UpdateSynthetics<MATH_OP_TIMES,  true>  (slot, rule_plan_t::EDGE_FIRST_LEG_TIMES);
+	UpdateSynthetics<MATH_OP_DIVIDE, true>  (slot, rule_plan_t::EDGE_FIRST_LEG_DIVIDE);
+	UpdateSynthetics<MATH_OP_TIMES,  false> (slot, rule_plan_t::EDGE_SECOND_LEG_TIMES);
+	UpdateSynthetics<MATH_OP_DIVIDE, false> (slot, rule_plan_t::EDGE_SECOND_LEG_DIVIDE);
+}
 
-		auto second_leg = symbol_map[query_it->legs.second.symbol_name];
-		query_it->legs.second.is_null  = second_leg->is_null;
-		query_it->legs.second.last_bid = second_leg->last_value[query_it->legs.second.bid_field_idx];
-		query_it->legs.second.last_ask = second_leg->last_value[query_it->legs.second.ask_field_idx];
+void
+query_t::ClearRules()
+{
+	std::for_each (query_.begin(), query_.end(), [](const std::shared_ptr<hilo_t>& query_it) {
+		query_it->high = query_it->low = 0.0;
+		query_it->is_null = true;
 	});
+}
 
-	DLOG(INFO) << "get_hilo() finished.";
+void
+query_t::ClearLegs()
+{
+	std::fill (last_values_.begin(), last_values_.end(), 0.0);
+	std::fill (is_null_.begin(), is_null_.end(), true);
+}
+
+void
+query_t::Save (
+	size_t rule_index
+	)
+{
+	hilo_t*const query_item = query_[rule_index].get();
+	const rule_plan_t::rule_t& slots = plan_->GetRule (rule_index);
+	const double*const first_leg = GetLastValues (slots.first);
+	query_item->legs.first.is_null  = 0 != is_null_[slots.first];
+	query_item->legs.first.last_bid = first_leg[slots.first_bid];
+	query_item->legs.first.last_ask = first_leg[slots.first_ask];
+
+	if (!query_item->is_synthetic) return;
+
+	const double*const second_leg = GetLastValues (slots.second);
+	query_item->legs.second.is_null  = 0 != is_null_[slots.second];
+	query_item->legs.second.last_bid = second_leg[slots.second_bid];
+	query_item->legs.second.last_ask = second_leg[slots.second_ask];
+}
+
+void
+query_t::Save()
+{
+	for (size_t rule_index = 0; rule_index < query_.size(); ++rule_index)
+		Save (rule_index);
+}
+
+bool
+get_hilo (
+	const std::vector<std::shared_ptr<hilo_t>>& query,
+	__time32_t	from,		/* legacy from before 2003, yay. */
+	__time32_t	till,
+	const scan_options_t& options
+	)
+{
+	return ScanWindow<query_t> (query, from, till, options);
+}
+
+bool
+get_hilo (
+	const std::vector<std::shared_ptr<hilo_t>>& query,
+	__time32_t	start,
+	__time32_t	end,
+	int		interval_seconds,
+	bool		is_carry_legs,
+	std::vector<std::vector<bar_t>>* bars,
+	const scan_options_t& options
+	)
+{
+	return ScanBuckets<query_t> (query, start, end, interval_seconds, is_carry_legs, bars, options);
 }
+
 } // namespace single_iterator
+
+/* Vectorized implementation, single cursor with rule state in contiguous
+ * per-symbol fan-out blocks updated by the min/max kernels.
+ *
+ * Each synthetic rule owns one slot in a block of each leg, the slot caches
+ * the price of the other leg and folds every candidate calculated on a tick
+ * of its own leg.  The rule result is the union of both slots which is exact
+ * as min and max are associative.
+ */
+namespace vectorized {
+
+class block_t
+{
+public:
+	block_t (int op_, int bid_field_idx_, int ask_field_idx_) :
+		op (op_),
+		bid_field_idx (bid_field_idx_),
+		ask_field_idx (ask_field_idx_)
+	{
+	}
+
+	size_t Add (size_t rule_index) {
+		const size_t slot = rule.size();
+		rule.push_back (rule_index);
+		other_bid.push_back (0.0);
+		other_ask.push_back (0.0);
+/* non-synthetic slots have no other leg to wait on. */
+		valid.push_back (kernel::KERNEL_NOOP == op ? kernel::kMaskSet : 0);
+		low.push_back (0.0);
+		high.push_back (0.0);
+		hit.push_back (0);
+		return slot;
+	}
+
+	void ClearRules() {
+		std::fill (hit.begin(), hit.end(), 0);
+	}
+
+	void ClearLegs() {
+		if (kernel::KERNEL_NOOP == op)
+			return;
+		std::fill (other_bid.begin(), other_bid.end(), 0.0);
+		std::fill (other_ask.begin(), other_ask.end(), 0.0);
+		std::fill (valid.begin(), valid.end(), 0);
+	}
+
+	void Update (double tick_bid, double tick_ask) {
+		kernel::block_view_t view;
+		view.other_bid = other_bid.data();
+		view.other_ask = other_ask.data();
+		view.valid     = valid.data();
+		view.low       = low.data();
+		view.high      = high.data();
+		view.hit       = hit.data();
+		view.size      = rule.size();
+		kernel::Update (op, tick_bid, tick_ask, view);
+	}
+
+	int op;
+/* tick side fields. */
+	int bid_field_idx, ask_field_idx;
+	std::vector<size_t> rule;
+	std::vector<double> other_bid, other_ask;
+	std::vector<uint64_t> valid;
+	std::vector<double> low, high;
+	std::vector<uint64_t> hit;
+};
+
+class symbol_t
+{
+public:
+	symbol_t (bool is_null_) :
+		is_null (is_null_)
+	{
+	}
+
+/* slot in another symbol's block waiting on this symbol as the other leg. */
+	struct counterpart_t {
+		size_t block, slot;
+		int bid_field_idx, ask_field_idx;
+	};
+
+	std::vector<double> last_value;
+/* bound fields read by a rule with this symbol as a leg. */
+	std::vector<int> fields;
+	bool is_null;
+/* blocks updated on a tick of this symbol. */
+	std::vector<size_t> blocks;
+	std::vector<counterpart_t> counterparts;
+};
+
+class query_t : boost::noncopyable
+{
+public:
+	explicit query_t (const std::vector<std::shared_ptr<hilo_t>>& query);
+
+	template <class Cursor>
+	bool Open (Cursor* cursor, __time32_t from, __time32_t till) {
+		return cursor->Open (symbol_set_, field_map_, &fields_, from, till);
+	}
+	void OnTick (const char* symbol_name);
+	void ClearRules();
+	void ClearLegs();
+/* merge rule slots and symbol last values back into query vector. */
+	void Save (size_t rule_index);
+	void Save();
+
+private:
+	size_t AddSymbol (const std::string& name, bool is_null);
+	int AddField (const std::string& name);
+	size_t AddBlock (size_t symbol_slot, int op, int bid_field_idx, int ask_field_idx);
+
+	struct rule_t {
+/* state prior to this query, extended as per single_iterator. */
+		bool is_null;
+		double high, low;
+		size_t first_symbol, second_symbol;
+/* (block, slot) pairs, one per leg for synthetics. */
+		std::pair<size_t, size_t> slots[2];
+		size_t slot_count;
+	};
+
+	const std::vector<std::shared_ptr<hilo_t>>& query_;
+	symbol_index_t symbol_index_;
+	std::vector<symbol_t> symbols_;
+	std::vector<block_t> blocks_;
+	std::vector<rule_t> rules_;
+	std::set<std::string> symbol_set_;
+	std::unordered_map<std::string, size_t> field_map_;
+	std::vector<double> fields_;
+};
+
+query_t::query_t (
+	const std::vector<std::shared_ptr<hilo_t>>& query
+	) :
+	query_ (query)
+{
+	rules_.resize (query.size());
+	for (size_t rule_index = 0; rule_index < query.size(); ++rule_index)
+	{
+		hilo_t& hilo = *query[rule_index].get();
+		rule_t& rule = rules_[rule_index];
+		rule.is_null = hilo.is_null;
+		rule.high    = hilo.high;
+		rule.low     = hilo.low;
+
+		leg_t& first = hilo.legs.first;
+		first.bid_field_idx = AddField (first.bid_field);
+		first.ask_field_idx = AddField (first.ask_field);
+		rule.first_symbol = AddSymbol (first.symbol_name, first.is_null);
+		rule.second_symbol = symbol_index_t::npos;
+
+		if (!hilo.is_synthetic) {
+			const size_t block = AddBlock (rule.first_symbol, kernel::KERNEL_NOOP, first.bid_field_idx, first.ask_field_idx);
+			rule.slots[0] = std::make_pair (block, blocks_[block].Add (rule_index));
+			rule.slot_count = 1;
+			continue;
+		}
+
+		assert (first.symbol_name != hilo.legs.second.symbol_name);
+		leg_t& second = hilo.legs.second;
+		second.bid_field_idx = AddField (second.bid_field);
+		second.ask_field_idx = AddField (second.ask_field);
+		rule.second_symbol = AddSymbol (second.symbol_name, second.is_null);
+
+		const bool is_times = (MATH_OP_TIMES == GetSyntheticOp (hilo));
+		const size_t first_block  = AddBlock (rule.first_symbol,  is_times ? kernel::KERNEL_TIMES : kernel::KERNEL_DIVIDE_FIRST,  first.bid_field_idx,  first.ask_field_idx);
+		const size_t second_block = AddBlock (rule.second_symbol, is_times ? kernel::KERNEL_TIMES : kernel::KERNEL_DIVIDE_SECOND, second.bid_field_idx, second.ask_field_idx);
+		rule.slots[0] = std::make_pair (first_block,  blocks_[first_block].Add (rule_index));
+		rule.slots[1] = std::make_pair (second_block, blocks_[second_block].Add (rule_index));
+		rule.slot_count = 2;
+
+/* first leg block waits on the second leg and vice versa. */
+		symbol_t::counterpart_t counterpart;
+		counterpart.block = rule.slots[0].first;
+		counterpart.slot  = rule.slots[0].second;
+		counterpart.bid_field_idx = second.bid_field_idx;
+		counterpart.ask_field_idx = second.ask_field_idx;
+		symbols_[rule.second_symbol].counterparts.push_back (counterpart);
+		counterpart.block = rule.slots[1].first;
+		counterpart.slot  = rule.slots[1].second;
+		counterpart.bid_field_idx = first.bid_field_idx;
+		counterpart.ask_field_idx = first.ask_field_idx;
+		symbols_[rule.first_symbol].counterparts.push_back (counterpart);
+	}
+
+/* every symbol holds a slot per bound field, seeded from the leg state. */
+	std::for_each (symbols_.begin(), symbols_.end(), [this](symbol_t& symbol) {
+		symbol.last_value.resize (fields_.size(), 0.0);
+	});
+	for (size_t rule_index = 0; rule_index < query.size(); ++rule_index)
+	{
+		const hilo_t& hilo = *query[rule_index].get();
+		const rule_t& rule = rules_[rule_index];
+		symbol_t& first = symbols_[rule.first_symbol];
+		first.last_value[hilo.legs.first.bid_field_idx] = hilo.legs.first.last_bid;
+		first.last_value[hilo.legs.first.ask_field_idx] = hilo.legs.first.last_ask;
+		first.fields.push_back (hilo.legs.first.bid_field_idx);
+		first.fields.push_back (hilo.legs.first.ask_field_idx);
+		if (!hilo.is_synthetic)
+			continue;
+		symbol_t& second = symbols_[rule.second_symbol];
+		second.last_value[hilo.legs.second.bid_field_idx] = hilo.legs.second.last_bid;
+		second.last_value[hilo.legs.second.ask_field_idx] = hilo.legs.second.last_ask;
+		second.fields.push_back (hilo.legs.second.bid_field_idx);
+		second.fields.push_back (hilo.legs.second.ask_field_idx);
+	}
+	std::for_each (symbols_.begin(), symbols_.end(), [](symbol_t& symbol) {
+		std::sort (symbol.fields.begin(), symbol.fields.end());
+		symbol.fields.erase (std::unique (symbol.fields.begin(), symbol.fields.end()), symbol.fields.end());
+	});
+	std::for_each (symbols_.begin(), symbols_.end(), [this](const symbol_t& symbol) {
+		std::for_each (symbol.counterparts.begin(), symbol.counterparts.end(), [&](const symbol_t::counterpart_t& counterpart) {
+			block_t& block = blocks_[counterpart.block];
+			block.other_bid[counterpart.slot] = symbol.last_value[counterpart.bid_field_idx];
+			block.other_ask[counterpart.slot] = symbol.last_value[counterpart.ask_field_idx];
+			block.valid[counterpart.slot]     = symbol.is_null ? 0 : kernel::kMaskSet;
+		});
+	});
+}
+
+size_t
+query_t::AddSymbol (
+	const std::string& name,
+	bool		is_null
+	)
+{
+	const size_t slot = symbol_index_.Insert (symbol_table_t::Intern (name));
+	if (slot < symbols_.size())
+		return slot;
+	DCHECK (slot == symbols_.size());
+	symbols_.push_back (symbol_t (is_null));
+	symbol_set_.emplace (name);
+	return slot;
+}
+
+int
+query_t::AddField (
+	const std::string& name
+	)
+{
+	auto it = field_map_.find (name);
+	if (field_map_.end() != it)
+		return static_cast<int> (it->second);
+	const size_t idx = fields_.size();
+	fields_.resize (idx + 1);
+	field_map_[name] = idx;
+	return static_cast<int> (idx);
+}
+
+/* find or create the block of symbol for operator and tick fields.
+ */
+size_t
+query_t::AddBlock (
+	size_t		symbol_slot,
+	int		op,
+	int		bid_field_idx,
+	int		ask_field_idx
+	)
+{
+	symbol_t& symbol = symbols_[symbol_slot];
+	for (auto it = symbol.blocks.begin(); it != symbol.blocks.end(); ++it) {
+		const block_t& block = blocks_[*it];
+		if (block.op == op &&
+		    block.bid_field_idx == bid_field_idx &&
+		    block.ask_field_idx == ask_field_idx)
+		{
+			return *it;
+		}
+	}
+	const size_t block = blocks_.size();
+	blocks_.push_back (block_t (op, bid_field_idx, ask_field_idx));
+	symbol.blocks.push_back (block);
+	return block;
+}
+
+void
+query_t::OnTick (
+	const char* symbol_name
+	)
+{
+	const size_t slot = symbol_index_.Find (symbol_name);
+	if (symbol_index_t::npos == slot) {
+		LOG(WARNING) << "Unexpected symbol \"" << symbol_name << "\" in cursor.";
+		return;
+	}
+	symbol_t& symbol = symbols_[slot];
+	symbol.is_null = false;
+	std::for_each (symbol.fields.begin(), symbol.fields.end(), [&](int field) {
+		symbol.last_value[field] = fields_[field];
+	});
+/* fan-out to every rule with this symbol as a leg */
+	std::for_each (symbol.blocks.begin(), symbol.blocks.end(), [this](size_t block) {
+		blocks_[block].Update (fields_[blocks_[block].bid_field_idx], fields_[blocks_[block].ask_field_idx]);
+	});
+/* publish new leg price to the other leg of every synthetic */
+	std::for_each (symbol.counterparts.begin(), symbol.counterparts.end(), [this](const symbol_t::counterpart_t& counterpart) {
+		block_t& block = blocks_[counterpart.block];
+		block.other_bid[counterpart.slot] = fields_[counterpart.bid_field_idx];
+		block.other_ask[counterpart.slot] = fields_[counterpart.ask_field_idx];
+		block.valid[counterpart.slot]     = kernel::kMaskSet;
+	});
+}
+
+void
+query_t::ClearRules()
+{
+	std::for_each (blocks_.begin(), blocks_.end(), [](block_t& block) {
+		block.ClearRules();
+	});
+	for (size_t rule_index = 0; rule_index < query_.size(); ++rule_index) {
+		rules_[rule_index].is_null = true;
+		query_[rule_index]->high = query_[rule_index]->low = 0.0;
+		query_[rule_index]->is_null = true;
+	}
+}
+
+void
+query_t::ClearLegs()
+{
+	std::for_each (symbols_.begin(), symbols_.end(), [](symbol_t& symbol) {
+		std::fill (symbol.last_value.begin(), symbol.last_value.end(), 0.0);
+		symbol.is_null = true;
+	});
+	std::for_each (blocks_.begin(), blocks_.end(), [](block_t& block) {
+		block.ClearLegs();
+	});
+}
+
+void
+query_t::Save (
+	size_t rule_index
+	)
+{
+	hilo_t*const query_item = query_[rule_index].get();
+	const rule_t& rule = rules_[rule_index];
+	bool is_null = rule.is_null;
+	double high = rule.high, low = rule.low;
+	for (size_t i = 0; i < rule.slot_count; ++i) {
+		const block_t& block = blocks_[rule.slots[i].first];
+		const size_t slot = rule.slots[i].second;
+		if (0 == block.hit[slot])
+			continue;
+		if (is_null) {
+			is_null = false;
+			low  = block.low[slot];
+			high = block.high[slot];
+			continue;
+		}
+		if (block.low[slot] < low)   low  = block.low[slot];
+		if (block.high[slot] > high) high = block.high[slot];
+	}
+	if (!is_null) {
+		query_item->is_null = false;
+		query_item->low     = low;
+		query_item->high    = high;
+	}
+
+	const symbol_t& first_leg = symbols_[rule.first_symbol];
+	query_item->legs.first.is_null  = first_leg.is_null;
+	query_item->legs.first.last_bid = first_leg.last_value[query_item->legs.first.bid_field_idx];
+	query_item->legs.first.last_ask = first_leg.last_value[query_item->legs.first.ask_field_idx];
+
+	if (!query_item->is_synthetic) return;
+
+	const symbol_t& second_leg = symbols_[rule.second_symbol];
+	query_item->legs.second.is_null  = second_leg.is_null;
+	query_item->legs.second.last_bid = second_leg.last_value[query_item->legs.second.bid_field_idx];
+	query_item->legs.second.last_ask = second_leg.last_value[query_item->legs.second.ask_field_idx];
+}
+
+void
+query_t::Save()
+{
+	for (size_t rule_index = 0; rule_index < query_.size(); ++rule_index)
+		Save (rule_index);
+}
+
+bool
+get_hilo (
+	const std::vector<std::shared_ptr<hilo_t>>& query,
+	__time32_t	from,
+	__time32_t	till,
+	const scan_options_t& options
+	)
+{
+	return ScanWindow<query_t> (query, from, till, options);
+}
+
+bool
+get_hilo (
+	const std::vector<std::shared_ptr<hilo_t>>& query,
+	__time32_t	start,
+	__time32_t	end,
+	int		interval_seconds,
+	bool		is_carry_legs,
+	std::vector<std::vector<bar_t>>* bars,
+	const scan_options_t& options
+	)
+{
+	return ScanBuckets<query_t> (query, start, end, interval_seconds, is_carry_legs, bars, options);
+}
+
+} // namespace vectorized
+
+/* Fixed-point implementation.
+ */
+namespace fixed_point {
+
+/* Rule high-low held as publish mantissas, bound fields are converted once per
+ * cursor record so outrights equal the mantissa of the floating-point engines.
+ * Products of the leg mantissas are rounded half up in integer space, the
+ * quotient high-low of divide rules stays floating-point over the leg
+ * mantissas and is converted once on Save as conversion is monotonic.
+ */
+class query_t : boost::noncopyable
+{
+public:
+	explicit query_t (const std::vector<std::shared_ptr<hilo_t>>& query);
+
+	template <class Cursor>
+	bool Open (Cursor* cursor, __time32_t from, __time32_t till) {
+		return cursor->Open (symbol_set_, plan_->GetFieldMap(), &fields_, from, till);
+	}
+
+	void OnTick (const char* symbol_name);
+	void OnTick (size_t slot);
+
+	size_t Find (const char* symbol_name) {
+		return symbol_index_.Find (symbol_name);
+	}
+
+	void ClearRules();
+	void ClearLegs();
+
+/* cache rule mantissas and symbol last values back into query vector */
+	void Save (size_t rule_index);
+	void Save();
+
+private:
+	void Update (size_t rule_index, bnymellon::mantissa_t bid, bnymellon::mantissa_t ask);
+	void UpdateQuotient (size_t rule_index, double bid, double ask);
+	template <int MathOp, bool IsFirstLeg>
+	void UpdateSynthetics (size_t slot, int group);
+
+	const double* GetLastValues (size_t slot) const {
+		return last_values_.data() + (slot * field_count_);
+	}
+	const bnymellon::mantissa_t* GetLastMantissas (size_t slot) const {
+		return last_mantissas_.data() + (slot * field_count_);
+	}
+
+	const std::vector<std::shared_ptr<hilo_t>>& query_;
+	const std::shared_ptr<const rule_plan_t> plan_;
+	const size_t field_count_;
+	symbol_index_t symbol_index_;
+/* leg prices as read for the saved leg state, and as converted for synthetics. */
+	std::vector<double> last_values_;
+	std::vector<bnymellon::mantissa_t> last_mantissas_;
+	std::vector<char> is_null_;
+	std::set<std::string> symbol_set_;
+	std::vector<double> fields_;
+/* per rule state, divide rules in quotient_high_ and quotient_low_. */
+	std::vector<bnymellon::mantissa_t> high_, low_;
+	std::vector<double> quotient_high_, quotient_low_;
+	std::vector<char> is_quotient_;
+	std::vector<char> rule_is_null_;
+};
+
+query_t::query_t (
+	const std::vector<std::shared_ptr<hilo_t>>& query
+	) :
+	query_ (query),
+	plan_ (rule_plan_t::Get (query)),
+	field_count_ (plan_->GetFieldCount()),
+	symbol_set_ (plan_->GetSymbolSet()),
+	fields_ (plan_->GetFieldCount())
+{
+	const size_t symbol_count = plan_->GetSymbolCount();
+	for (size_t slot = 0; slot < symbol_count; ++slot) {
+		const size_t index = symbol_index_.Insert (plan_->GetSymbolId (slot));
+		DCHECK (index == slot);
+	}
+	last_values_.assign (symbol_count * field_count_, 0.0);
+	last_mantissas_.assign (symbol_count * field_count_, 0);
+	is_null_.assign (symbol_count, -1);
+	high_.resize (query.size());
+	low_.resize (query.size());
+	quotient_high_.resize (query.size());
+	quotient_low_.resize (query.size());
+	is_quotient_.resize (query.size());
+	rule_is_null_.resize (query.size());
+
+/* seed rule and leg state in rule order as per single_iterator::query_t */
+	for (size_t rule_index = 0; rule_index < query.size(); ++rule_index) {
+		const hilo_t& rule = *query[rule_index].get();
+		const rule_plan_t::rule_t& slots = plan_->GetRule (rule_index);
+		high_[rule_index]         = bnymellon::mantissa (rule.high);
+		low_[rule_index]          = bnymellon::mantissa (rule.low);
+		quotient_high_[rule_index] = rule.high;
+		quotient_low_[rule_index]  = rule.low;
+		is_quotient_[rule_index]  = rule.is_synthetic && MATH_OP_DIVIDE == GetSyntheticOp (rule);
+		rule_is_null_[rule_index] = rule.is_null;
+		if (-1 == is_null_[slots.first])
+			is_null_[slots.first] = rule.legs.first.is_null;
+		last_values_[(slots.first * field_count_) + slots.first_bid] = rule.legs.first.last_bid;
+		last_values_[(slots.first * field_count_) + slots.first_ask] = rule.legs.first.last_ask;
+		if (symbol_index_t::npos == slots.second)
+			continue;
+		if (-1 == is_null_[slots.second])
+			is_null_[slots.second] = rule.legs.second.is_null;
+		last_values_[(slots.second * field_count_) + slots.second_bid] = rule.legs.second.last_bid;
+		last_values_[(slots.second * field_count_) + slots.second_ask] = rule.legs.second.last_ask;
+	}
+}
+
+void
+query_t::Update (
+	size_t		rule_index,
+	bnymellon::mantissa_t bid,
+	bnymellon::mantissa_t ask
+	)
+{
+	if (rule_is_null_[rule_index]) {
+		rule_is_null_[rule_index] = false;
+		low_[rule_index]  = bid;
+		high_[rule_index] = ask;
+		return;
+	}
+	if (bid < low_[rule_index])  low_[rule_index]  = bid;
+	if (ask > high_[rule_index]) high_[rule_index] = ask;
+}
+
+void
+query_t::UpdateQuotient (
+	size_t		rule_index,
+	double		bid,
+	double		ask
+	)
+{
+	if (rule_is_null_[rule_index]) {
+		rule_is_null_[rule_index] = false;
+		quotient_low_[rule_index]  = bid;
+		quotient_high_[rule_index] = ask;
+		return;
+	}
+	if (bid < quotient_low_[rule_index])  quotient_low_[rule_index]  = bid;
+	if (ask > quotient_high_[rule_index]) quotient_high_[rule_index] = ask;
+}
+
+template <int MathOp, bool IsFirstLeg>
+void
+query_t::UpdateSynthetics (
+	size_t		slot,
+	int		group
+	)
+{
+	const bnymellon::mantissa_t*const values = GetLastMantissas (slot);
+	for (const rule_plan_t::edge_t* it = plan_->begin (slot, group); it != plan_->end (slot, group); ++it)
+	{
+		if (is_null_[it->other])
+			continue;
+		const bnymellon::mantissa_t*const other = GetLastMantissas (it->other);
+		const bnymellon::mantissa_t*const first_leg  = IsFirstLeg ? values : other;
+		const bnymellon::mantissa_t*const second_leg = IsFirstLeg ? other : values;
+		if (MATH_OP_TIMES == MathOp)
+			Update (it->rule,
+				bnymellon::multiply (first_leg[it->first_bid], second_leg[it->second_bid]),
+				bnymellon::multiply (first_leg[it->first_ask], second_leg[it->second_ask]));
+		else
+			UpdateQuotient (it->rule,
+				math_op_t<MathOp>::Apply (bnymellon::price (first_leg[it->first_bid]), bnymellon::price (second_leg[it->second_bid])),
+				math_op_t<MathOp>::Apply (bnymellon::price (first_leg[it->first_ask]), bnymellon::price (second_leg[it->second_ask])));
+	}
+}
+
+void
+query_t::OnTick (
+	const char* symbol_name
+	)
+{
+	const size_t slot = symbol_index_.Find (symbol_name);
+	if (symbol_index_t::npos == slot) {
+		LOG(WARNING) << "Unexpected symbol \"" << symbol_name << "\" in cursor.";
+		return;
+	}
+	OnTick (slot);
+}
+
+void
+query_t::OnTick (
+	size_t slot
+	)
+{
+/* convert at ingest */
+	is_null_[slot] = false;
+	double*const last_values = last_values_.data() + (slot * field_count_);
+	bnymellon::mantissa_t*const last_mantissas = last_mantissas_.data() + (slot * field_count_);
+	for (const uint32_t* field = plan_->field_begin (slot); field != plan_->field_end (slot); ++field) {
+		last_values[*field] = fields_[*field];
+		last_mantissas[*field] = bnymellon::mantissa (fields_[*field]);
+	}
+/* non-synthetic */
+	for (const rule_plan_t::edge_t* it = plan_->begin (slot, rule_plan_t::EDGE_NON_SYNTHETIC); it != plan_->end (slot, rule_plan_t::EDGE_NON_SYNTHETIC); ++it)
+		Update (it->rule, last_mantissas[it->first_bid], last_mantissas[it->first_ask]);
+/* synthetics */
+	UpdateSynthetics<MATH_OP_TIMES,  true>  (slot, rule_plan_t::EDGE_FIRST_LEG_TIMES);
+	UpdateSynthetics<MATH_OP_DIVIDE, true>  (slot, rule_plan_t::EDGE_FIRST_LEG_DIVIDE);
+	UpdateSynthetics<MATH_OP_TIMES,  false> (slot, rule_plan_t::EDGE_SECOND_LEG_TIMES);
+	UpdateSynthetics<MATH_OP_DIVIDE, false> (slot, rule_plan_t::EDGE_SECOND_LEG_DIVIDE);
+}
+
+void
+query_t::ClearRules()
+{
+	std::fill (high_.begin(), high_.end(), 0);
+	std::fill (low_.begin(), low_.end(), 0);
+	std::fill (quotient_high_.begin(), quotient_high_.end(), 0.0);
+	std::fill (quotient_low_.begin(), quotient_low_.end(), 0.0);
+	std::fill (rule_is_null_.begin(), rule_is_null_.end(), true);
+}
+
+void
+query_t::ClearLegs()
+{
+	std::fill (last_values_.begin(), last_values_.end(), 0.0);
+	std::fill (last_mantissas_.begin(), last_mantissas_.end(), 0);
+	std::fill (is_null_.begin(), is_null_.end(), true);
+}
+
+void
+query_t::Save (
+	size_t rule_index
+	)
+{
+	hilo_t*const query_item = query_[rule_index].get();
+	const bnymellon::mantissa_t high = is_quotient_[rule_index] ? bnymellon::mantissa (quotient_high_[rule_index]) : high_[rule_index];
+	const bnymellon::mantissa_t low  = is_quotient_[rule_index] ? bnymellon::mantissa (quotient_low_[rule_index])  : low_[rule_index];
+	query_item->high    = bnymellon::price (high);
+	query_item->low     = bnymellon::price (low);
+	query_item->high_mantissa = high;
+	query_item->low_mantissa  = low;
+	query_item->is_null = 0 != rule_is_null_[rule_index];
+	query_item->has_mantissa  = true;
+
+	const rule_plan_t::rule_t& slots = plan_->GetRule (rule_index);
+	const double*const first_leg = GetLastValues (slots.first);
+	query_item->legs.first.is_null  = 0 != is_null_[slots.first];
+	query_item->legs.first.last_bid = first_leg[slots.first_bid];
+	query_item->legs.first.last_ask = first_leg[slots.first_ask];
+
+	if (!query_item->is_synthetic) return;
+
+	const double*const second_leg = GetLastValues (slots.second);
+	query_item->legs.second.is_null  = 0 != is_null_[slots.second];
+	query_item->legs.second.last_bid = second_leg[slots.second_bid];
+	query_item->legs.second.last_ask = second_leg[slots.second_ask];
+}
+
+void
+query_t::Save()
+{
+	for (size_t rule_index = 0; rule_index < query_.size(); ++rule_index)
+		Save (rule_index);
+}
+
+bool
+get_hilo (
+	const std::vector<std::shared_ptr<hilo_t>>& query,
+	__time32_t	from,
+	__time32_t	till,
+	const scan_options_t& options
+	)
+{
+	return ScanWindow<query_t> (query, from, till, options);
+}
+
+bool
+get_hilo (
+	const std::vector<std::shared_ptr<hilo_t>>& query,
+	__time32_t	start,
+	__time32_t	end,
+	int		interval_seconds,
+	bool		is_carry_legs,
+	std::vector<std::vector<bar_t>>* bars,
+	const scan_options_t& options
+	)
+{
+	return ScanBuckets<query_t> (query, start, end, interval_seconds, is_carry_legs, bars, options);
+}
+
+} // namespace fixed_point
+
+bool
+ParseEngine (
+	const std::string& name,
+	int*		engine
+	)
+{
+	if (name.empty() || 0 == name.compare ("single_iterator"))
+		*engine = ENGINE_SINGLE_ITERATOR;
+	else if (0 == name.compare ("vectorized"))
+		*engine = ENGINE_VECTORIZED;
+	else if (0 == name.compare ("fixed_point"))
+		*engine = ENGINE_FIXED_POINT;
+	else
+		return false;
+	return true;
+}
+
+bool
+get_hilo (
+	int		engine,
+	const std::vector<std::shared_ptr<hilo_t>>& query,
+	__time32_t	from,
+	__time32_t	till,
+	const scan_options_t& options
+	)
+{
+	switch (engine) {
+	case ENGINE_VECTORIZED:
+		return vectorized::get_hilo (query, from, till, options);
+	case ENGINE_FIXED_POINT:
+		return fixed_point::get_hilo (query, from, till, options);
+	default:
+		return single_iterator::get_hilo (query, from, till, options);
+	}
+}
+
+bool
+get_hilo (
+	int		engine,
+	const std::vector<std::shared_ptr<hilo_t>>& query,
+	__time32_t	start,
+	__time32_t	end,
+	int		interval_seconds,
+	bool		is_carry_legs,
+	std::vector<std::vector<bar_t>>* bars,
+	const scan_options_t& options
+	)
+{
+	switch (engine) {
+	case ENGINE_VECTORIZED:
+		return vectorized::get_hilo (query, start, end, interval_seconds, is_carry_legs, bars, options);
+	case ENGINE_FIXED_POINT:
+		return fixed_point::get_hilo (query, start, end, interval_seconds, is_carry_legs, bars, options);
+	default:
+		return single_iterator::get_hilo (query, start, end, interval_seconds, is_carry_legs, bars, options);
+	}
+}
+
+namespace {
+
+/* Cursor over every leg symbol, fields are bound as the cursor requires but
+ * never read and ticks are only counted by timestamp.
+ */
+class watermark_query_t : boost::noncopyable
+{
+public:
+	explicit watermark_query_t (const std::shared_ptr<const rule_plan_t>& plan) :
+		plan_ (plan),
+		symbol_set_ (plan->GetSymbolSet()),
+		fields_ (plan->GetFieldCount())
+	{
+	}
+
+	template <class Cursor>
+	bool Open (Cursor* cursor, __time32_t from, __time32_t till) {
+		return cursor->Open (symbol_set_, plan_->GetFieldMap(), &fields_, from, till);
+	}
+
+	void OnTick (const char*) {}
+
+	const std::shared_ptr<const rule_plan_t> plan_;
+	std::set<std::string> symbol_set_;
+	std::vector<double> fields_;
+};
+
+} /* anonymous namespace */
+
+bool
+get_watermarks (
+	const std::vector<std::shared_ptr<hilo_t>>& query,
+	__time32_t	start,
+	__time32_t	end,
+	int		interval_seconds,
+	std::vector<watermark_t>* watermarks,
+	const scan_options_t& options
+	)
+{
+	DLOG(INFO) << "get_watermarks(start=" << start << " end=" << end << " interval=" << interval_seconds << ")";
+	CHECK (interval_seconds > 0);
+	CHECK (nullptr != watermarks);
+
+	const std::shared_ptr<const rule_plan_t> plan (rule_plan_t::Get (query));
+	const size_t bucket_count = (end > start) ? ((end - start) / interval_seconds) : 0;
+	const __time32_t till = start + static_cast<__time32_t> (bucket_count * interval_seconds);
+	watermarks->assign (bucket_count, watermark_t());
+	if (0 == bucket_count)
+		return true;
+
+	watermark_query_t query_expression (plan);
+	auto OnTime = [&](__time32_t timestamp) -> bool {
+		const size_t bucket = static_cast<size_t> ((timestamp - start) / interval_seconds);
+		if (timestamp < start || bucket >= bucket_count)
+			return false;
+		(*watermarks)[bucket].Add (timestamp);
+		return true;
+	};
+	scan_options_t scan_options (options);
+	scan_options.cache = nullptr;
+	scan_options.is_record = false;
+	return Scan<true> (&query_expression, query, start, till, scan_options, OnTime);
+}
+
+/* Time partitioned implementation.
+ */
+namespace partitioned {
+
+/* One time range of the window scanned without the leg state before it.  A
+ * synthetic tick whose other leg has not ticked within the partition depends on
+ * that state, the leg prices are kept in order as a prefix for the merge.
+ */
+class partition_t : boost::noncopyable
+{
+public:
+	explicit partition_t (const std::shared_ptr<const rule_plan_t>& plan);
+
+	template <class Cursor>
+	bool Open (Cursor* cursor, __time32_t from, __time32_t till) {
+		return cursor->Open (symbol_set_, plan_->GetFieldMap(), &fields_, from, till);
+	}
+	void OnTick (const char* symbol_name);
+
+	const std::shared_ptr<const rule_plan_t> plan_;
+	const size_t field_count_;
+	symbol_index_t symbol_index_;
+	std::set<std::string> symbol_set_;
+	std::vector<double> fields_;
+/* high-low of every rule from ticks within the partition only. */
+	std::unique_ptr<hilo_t[]> rules_;
+/* prefix bid and ask pairs per synthetic rule and whether of the first leg. */
+	std::vector<std::vector<double>> prefix_;
+	std::vector<char> is_first_prefix_;
+/* leg state at the partition end. */
+	std::vector<double> last_values_;
+	std::vector<char> is_null_;
+
+private:
+	template <int MathOp, bool IsFirstLeg>
+	void UpdateSynthetics (size_t slot, int group);
+};
+
+partition_t::partition_t (
+	const std::shared_ptr<const rule_plan_t>& plan
+	) :
+	plan_ (plan),
+	field_count_ (plan->GetFieldCount()),
+	symbol_set_ (plan->GetSymbolSet()),
+	fields_ (plan->GetFieldCount()),
+	rules_ (new hilo_t[plan->GetRuleCount()]),
+	prefix_ (plan->GetRuleCount()),
+	is_first_prefix_ (plan->GetRuleCount(), 0),
+	last_values_ (plan->GetSymbolCount() * plan->GetFieldCount(), 0.0),
+	is_null_ (plan->GetSymbolCount(), 1)
+{
+	for (size_t slot = 0; slot < plan_->GetSymbolCount(); ++slot) {
+		const size_t index = symbol_index_.Insert (plan_->GetSymbolId (slot));
+		DCHECK (index == slot);
+	}
+}
+
+template <int MathOp, bool IsFirstLeg>
+void
+partition_t::UpdateSynthetics (
+	size_t		slot,
+	int		group
+	)
+{
+	const double*const values = last_values_.data() + (slot * field_count_);
+	for (const rule_plan_t::edge_t* it = plan_->begin (slot, group); it != plan_->end (slot, group); ++it)
+	{
+		if (is_null_[it->other]) {
+/* consecutive equal prices fold to the same synthetic */
+			const double bid = IsFirstLeg ? values[it->first_bid] : values[it->second_bid];
+			const double ask = IsFirstLeg ? values[it->first_ask] : values[it->second_ask];
+			std::vector<double>& prefix = prefix_[it->rule];
+			if (prefix.empty() || prefix[prefix.size() - 2] != bid || prefix[prefix.size() - 1] != ask) {
+				prefix.push_back (bid);
+				prefix.push_back (ask);
+			}
+			is_first_prefix_[it->rule] = IsFirstLeg;
+			continue;
+		}
+		const double*const other = last_values_.data() + (it->other * field_count_);
+		const double*const first_leg  = IsFirstLeg ? values : other;
+		const double*const second_leg = IsFirstLeg ? other : values;
+		UpdateSynthetic<MathOp> (&rules_[it->rule],
+					 first_leg[it->first_bid],
+					 first_leg[it->first_ask],
+					 second_leg[it->second_bid],
+					 second_leg[it->second_ask]);
+	}
+}
+
+void
+partition_t::OnTick (
+	const char* symbol_name
+	)
+{
+	const size_t slot = symbol_index_.Find (symbol_name);
+	if (symbol_index_t::npos == slot) {
+		LOG(WARNING) << "Unexpected symbol \"" << symbol_name << "\" in cursor.";
+		return;
+	}
+/* non-synthetic */
+	for (const rule_plan_t::edge_t* it = plan_->begin (slot, rule_plan_t::EDGE_NON_SYNTHETIC); it != plan_->end (slot, rule_plan_t::EDGE_NON_SYNTHETIC); ++it)
+	{
+		hilo_t*const rule = &rules_[it->rule];
+		const double bid_price = fields_[it->first_bid], ask_price = fields_[it->first_ask];
+		if (rule->is_null) {
+			rule->is_null = false;
+			rule->low     = bid_price;
+			rule->high    = ask_price;
+			continue;
+		}
+		if (bid_price < rule->low)  rule->low  = bid_price;
+		if (ask_price > rule->high) rule->high = ask_price;
+	}
+/* synthetics */
+	is_null_[slot] = false;
+	double*const last_values = last_values_.data() + (slot * field_count_);
+	for (const uint32_t* field = plan_->field_begin (slot); field != plan_->field_end (slot); ++field)
+		last_values[*field] = fields_[*field];
+	UpdateSynthetics<MATH_OP_TIMES,  true>  (slot, rule_plan_t::EDGE_FIRST_LEG_TIMES);
+	UpdateSynthetics<MATH_OP_DIVIDE, true>  (slot, rule_plan_t::EDGE_FIRST_LEG_DIVIDE);
+	UpdateSynthetics<MATH_OP_TIMES,  false> (slot, rule_plan_t::EDGE_SECOND_LEG_TIMES);
+	UpdateSynthetics<MATH_OP_DIVIDE, false> (slot, rule_plan_t::EDGE_SECOND_LEG_DIVIDE);
+}
+
+/* Fold partition high-low into the rule as if its ticks followed. */
+static inline
+void
+Merge (
+	hilo_t*const	rule,
+	const hilo_t&	partition
+	)
+{
+	if (partition.is_null)
+		return;
+	if (rule->is_null) {
+		rule->is_null = false;
+		rule->low     = partition.low;
+		rule->high    = partition.high;
+		return;
+	}
+	if (partition.low < rule->low)   rule->low  = partition.low;
+	if (partition.high > rule->high) rule->high = partition.high;
+}
+
+/* Apply the prefix of one synthetic rule with the other leg carried from the
+ * previous partitions.
+ */
+template <int MathOp>
+static
+void
+ApplyPrefix (
+	hilo_t*const	rule,
+	const rule_plan_t::rule_t& slots,
+	const std::vector<double>& prefix,
+	bool		is_first_prefix,
+	const double*	first_leg,
+	const double*	second_leg
+	)
+{
+	for (size_t i = 0; i < prefix.size(); i += 2) {
+		if (is_first_prefix)
+			UpdateSynthetic<MathOp> (rule, prefix[i], prefix[i + 1], second_leg[slots.second_bid], second_leg[slots.second_ask]);
+		else
+			UpdateSynthetic<MathOp> (rule, first_leg[slots.first_bid], first_leg[slots.first_ask], prefix[i], prefix[i + 1]);
+	}
+}
+
+bool
+get_hilo (
+	thread_pool_t*	pool,
+	size_t		partition_count,
+	const std::vector<std::shared_ptr<hilo_t>>& query,
+	__time32_t	from,
+	__time32_t	till,
+	const scan_options_t& options
+	)
+{
+	CHECK (nullptr != pool);
+	if (till <= from)
+		return true;
+	partition_count = std::max (std::min (partition_count, static_cast<size_t> (till - from)), (size_t)1);
+
+	DLOG(INFO) << "get_hilo(from=" << from << " till=" << till << ") #" << partition_count << " partitions.";
+
+	const std::shared_ptr<const rule_plan_t> plan (rule_plan_t::Get (query));
+	std::vector<std::unique_ptr<partition_t>> partitions (partition_count);
+	std::vector<char> is_open (partition_count, 0);
+	{
+		task_group_t tasks (pool);
+		for (size_t i = 0; i < partition_count; ++i) {
+			const __time32_t partition_from = from + static_cast<__time32_t> (((till - from) * (int64_t)i) / partition_count);
+			const __time32_t partition_till = from + static_cast<__time32_t> (((till - from) * (int64_t)(i + 1)) / partition_count);
+			partitions[i].reset (new partition_t (plan));
+			partition_t* partition = partitions[i].get();
+			char* partition_is_open = &is_open[i];
+			tasks.Post ([&query, &options, partition, partition_from, partition_till, partition_is_open]() {
+				auto OnTime = [](__time32_t) -> bool { return true; };
+				*partition_is_open = Scan<false> (partition, query, partition_from, partition_till, options, OnTime) ? 1 : 0;
+			});
+		}
+		tasks.Wait();
+	}
+	if (std::find (is_open.begin(), is_open.end(), 0) != is_open.end()) {
+		LOG(WARNING) << "Partition cursor failed to open.";
+		return false;
+	}
+
+/* leg state before the window as per single_iterator::query_t */
+	const size_t field_count = plan->GetFieldCount();
+	std::vector<double> last_values (plan->GetSymbolCount() * field_count, 0.0);
+	std::vector<char> is_null (plan->GetSymbolCount(), -1);
+	for (size_t rule_index = 0; rule_index < query.size(); ++rule_index) {
+		const hilo_t& rule = *query[rule_index].get();
+		const rule_plan_t::rule_t& slots = plan->GetRule (rule_index);
+		if (-1 == is_null[slots.first])
+			is_null[slots.first] = rule.legs.first.is_null;
+		last_values[(slots.first * field_count) + slots.first_bid] = rule.legs.first.last_bid;
+		last_values[(slots.first * field_count) + slots.first_ask] = rule.legs.first.last_ask;
+		if (symbol_index_t::npos == slots.second)
+			continue;
+		if (-1 == is_null[slots.second])
+			is_null[slots.second] = rule.legs.second.is_null;
+		last_values[(slots.second * field_count) + slots.second_bid] = rule.legs.second.last_bid;
+		last_values[(slots.second * field_count) + slots.second_ask] = rule.legs.second.last_ask;
+	}
+
+/* merge in time order, prefix ticks of a rule precede its partition high-low */
+	std::for_each (partitions.begin(), partitions.end(), [&](const std::unique_ptr<partition_t>& partition) {
+		for (size_t rule_index = 0; rule_index < query.size(); ++rule_index) {
+			hilo_t*const rule = query[rule_index].get();
+			const std::vector<double>& prefix = partition->prefix_[rule_index];
+			if (!prefix.empty()) {
+				const rule_plan_t::rule_t& slots = plan->GetRule (rule_index);
+				const bool is_first_prefix = 0 != partition->is_first_prefix_[rule_index];
+				if (!is_null[is_first_prefix ? slots.second : slots.first]) {
+					const double*const first_leg  = last_values.data() + (slots.first * field_count);
+					const double*const second_leg = last_values.data() + (slots.second * field_count);
+					if (MATH_OP_TIMES == GetSyntheticOp (*rule))
+						ApplyPrefix<MATH_OP_TIMES>  (rule, slots, prefix, is_first_prefix, first_leg, second_leg);
+					else
+						ApplyPrefix<MATH_OP_DIVIDE> (rule, slots, prefix, is_first_prefix, first_leg, second_leg);
+				}
+			}
+			Merge (rule, partition->rules_[rule_index]);
+		}
+		for (size_t slot = 0; slot < plan->GetSymbolCount(); ++slot) {
+			if (partition->is_null_[slot])
+				continue;
+			is_null[slot] = false;
+			for (const uint32_t* field = plan->field_begin (slot); field != plan->field_end (slot); ++field)
+				last_values[(slot * field_count) + *field] = partition->last_values_[(slot * field_count) + *field];
+		}
+	});
+
+/* leg state at the window end */
+	for (size_t rule_index = 0; rule_index < query.size(); ++rule_index) {
+		hilo_t*const rule = query[rule_index].get();
+		const rule_plan_t::rule_t& slots = plan->GetRule (rule_index);
+		rule->has_mantissa = false;
+		rule->legs.first.is_null  = 0 != is_null[slots.first];
+		rule->legs.first.last_bid = last_values[(slots.first * field_count) + slots.first_bid];
+		rule->legs.first.last_ask = last_values[(slots.first * field_count) + slots.first_ask];
+		if (!rule->is_synthetic)
+			continue;
+		rule->legs.second.is_null  = 0 != is_null[slots.second];
+		rule->legs.second.last_bid = last_values[(slots.second * field_count) + slots.second_bid];
+		rule->legs.second.last_ask = last_values[(slots.second * field_count) + slots.second_ask];
+	}
+
+	DLOG(INFO) << "get_hilo() finished.";
+	return true;
+}
+
+/* Copy of the rule definition and state for a concurrent scan. */
+static
+std::shared_ptr<hilo_t>
+CloneRule (
+	const hilo_t&	rule
+	)
+{
+	std::shared_ptr<hilo_t> clone (CopyRule (rule));
+	bar_t (rule).Restore (clone.get());
+	return clone;
+}
+
+bool
+get_hilo (
+	int		engine,
+	thread_pool_t*	pool,
+	size_t		partition_count,
+	const std::vector<std::shared_ptr<hilo_t>>& query,
+	__time32_t	start,
+	__time32_t	end,
+	int		interval_seconds,
+	std::vector<std::vector<bar_t>>* bars,
+	const scan_options_t& options
+	)
+{
+	CHECK (nullptr != pool);
+	CHECK (interval_seconds > 0);
+	CHECK (nullptr != bars);
+	const size_t bucket_count = (end > start) ? ((end - start) / interval_seconds) : 0;
+	partition_count = std::max (std::min (partition_count, bucket_count), (size_t)1);
+
+	DLOG(INFO) << "get_hilo(start=" << start << " end=" << end << " interval=" << interval_seconds << ") #" << partition_count << " partitions.";
+
+/* legs reset each interval so partitions on interval boundaries are independent */
+	std::vector<std::vector<std::shared_ptr<hilo_t>>> partition_queries (partition_count);
+	std::vector<std::vector<std::vector<bar_t>>> partition_bars (partition_count);
+	std::vector<std::vector<watermark_t>> partition_marks (partition_count);
+	std::vector<char> is_open (partition_count, 0);
+	{
+		task_group_t tasks (pool);
+		for (size_t i = 0; i < partition_count; ++i) {
+			const __time32_t partition_start = start + static_cast<__time32_t> (((bucket_count * i) / partition_count) * interval_seconds);
+			const __time32_t partition_end   = start + static_cast<__time32_t> (((bucket_count * (i + 1)) / partition_count) * interval_seconds);
+			std::vector<std::shared_ptr<hilo_t>>& partition_query = partition_queries[i];
+			std::for_each (query.begin(), query.end(), [&partition_query](const std::shared_ptr<hilo_t>& it) {
+				partition_query.push_back (CloneRule (*it.get()));
+			});
+			std::vector<std::vector<bar_t>>* partition_bar = &partition_bars[i];
+			scan_options_t partition_options (options);
+			if (nullptr != options.watermarks)
+				partition_options.watermarks = &partition_marks[i];
+			char* partition_is_open = &is_open[i];
+			tasks.Post ([=, &partition_query]() {
+				*partition_is_open = hilo::get_hilo (engine, partition_query, partition_start, partition_end, interval_seconds, false /* reset legs */, partition_bar, partition_options) ? 1 : 0;
+			});
+		}
+		tasks.Wait();
+	}
+	if (std::find (is_open.begin(), is_open.end(), 0) != is_open.end()) {
+		LOG(WARNING) << "Partition cursor failed to open.";
+		return false;
+	}
+
+	bars->resize (query.size());
+	for (size_t rule_index = 0; rule_index < query.size(); ++rule_index) {
+		std::vector<bar_t>& rule_bars = (*bars)[rule_index];
+		rule_bars.clear();
+		rule_bars.reserve (bucket_count);
+		std::for_each (partition_bars.begin(), partition_bars.end(), [&](const std::vector<std::vector<bar_t>>& partition_bar) {
+			rule_bars.insert (rule_bars.end(), partition_bar[rule_index].begin(), partition_bar[rule_index].end());
+		});
+/* rule holds the last interval */
+		bar_t (*partition_queries.back()[rule_index].get()).Restore (query[rule_index].get());
+	}
+	if (nullptr != options.watermarks) {
+		options.watermarks->clear();
+		std::for_each (partition_marks.begin(), partition_marks.end(), [&options](const std::vector<watermark_t>& marks) {
+			options.watermarks->insert (options.watermarks->end(), marks.begin(), marks.end());
+		});
+	}
+	return true;
+}
+
+} // namespace partitioned
+
+/* Sharded implementation.
+ */
+namespace sharded {
+
+/* Shortest time partition of a window scanned in parallel. */
+static const __time32_t kMinPartitionSeconds = 30 * 60;
+
+/* Time partitions of [from, till) when symbol components alone cannot occupy
+ * the pool, zero to scan by component.  Partitions do not record into the
+ * tick cache.
+ */
+static
+size_t
+TimePartitionCount (
+	thread_pool_t*	pool,
+	size_t		shard_count,
+	size_t		chunk_symbols,
+	size_t		component_count,
+	__time32_t	from,
+	__time32_t	till,
+	const scan_options_t& options
+	)
+{
+	if (nullptr == pool || chunk_symbols > 0 || options.is_record || component_count >= shard_count)
+		return 0;
+	if (till <= from || (till - from) < (2 * kMinPartitionSeconds))
+		return 0;
+	return std::min (shard_count, static_cast<size_t> ((till - from) / kMinPartitionSeconds));
+}
+
+/* Rule indices per connected component of the leg symbol graph, rules sharing
+ * a leg symbol directly or through other rules are in the same component.
+ * Components in order of first rule with their symbol counts.
+ */
+static
+void
+Components (
+	const std::vector<std::shared_ptr<hilo_t>>& query,
+	std::vector<std::vector<size_t>>* components,
+	std::vector<size_t>* symbol_counts
+	)
+{
+	std::unordered_map<std::string, size_t> symbol_map;
+	std::vector<size_t> parent;
+	auto Find = [&parent](size_t i) -> size_t {
+		while (parent[i] != i) {
+			parent[i] = parent[parent[i]];
+			i = parent[i];
+		}
+		return i;
+	};
+	auto Insert = [&](const std::string& symbol_name) -> size_t {
+		auto it = symbol_map.find (symbol_name);
+		if (symbol_map.end() != it)
+			return it->second;
+		const size_t node = parent.size();
+		parent.push_back (node);
+		symbol_map.emplace (std::make_pair (symbol_name, node));
+		return node;
+	};
+
+	std::vector<size_t> rule_node (query.size());
+	for (size_t rule_index = 0; rule_index < query.size(); ++rule_index) {
+		const hilo_t& rule = *query[rule_index].get();
+		const size_t first = Insert (rule.legs.first.symbol_name);
+		rule_node[rule_index] = first;
+		if (rule.is_synthetic) {
+			const size_t second = Find (Insert (rule.legs.second.symbol_name));
+			const size_t root = Find (first);
+			if (root != second)
+				parent[second] = root;
+		}
+	}
+
+/* components in order of first rule for a stable assignment */
+	std::unordered_map<size_t, size_t> component_map;
+	for (size_t rule_index = 0; rule_index < query.size(); ++rule_index) {
+		const size_t root = Find (rule_node[rule_index]);
+		auto it = component_map.find (root);
+		if (component_map.end() == it) {
+			it = component_map.emplace (std::make_pair (root, components->size())).first;
+			components->push_back (std::vector<size_t>());
+		}
+		(*components)[it->second].push_back (rule_index);
+	}
+	symbol_counts->assign (components->size(), 0);
+	for (size_t node = 0; node < parent.size(); ++node)
+		++(*symbol_counts)[component_map[Find (node)]];
+}
+
+/* Component indices per cursor.  With chunk_symbols components are packed
+ * largest first into the first cursor with room, a component larger than the
+ * limit takes a cursor of its own.  Otherwise components are assigned largest
+ * first to the least loaded of shard_count cursors.  Empty cursors are
+ * dropped.
+ */
+static
+void
+Partition (
+	const std::vector<std::vector<size_t>>& components,
+	const std::vector<size_t>& symbol_counts,
+	size_t		shard_count,
+	size_t		chunk_symbols,
+	std::vector<std::vector<size_t>>* chunks
+	)
+{
+	std::vector<size_t> order (components.size());
+	for (size_t i = 0; i < order.size(); ++i)
+		order[i] = i;
+
+	if (chunk_symbols > 0) {
+		std::stable_sort (order.begin(), order.end(), [&symbol_counts](size_t lhs, size_t rhs) {
+			return symbol_counts[lhs] > symbol_counts[rhs];
+		});
+		std::vector<size_t> chunk_size;
+		std::for_each (order.begin(), order.end(), [&](size_t component) {
+			size_t chunk = 0;
+			while (chunk < chunks->size() && (chunk_size[chunk] + symbol_counts[component]) > chunk_symbols)
+				++chunk;
+			if (chunk == chunks->size()) {
+				chunks->push_back (std::vector<size_t>());
+				chunk_size.push_back (0);
+			}
+			(*chunks)[chunk].push_back (component);
+			chunk_size[chunk] += symbol_counts[component];
+		});
+	} else {
+		std::stable_sort (order.begin(), order.end(), [&components](size_t lhs, size_t rhs) {
+			return components[lhs].size() > components[rhs].size();
+		});
+		chunks->assign (std::min (std::max (shard_count, (size_t)1), components.size()), std::vector<size_t>());
+		std::vector<size_t> chunk_size (chunks->size(), 0);
+		std::for_each (order.begin(), order.end(), [&](size_t component) {
+			const size_t chunk = std::min_element (chunk_size.begin(), chunk_size.end()) - chunk_size.begin();
+			(*chunks)[chunk].push_back (component);
+			chunk_size[chunk] += components[component].size();
+		});
+	}
+}
+
+/* Run every chunk as its own cursor, Run (rules, options) returns false if a
+ * tick source failed, a window without ticks is not a failure.  Chunks hold
+ * disjoint rules so results are written in place.  A failed chunk is restored
+ * to the rule state before the query and split in half by component for the
+ * next round.
+ */
+template <class Run>
+bool
+RunChunks (
+	thread_pool_t*	pool,
+	const std::vector<std::shared_ptr<hilo_t>>& query,
+	const std::vector<std::vector<size_t>>& components,
+	std::vector<std::vector<size_t>> chunks,
+	const scan_options_t& options,
+	Run		run
+	)
+{
+	std::vector<bar_t> snapshot;
+	snapshot.reserve (query.size());
+	std::for_each (query.begin(), query.end(), [&snapshot](const std::shared_ptr<hilo_t>& it) {
+		snapshot.push_back (bar_t (*it.get()));
+	});
+
+	unsigned stream = 0;
+	size_t failed_count = 0;
+	while (!chunks.empty()) {
+		std::vector<std::vector<size_t>> chunk_rules (chunks.size());
+		std::vector<char> is_open (chunks.size(), 0);
+		{
+			std::unique_ptr<task_group_t> tasks;
+			if (nullptr != pool && chunks.size() > 1)
+				tasks.reset (new task_group_t (pool));
+			for (size_t i = 0; i < chunks.size(); ++i) {
+				std::vector<size_t>& rules = chunk_rules[i];
+				std::for_each (chunks[i].begin(), chunks[i].end(), [&](size_t component) {
+					rules.insert (rules.end(), components[component].begin(), components[component].end());
+				});
+/* query order within each chunk */
+				std::sort (rules.begin(), rules.end());
+				scan_options_t chunk_options (options);
+				chunk_options.stream = stream++;
+				char* chunk_is_open = &is_open[i];
+				auto task = [&run, &rules, chunk_options, chunk_is_open]() {
+					*chunk_is_open = run (rules, chunk_options) ? 1 : 0;
+				};
+				if ((bool)tasks)
+					tasks->Post (task);
+				else
+					task();
+			}
+			if ((bool)tasks)
+				tasks->Wait();
+		}
+
+		std::vector<std::vector<size_t>> retry;
+		for (size_t i = 0; i < chunks.size(); ++i) {
+			if (is_open[i])
+				continue;
+			if (chunks[i].size() < 2) {
+				DVLOG(1) << "Cursor failed on isolated component of #" << chunk_rules[i].size() << " rules, first rule " << query[chunk_rules[i].front()]->name << ".";
+				++failed_count;
+				continue;
+			}
+			std::for_each (chunk_rules[i].begin(), chunk_rules[i].end(), [&](size_t rule_index) {
+				snapshot[rule_index].Restore (query[rule_index].get());
+			});
+			const size_t half = chunks[i].size() / 2;
+			retry.push_back (std::vector<size_t> (chunks[i].begin(), chunks[i].begin() + half));
+			retry.push_back (std::vector<size_t> (chunks[i].begin() + half, chunks[i].end()));
+		}
+		if (!retry.empty())
+			DLOG(INFO) << "Retrying #" << retry.size() << " split cursors.";
+		chunks.swap (retry);
+	}
+	if (failed_count > 0)
+		LOG(WARNING) << "#" << failed_count << " of #" << components.size() << " rule components without an open cursor.";
+	return 0 == failed_count;
+}
+
+bool
+get_hilo (
+	int		engine,
+	thread_pool_t*	pool,
+	size_t		shard_count,
+	size_t		chunk_symbols,
+	const std::vector<std::shared_ptr<hilo_t>>& query,
+	__time32_t	from,
+	__time32_t	till,
+	const scan_options_t& options
+	)
+{
+	std::vector<std::vector<size_t>> components, chunks;
+	std::vector<size_t> symbol_counts;
+	Components (query, &components, &symbol_counts);
+/* long window over few components, fall back to components if a partition fails */
+	const size_t partition_count = (ENGINE_SINGLE_ITERATOR == engine) ? TimePartitionCount (pool, shard_count, chunk_symbols, components.size(), from, till, options) : 0;
+	if (partition_count > 1) {
+		if (partitioned::get_hilo (pool, partition_count, query, from, till, options))
+			return true;
+		LOG(WARNING) << "Time partitioned scan failed, scanning by component.";
+	}
+/* one cursor cannot isolate a failure */
+	if (components.size() < 2)
+		return hilo::get_hilo (engine, query, from, till, options);
+	Partition (components, symbol_counts, nullptr != pool ? shard_count : 1, chunk_symbols, &chunks);
+
+	DLOG(INFO) << "get_hilo(from=" << from << " till=" << till << ") #" << chunks.size() << " cursors.";
+
+	return RunChunks (pool, query, components, chunks, options, [&](const std::vector<size_t>& rules, const scan_options_t& chunk_options) -> bool {
+		std::vector<std::shared_ptr<hilo_t>> chunk_query;
+		chunk_query.reserve (rules.size());
+		std::for_each (rules.begin(), rules.end(), [&](size_t rule_index) {
+			chunk_query.push_back (query[rule_index]);
+		});
+		return hilo::get_hilo (engine, chunk_query, from, till, chunk_options);
+	});
+}
+
+bool
+get_hilo (
+	int		engine,
+	thread_pool_t*	pool,
+	size_t		shard_count,
+	size_t		chunk_symbols,
+	const std::vector<std::shared_ptr<hilo_t>>& query,
+	__time32_t	start,
+	__time32_t	end,
+	int		interval_seconds,
+	bool		is_carry_legs,
+	std::vector<std::vector<bar_t>>* bars,
+	const scan_options_t& options
+	)
+{
+	std::vector<std::vector<size_t>> components, chunks;
+	std::vector<size_t> symbol_counts;
+	Components (query, &components, &symbol_counts);
+/* without carried legs intervals are independent for every engine */
+	const __time32_t till = (end > start) ? (start + static_cast<__time32_t> (((end - start) / interval_seconds) * interval_seconds)) : start;
+	const size_t partition_count = is_carry_legs ? 0 : TimePartitionCount (pool, shard_count, chunk_symbols, components.size(), start, till, options);
+	if (partition_count > 1) {
+		if (partitioned::get_hilo (engine, pool, partition_count, query, start, end, interval_seconds, bars, options))
+			return true;
+		LOG(WARNING) << "Time partitioned scan failed, scanning by component.";
+	}
+	if (components.size() < 2)
+		return hilo::get_hilo (engine, query, start, end, interval_seconds, is_carry_legs, bars, options);
+	Partition (components, symbol_counts, nullptr != pool ? shard_count : 1, chunk_symbols, &chunks);
+
+	DLOG(INFO) << "get_hilo(start=" << start << " end=" << end << " interval=" << interval_seconds << ") #" << chunks.size() << " cursors.";
+	CHECK (interval_seconds > 0);
+	CHECK (nullptr != bars);
+
+/* chunk bars are moved into query order, a failed chunk yields null bars.
+ * Chunk watermarks are summed only for open cursors as a failed chunk is read
+ * again split.
+ */
+	const size_t bucket_count = (end > start) ? ((end - start) / interval_seconds) : 0;
+	bars->resize (query.size());
+	boost::mutex marks_lock;
+	if (nullptr != options.watermarks)
+		options.watermarks->assign (bucket_count, watermark_t());
+	const bool is_open = RunChunks (pool, query, components, chunks, options, [&](const std::vector<size_t>& rules, const scan_options_t& chunk_options) -> bool {
+		std::vector<std::shared_ptr<hilo_t>> chunk_query;
+		chunk_query.reserve (rules.size());
+		std::for_each (rules.begin(), rules.end(), [&](size_t rule_index) {
+			chunk_query.push_back (query[rule_index]);
+		});
+		std::vector<std::vector<bar_t>> chunk_bars;
+		std::vector<watermark_t> chunk_marks;
+		scan_options_t marks_options (chunk_options);
+		if (nullptr != options.watermarks)
+			marks_options.watermarks = &chunk_marks;
+		const bool is_chunk_open = hilo::get_hilo (engine, chunk_query, start, end, interval_seconds, is_carry_legs, &chunk_bars, marks_options);
+		if (is_chunk_open && nullptr != options.watermarks) {
+			boost::lock_guard<boost::mutex> lock (marks_lock);
+			for (size_t i = 0; i < chunk_marks.size() && i < bucket_count; ++i)
+				(*options.watermarks)[i] += chunk_marks[i];
+		}
+		for (size_t j = 0; j < rules.size(); ++j) {
+			std::vector<bar_t>& rule_bars = (*bars)[rules[j]];
+			if (j < chunk_bars.size())
+				rule_bars.swap (chunk_bars[j]);
+			else
+				rule_bars.clear();
+			if (rule_bars.size() != bucket_count) {
+				LOG(WARNING) << "Cursor returned #" << rule_bars.size() << " bars, expecting #" << bucket_count << ".";
+				rule_bars.resize (bucket_count);
+			}
+		}
+		return is_chunk_open;
+	});
+	return is_open;
+}
+
+} // namespace sharded
+
 } // namespace hilo
 
 /* eof */
@@ -5,6 +5,8 @@
 #define __GET_HILO_HH__
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <unordered_map>
 #include <string>
 #include <vector>
@@ -12,8 +14,17 @@
 /* Boost noncopyable base class. */
 #include <boost/utility.hpp>
 
+#ifndef _MSC_VER
+/* Microsoft CRT 32-bit time for the stand-alone benchmarks. */
+typedef int32_t __time32_t;
+#endif
+
 namespace hilo
 {
+	class thread_pool_t;
+	class tick_cache_t;
+	class tick_source_factory_t;
+
 	enum {
 		MATH_OP_NOOP = 0,
 		MATH_OP_TIMES,
@@ -55,7 +66,9 @@ namespace hilo
 
 		void Clear() {
 			high = low = 0.0;
+			high_mantissa = low_mantissa = 0;
 			is_null = true;
+			has_mantissa = false;
 			legs.first.Clear(); legs.second.Clear();
 		}
 
@@ -64,15 +77,234 @@ namespace hilo
 		int math_op;
 		double high;
 		double low;
+/* publish mantissas as held by the fixed-point engine, valid only while
+ * has_mantissa is set, any other engine updating high or low clears it.
+ */
+		int64_t high_mantissa;
+		int64_t low_mantissa;
 		bool is_null;
+		bool has_mantissa;
 		bool is_synthetic;
 	};
 
+/* New rule with the definition of rule and cleared results. */
+	inline
+	std::shared_ptr<hilo_t>
+	CopyRule (
+		const hilo_t&	rule
+		)
+	{
+		std::shared_ptr<hilo_t> copy (new hilo_t);
+		copy->name         = rule.name;
+		copy->math_op      = rule.math_op;
+		copy->is_synthetic = rule.is_synthetic;
+		auto CopyLeg = [](const leg_t& leg, leg_t*const copy_leg) {
+			copy_leg->symbol_name   = leg.symbol_name;
+			copy_leg->bid_field     = leg.bid_field;
+			copy_leg->bid_field_idx = leg.bid_field_idx;
+			copy_leg->ask_field     = leg.ask_field;
+			copy_leg->ask_field_idx = leg.ask_field_idx;
+		};
+		CopyLeg (rule.legs.first,  &copy->legs.first);
+		CopyLeg (rule.legs.second, &copy->legs.second);
+		return copy;
+	}
+
+/* Copyable snapshot of a hilo_t result for one interval including the leg
+ * state required to resume the calculation.
+ */
+	class bar_t
+	{
+	public:
+		bar_t()
+		{
+			Clear();
+		}
+
+		explicit bar_t (const hilo_t& hilo)
+		{
+			Save (hilo);
+		}
+
+		void Clear() {
+			high = low = 0.0;
+			high_mantissa = low_mantissa = 0;
+			is_null = true;
+			has_mantissa = false;
+			first.Clear(); second.Clear();
+		}
+
+		void Save (const hilo_t& hilo) {
+			high    = hilo.high;
+			low     = hilo.low;
+			high_mantissa = hilo.high_mantissa;
+			low_mantissa  = hilo.low_mantissa;
+			is_null = hilo.is_null;
+			has_mantissa = hilo.has_mantissa;
+			first.Save (hilo.legs.first);
+			second.Save (hilo.legs.second);
+		}
+
+/* any engine may resume from the restored state, mantissas are not kept. */
+		void Restore (hilo_t*const hilo) const {
+			hilo->high    = high;
+			hilo->low     = low;
+			hilo->is_null = is_null;
+			hilo->has_mantissa = false;
+			first.Restore (&hilo->legs.first);
+			second.Restore (&hilo->legs.second);
+		}
+
+		struct leg_state_t
+		{
+			void Clear() {
+				last_bid = last_ask = 0.0;
+				is_null = true;
+			}
+			void Save (const leg_t& leg) {
+				last_bid = leg.last_bid;
+				last_ask = leg.last_ask;
+				is_null  = leg.is_null;
+			}
+			void Restore (leg_t*const leg) const {
+				leg->last_bid = last_bid;
+				leg->last_ask = last_ask;
+				leg->is_null  = is_null;
+			}
+
+			double last_bid;
+			double last_ask;
+			bool is_null;
+		};
+
+		double high;
+		double low;
+/* publish prices in bnymellon mantissa units, from the fixed-point engine
+ * or converted by bar_store_t.
+ */
+		int64_t high_mantissa;
+		int64_t low_mantissa;
+		bool is_null;
+		bool has_mantissa;
+		leg_state_t first, second;
+	};
+
+/* Ticks of every queried symbol in one interval as read from the tick store,
+ * a late insert into a closed interval changes the watermark.
+ */
+	class watermark_t
+	{
+	public:
+		watermark_t() : tick_count (0), last_time (0), time_sum (0) {}
+
+		bool operator== (const watermark_t& rhs) const {
+			return tick_count == rhs.tick_count && last_time == rhs.last_time && time_sum == rhs.time_sum;
+		}
+		bool operator!= (const watermark_t& rhs) const {
+			return !(*this == rhs);
+		}
+/* one cursor record at timestamp. */
+		void Add (__time32_t timestamp) {
+			++tick_count;
+			if (timestamp > last_time) last_time = timestamp;
+			time_sum += static_cast<uint32_t> (timestamp);
+		}
+/* marks of the same interval read by another cursor. */
+		watermark_t& operator+= (const watermark_t& rhs) {
+			tick_count += rhs.tick_count;
+			if (rhs.last_time > last_time) last_time = rhs.last_time;
+			time_sum += rhs.time_sum;
+			return *this;
+		}
+
+		uint32_t tick_count;
+		__time32_t last_time;
+/* sum of tick timestamps, catches a replaced tick with an unchanged count. */
+		uint64_t time_sum;
+	};
+
+/* Tick store and cache use of one calculation. */
+	class scan_options_t
+	{
+	public:
+		scan_options_t() : cache (nullptr), is_record (false), stream (0), source (nullptr), watermarks (nullptr) {}
+		scan_options_t (tick_cache_t* cache_, bool is_record_) : cache (cache_), is_record (is_record_), stream (0), source (nullptr), watermarks (nullptr) {}
+
+/* read windows held by the cache, or record every cursor scan into it. */
+		tick_cache_t* cache;
+		bool is_record;
+/* ordering domain of recorded symbols, one per parallel cursor. */
+		unsigned stream;
+/* cursors of every window not held by the cache, nullptr for the registered default. */
+		const tick_source_factory_t* source;
+/* watermark per interval of a bars scan as it reads, nullptr for none. */
+		std::vector<watermark_t>* watermarks;
+	};
+
 	namespace reference {
-		void get_hilo (const std::vector<std::shared_ptr<hilo_t>>& hilo, __time32_t start, __time32_t end);
+		void get_hilo (const std::vector<std::shared_ptr<hilo_t>>& hilo, __time32_t start, __time32_t end, const scan_options_t& options = scan_options_t());
 	}
+/* False if a tick source cursor could not open, rules keep the ticks of
+ * every other cursor.
+ */
 	namespace single_iterator {
-		void get_hilo (const std::vector<std::shared_ptr<hilo_t>>& hilo, __time32_t start, __time32_t end);
+		bool get_hilo (const std::vector<std::shared_ptr<hilo_t>>& hilo, __time32_t start, __time32_t end, const scan_options_t& options = scan_options_t());
+/* one cursor over [start, end) bucketed into bars[rule][interval]. */
+		bool get_hilo (const std::vector<std::shared_ptr<hilo_t>>& hilo, __time32_t start, __time32_t end, int interval_seconds, bool is_carry_legs, std::vector<std::vector<bar_t>>* bars, const scan_options_t& options = scan_options_t());
+	}
+/* single cursor with struct-of-arrays rule state and SIMD fan-out. */
+	namespace vectorized {
+		bool get_hilo (const std::vector<std::shared_ptr<hilo_t>>& hilo, __time32_t start, __time32_t end, const scan_options_t& options = scan_options_t());
+		bool get_hilo (const std::vector<std::shared_ptr<hilo_t>>& hilo, __time32_t start, __time32_t end, int interval_seconds, bool is_carry_legs, std::vector<std::vector<bar_t>>* bars, const scan_options_t& options = scan_options_t());
+	}
+
+/* single cursor with integer publish mantissa rule state. */
+	namespace fixed_point {
+		bool get_hilo (const std::vector<std::shared_ptr<hilo_t>>& hilo, __time32_t start, __time32_t end, const scan_options_t& options = scan_options_t());
+		bool get_hilo (const std::vector<std::shared_ptr<hilo_t>>& hilo, __time32_t start, __time32_t end, int interval_seconds, bool is_carry_legs, std::vector<std::vector<bar_t>>* bars, const scan_options_t& options = scan_options_t());
+	}
+
+/* Configurable calculation engine. */
+	enum {
+		ENGINE_SINGLE_ITERATOR = 0,
+		ENGINE_VECTORIZED,
+		ENGINE_FIXED_POINT
+	};
+
+/* Engine from configuration name, empty selects the default. */
+	bool ParseEngine (const std::string& name, int* engine);
+	bool get_hilo (int engine, const std::vector<std::shared_ptr<hilo_t>>& hilo, __time32_t start, __time32_t end, const scan_options_t& options = scan_options_t());
+	bool get_hilo (int engine, const std::vector<std::shared_ptr<hilo_t>>& hilo, __time32_t start, __time32_t end, int interval_seconds, bool is_carry_legs, std::vector<std::vector<bar_t>>* bars, const scan_options_t& options = scan_options_t());
+
+/* Watermark of each interval over [start, end), one cursor without rule
+ * evaluation.  The tick cache is never read as it does not hold late inserts.
+ */
+	bool get_watermarks (const std::vector<std::shared_ptr<hilo_t>>& hilo, __time32_t start, __time32_t end, int interval_seconds, std::vector<watermark_t>* watermarks, const scan_options_t& options = scan_options_t());
+
+/* Rules partitioned by connected components of the leg symbol graph so that
+ * synthetic legs share a cursor, each cursor runs the engine on the pool.
+ * Components are packed into cursors of at most chunk_symbols symbols, or
+ * shard_count cursors when zero.  Without a pool cursors run serially.
+ *
+ * A cursor that cannot open is split by component and retried until the
+ * failing component is isolated, false if any component failed.
+ */
+	namespace sharded {
+		bool get_hilo (int engine, thread_pool_t* pool, size_t shard_count, size_t chunk_symbols, const std::vector<std::shared_ptr<hilo_t>>& hilo, __time32_t start, __time32_t end, const scan_options_t& options = scan_options_t());
+		bool get_hilo (int engine, thread_pool_t* pool, size_t shard_count, size_t chunk_symbols, const std::vector<std::shared_ptr<hilo_t>>& hilo, __time32_t start, __time32_t end, int interval_seconds, bool is_carry_legs, std::vector<std::vector<bar_t>>* bars, const scan_options_t& options = scan_options_t());
+	}
+
+/* Window split into partition_count time ranges scanned concurrently on the
+ * pool, results identical to single_iterator over one cursor as checked by
+ * get_hilo_bench --verify.  Synthetic ticks before the other leg ticks within a
+ * partition are replayed against the leg state of the partitions before it.  A
+ * partition without ticks is empty, false if any tick source failed and rules
+ * are unchanged.
+ */
+	namespace partitioned {
+		bool get_hilo (thread_pool_t* pool, size_t partition_count, const std::vector<std::shared_ptr<hilo_t>>& hilo, __time32_t start, __time32_t end, const scan_options_t& options = scan_options_t());
+/* partitions on interval boundaries with legs reset per interval, any engine. */
+		bool get_hilo (int engine, thread_pool_t* pool, size_t partition_count, const std::vector<std::shared_ptr<hilo_t>>& hilo, __time32_t start, __time32_t end, int interval_seconds, std::vector<std::vector<bar_t>>* bars, const scan_options_t& options = scan_options_t());
 	}
 
 } /* namespace hilo */
@@ -0,0 +1,65 @@
+/* Compile-time specialized synthetic cross operators.
+ *
+ * Rules are grouped by operator when a query is built so that the per-tick
+ * path calls a fixed kernel instead of testing math_op on every tick.
+ */
+
+#ifndef __MATH_OP_HH__
+#define __MATH_OP_HH__
+#pragma once
+
+#include "get_hilo.hh"
+
+namespace hilo
+{
+	template <int MathOp> struct math_op_t;
+
+	template <>
+	struct math_op_t<MATH_OP_TIMES>
+	{
+		static double Apply (double a, double b) {
+			return a * b;
+		}
+	};
+
+/* divide by zero returns the zero divisor. */
+	template <>
+	struct math_op_t<MATH_OP_DIVIDE>
+	{
+		static double Apply (double a, double b) {
+			return (b == 0.0) ? b : (a / b);
+		}
+	};
+
+/* synthetic without an operator divides, as per the original MathOperator. */
+	template <>
+	struct math_op_t<MATH_OP_NOOP> : math_op_t<MATH_OP_DIVIDE>
+	{
+	};
+
+/* Operator group of a synthetic rule, MATH_OP_TIMES or MATH_OP_DIVIDE. */
+	inline int GetSyntheticOp (const hilo_t& rule) {
+		return (MATH_OP_TIMES == rule.math_op) ? MATH_OP_TIMES : MATH_OP_DIVIDE;
+	}
+
+/* Fold one synthetic bid and ask from both leg prices into the rule. */
+	template <int MathOp>
+	inline void UpdateSynthetic (hilo_t*const rule, double first_bid, double first_ask, double second_bid, double second_ask)
+	{
+		const double synthetic_bid_price = math_op_t<MathOp>::Apply (first_bid, second_bid);
+		const double synthetic_ask_price = math_op_t<MathOp>::Apply (first_ask, second_ask);
+		if (rule->is_null) {
+			rule->is_null = false;
+			rule->low     = synthetic_bid_price;
+			rule->high    = synthetic_ask_price;
+			return;
+		}
+		if (synthetic_bid_price < rule->low)  rule->low  = synthetic_bid_price;
+		if (synthetic_ask_price > rule->high) rule->high = synthetic_ask_price;
+	}
+
+} /* namespace hilo */
+
+#endif /* __MATH_OP_HH__ */
+
+/* eof */
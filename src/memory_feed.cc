@@ -0,0 +1,73 @@
+/* In-process tick feed stand-in.
+ *
+ * Separate from the FlexRecReader feed so the stand-alone benchmarks build
+ * without the Velocity Analytics SDK.
+ */
+
+#include "tick_feed.hh"
+
+#include <algorithm>
+
+#include "chromium/logging.hh"
+
+hilo::memory_feed_t::memory_feed_t() :
+	from_ (0),
+	handler_ (nullptr)
+{
+}
+
+bool
+hilo::memory_feed_t::Subscribe (
+	const std::set<std::string>& symbol_set,
+	const std::unordered_map<std::string, size_t>& field_map,
+	__time32_t	from,
+	tick_handler_t*	handler
+	)
+{
+	CHECK (nullptr != handler);
+	boost::lock_guard<boost::mutex> lock (lock_);
+	symbol_set_ = symbol_set;
+	field_map_  = field_map;
+	fields_.assign (field_map.size(), 0.0);
+	from_       = from;
+	handler_    = handler;
+	return true;
+}
+
+void
+hilo::memory_feed_t::Unsubscribe()
+{
+	boost::lock_guard<boost::mutex> lock (lock_);
+	handler_ = nullptr;
+}
+
+void
+hilo::memory_feed_t::Push (
+	const char*	symbol_name,
+	__time32_t	timestamp,
+	const std::unordered_map<std::string, double>& values
+	)
+{
+	boost::lock_guard<boost::mutex> lock (lock_);
+	if (nullptr == handler_ || timestamp < from_ || 0 == symbol_set_.count (symbol_name))
+		return;
+	std::fill (fields_.begin(), fields_.end(), 0.0);
+	std::for_each (values.begin(), values.end(), [this](const std::pair<const std::string, double>& value) {
+		auto it = field_map_.find (value.first);
+		if (field_map_.end() != it)
+			fields_[it->second] = value.second;
+	});
+	handler_->OnTick (symbol_name, timestamp, fields_);
+}
+
+void
+hilo::memory_feed_t::Advance (
+	__time32_t	till
+	)
+{
+	boost::lock_guard<boost::mutex> lock (lock_);
+	if (nullptr != handler_)
+		handler_->OnWatermark (till);
+}
+
+/* eof */
@@ -0,0 +1,190 @@
+/* Fan-out high-low update kernels over contiguous per-edge arrays.
+ *
+ * One block holds every rule slot updated by ticks of one symbol with the
+ * same operator and tick side fields.  Each slot combines the tick price with
+ * the cached price of the other leg and folds the result into the slot high
+ * and low, slots of one rule are merged when the rule is saved.
+ *
+ * 256-bit AVX with CONFIG_AVX, otherwise SSE2 on x64, otherwise scalar.
+ */
+
+#ifndef __MINMAX_KERNEL_HH__
+#define __MINMAX_KERNEL_HH__
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "math_op.hh"
+
+#if defined(CONFIG_AVX)
+#	include <immintrin.h>
+#elif defined(_M_X64) || defined(__SSE2__)
+#	include <emmintrin.h>
+#	define MINMAX_KERNEL_SSE2
+#endif
+
+namespace hilo
+{
+namespace kernel
+{
+	enum {
+/* tick price only, non-synthetic rules. */
+		KERNEL_NOOP = 0,
+/* tick * other, either leg. */
+		KERNEL_TIMES,
+/* tick / other, tick is the first leg. */
+		KERNEL_DIVIDE_FIRST,
+/* other / tick, tick is the second leg. */
+		KERNEL_DIVIDE_SECOND
+	};
+
+/* Lane masks are all bits set or clear. */
+	static const uint64_t kMaskSet = UINT64_MAX;
+
+	struct block_view_t
+	{
+		const double* other_bid;
+		const double* other_ask;
+/* other leg has a value. */
+		const uint64_t* valid;
+		double* low;
+		double* high;
+/* slot high and low are set. */
+		uint64_t* hit;
+		size_t size;
+	};
+
+	template <int Op>
+	inline double Apply (double tick, double other)
+	{
+		switch (Op) {
+		case KERNEL_TIMES:		return math_op_t<MATH_OP_TIMES>::Apply (tick, other);
+		case KERNEL_DIVIDE_FIRST:	return math_op_t<MATH_OP_DIVIDE>::Apply (tick, other);
+		case KERNEL_DIVIDE_SECOND:	return math_op_t<MATH_OP_DIVIDE>::Apply (other, tick);
+		default:			return tick;
+		}
+	}
+
+	template <int Op>
+	inline void UpdateScalar (double tick_bid, double tick_ask, const block_view_t& block, size_t from)
+	{
+		for (size_t i = from; i < block.size; ++i)
+		{
+			if (0 == block.valid[i])
+				continue;
+			const double bid = Apply<Op> (tick_bid, block.other_bid[i]);
+			const double ask = Apply<Op> (tick_ask, block.other_ask[i]);
+			if (0 == block.hit[i]) {
+				block.hit[i]  = kMaskSet;
+				block.low[i]  = bid;
+				block.high[i] = ask;
+				continue;
+			}
+			if (bid < block.low[i])  block.low[i]  = bid;
+			if (ask > block.high[i]) block.high[i] = ask;
+		}
+	}
+
+#if defined(CONFIG_AVX)
+	struct isa_t
+	{
+		typedef __m256d vector_type;
+		enum { width = 4 };
+		static vector_type load (const double* p)		{ return _mm256_loadu_pd (p); }
+		static vector_type load (const uint64_t* p)		{ return _mm256_castsi256_pd (_mm256_loadu_si256 (reinterpret_cast<const __m256i*> (p))); }
+		static void store (double* p, vector_type v)		{ _mm256_storeu_pd (p, v); }
+		static void store (uint64_t* p, vector_type v)		{ _mm256_storeu_si256 (reinterpret_cast<__m256i*> (p), _mm256_castpd_si256 (v)); }
+		static vector_type set1 (double v)			{ return _mm256_set1_pd (v); }
+		static vector_type zero()				{ return _mm256_setzero_pd(); }
+		static vector_type mul (vector_type a, vector_type b)	{ return _mm256_mul_pd (a, b); }
+		static vector_type div (vector_type a, vector_type b)	{ return _mm256_div_pd (a, b); }
+		static vector_type minimum (vector_type a, vector_type b)	{ return _mm256_min_pd (a, b); }
+		static vector_type maximum (vector_type a, vector_type b)	{ return _mm256_max_pd (a, b); }
+		static vector_type cmpeq (vector_type a, vector_type b)	{ return _mm256_cmp_pd (a, b, _CMP_EQ_OQ); }
+		static vector_type or_ (vector_type a, vector_type b)	{ return _mm256_or_pd (a, b); }
+/* mask ? a : b */
+		static vector_type select (vector_type mask, vector_type a, vector_type b) { return _mm256_blendv_pd (b, a, mask); }
+	};
+#elif defined(MINMAX_KERNEL_SSE2)
+	struct isa_t
+	{
+		typedef __m128d vector_type;
+		enum { width = 2 };
+		static vector_type load (const double* p)		{ return _mm_loadu_pd (p); }
+		static vector_type load (const uint64_t* p)		{ return _mm_castsi128_pd (_mm_loadu_si128 (reinterpret_cast<const __m128i*> (p))); }
+		static void store (double* p, vector_type v)		{ _mm_storeu_pd (p, v); }
+		static void store (uint64_t* p, vector_type v)		{ _mm_storeu_si128 (reinterpret_cast<__m128i*> (p), _mm_castpd_si128 (v)); }
+		static vector_type set1 (double v)			{ return _mm_set1_pd (v); }
+		static vector_type zero()				{ return _mm_setzero_pd(); }
+		static vector_type mul (vector_type a, vector_type b)	{ return _mm_mul_pd (a, b); }
+		static vector_type div (vector_type a, vector_type b)	{ return _mm_div_pd (a, b); }
+		static vector_type minimum (vector_type a, vector_type b)	{ return _mm_min_pd (a, b); }
+		static vector_type maximum (vector_type a, vector_type b)	{ return _mm_max_pd (a, b); }
+		static vector_type cmpeq (vector_type a, vector_type b)	{ return _mm_cmpeq_pd (a, b); }
+		static vector_type or_ (vector_type a, vector_type b)	{ return _mm_or_pd (a, b); }
+		static vector_type select (vector_type mask, vector_type a, vector_type b) { return _mm_or_pd (_mm_and_pd (mask, a), _mm_andnot_pd (mask, b)); }
+	};
+#endif
+
+#if defined(CONFIG_AVX) || defined(MINMAX_KERNEL_SSE2)
+	template <int Op>
+	inline isa_t::vector_type ApplyVector (isa_t::vector_type tick, isa_t::vector_type other)
+	{
+		switch (Op) {
+		case KERNEL_TIMES:		return isa_t::mul (tick, other);
+		case KERNEL_DIVIDE_FIRST:	return isa_t::select (isa_t::cmpeq (other, isa_t::zero()), other, isa_t::div (tick, other));
+		case KERNEL_DIVIDE_SECOND:	return isa_t::select (isa_t::cmpeq (tick, isa_t::zero()), tick, isa_t::div (other, tick));
+		default:			return tick;
+		}
+	}
+
+/* Branch free per lane: skip lanes without a valid other leg, first hit
+ * replaces, later hits fold with min/max.  minimum (candidate, low) keeps low when
+ * either is NaN, matching the scalar comparison.
+ */
+	template <int Op>
+	inline void Update (double tick_bid, double tick_ask, const block_view_t& block)
+	{
+		typedef isa_t::vector_type vector_type;
+		const vector_type vtick_bid = isa_t::set1 (tick_bid);
+		const vector_type vtick_ask = isa_t::set1 (tick_ask);
+		size_t i = 0;
+		for (; (i + isa_t::width) <= block.size; i += isa_t::width)
+		{
+			const vector_type valid = isa_t::load (block.valid + i);
+			const vector_type hit   = isa_t::load (block.hit + i);
+			const vector_type bid   = ApplyVector<Op> (vtick_bid, isa_t::load (block.other_bid + i));
+			const vector_type ask   = ApplyVector<Op> (vtick_ask, isa_t::load (block.other_ask + i));
+			const vector_type low   = isa_t::load (block.low + i);
+			const vector_type high  = isa_t::load (block.high + i);
+			isa_t::store (block.low + i,  isa_t::select (valid, isa_t::select (hit, isa_t::minimum (bid, low),  bid), low));
+			isa_t::store (block.high + i, isa_t::select (valid, isa_t::select (hit, isa_t::maximum (ask, high), ask), high));
+			isa_t::store (block.hit + i,  isa_t::or_ (hit, valid));
+		}
+		UpdateScalar<Op> (tick_bid, tick_ask, block, i);
+	}
+#else
+	template <int Op>
+	inline void Update (double tick_bid, double tick_ask, const block_view_t& block)
+	{
+		UpdateScalar<Op> (tick_bid, tick_ask, block, 0);
+	}
+#endif
+
+	inline void Update (int op, double tick_bid, double tick_ask, const block_view_t& block)
+	{
+		switch (op) {
+		case KERNEL_TIMES:		Update<KERNEL_TIMES> (tick_bid, tick_ask, block); break;
+		case KERNEL_DIVIDE_FIRST:	Update<KERNEL_DIVIDE_FIRST> (tick_bid, tick_ask, block); break;
+		case KERNEL_DIVIDE_SECOND:	Update<KERNEL_DIVIDE_SECOND> (tick_bid, tick_ask, block); break;
+		default:			Update<KERNEL_NOOP> (tick_bid, tick_ask, block); break;
+		}
+	}
+
+} /* namespace kernel */
+} /* namespace hilo */
+
+#endif /* __MINMAX_KERNEL_HH__ */
+
+/* eof */
@@ -18,6 +18,7 @@
 #include "chromium/chromium_switches.hh"
 #include "chromium/command_line.hh"
 #include "chromium/logging.hh"
+#include "flexrec_source.hh"
 #include "stitch.hh"
 
 static const char* kPluginType = "HiloPlugin";
@@ -158,6 +159,7 @@ namespace
 		env_t env;
 		winsock_t winsock;
 		timecaps_t timecaps_;
+		hilo::flexrec_source_factory_t flexrec_;
 
 	public:
 		factory_t() :
@@ -165,6 +167,8 @@ namespace
 			winsock (2, 2),
 			timecaps_ (1 /* ms */)
 		{
+/* every scan without its own source reads the tick store */
+			hilo::SetDefaultTickSourceFactory (&flexrec_);
 			registerType (kPluginType);
 		}
 
@@ -126,6 +126,9 @@ hilo::provider_t::provider_t (
 	event_queue_ (event_queue),
 	min_rwf_major_version_ (0),
 	min_rwf_minor_version_ (0),
+	refresh_interval_ (boost::posix_time::seconds (0)),
+	refresh_expiry_ (boost::posix_time::neg_infin),
+	refresh_generation_ (0),
 	event_id_ (0)
 {
 	ZeroMemory (cumulative_stats_, sizeof (cumulative_stats_));
@@ -154,6 +157,11 @@ hilo::provider_t::~provider_t()
 bool
 hilo::provider_t::Init()
 {
+	size_t refresh_seconds = 0;
+	if (!ParseNonNegative ("refresh interval", config_.refresh_interval, 0, &refresh_seconds))
+		return false;
+	refresh_interval_ = boost::posix_time::seconds (static_cast<long> (refresh_seconds));
+
 /* COOL events */
 	if (config_.history_table_size > 0)
 	{
@@ -250,6 +258,60 @@ hilo::provider_t::Send (
 	cumulative_stats_[PROVIDER_PC_MSGS_SENT]++;
 	last_activity_ = boost::posix_time::microsec_clock::universal_time();
 	return true;
+}
+
+int
+hilo::provider_t::GetPublishType (
+	const item_stream_t& item_stream,
+	uint64_t	digest,
+	const boost::posix_time::ptime& now
+	)
+{
+	if (refresh_interval_ <= boost::posix_time::seconds (0) || IsRefreshDue (item_stream, now))
+		return PUBLISH_REFRESH;
+	if (item_stream.digest != digest)
+		return PUBLISH_UPDATE;
+	cumulative_stats_[PROVIDER_PC_MSGS_SUPPRESSED]++;
+	return PUBLISH_NONE;
+}
+
+bool
+hilo::provider_t::Send (
+	item_stream_t*const item_stream,
+	uint64_t	digest,
+	bool		is_refresh,
+	rfa::message::RespMsg*const msg
+	)
+{
+	if (!Send (item_stream, msg))
+		return false;
+	item_stream->digest = digest;
+	if (is_refresh) {
+		item_stream->refresh_time = last_activity_;
+		item_stream->refresh_token = item_stream->token;
+	} else {
+		cumulative_stats_[PROVIDER_PC_UPDATES_SENT]++;
+	}
+	return true;
+}
+
+bool
+hilo::provider_t::IsRefreshDue (
+	const item_stream_t& item_stream,
+	const boost::posix_time::ptime& now
+	) const
+{
+	using namespace boost::posix_time;
+	return item_stream.refresh_token != item_stream.token ||
+	       item_stream.refresh_time <= refresh_expiry_ ||
+	       (refresh_interval_ > seconds (0) && now - item_stream.refresh_time >= refresh_interval_);
+}
+
+void
+hilo::provider_t::ExpireRefreshes()
+{
+	refresh_expiry_ = boost::posix_time::microsec_clock::universal_time();
+	++refresh_generation_;
 }
 
 void
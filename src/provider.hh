@@ -35,6 +35,8 @@ namespace hilo
 /* Performance Counters */
 	enum {
 		PROVIDER_PC_MSGS_SENT,
+		PROVIDER_PC_UPDATES_SENT,
+		PROVIDER_PC_MSGS_SUPPRESSED,
 /* marker */
 		PROVIDER_PC_MAX
 	};
@@ -42,10 +44,22 @@ namespace hilo
 	class item_stream_t : boost::noncopyable
 	{
 	public:
+		item_stream_t() :
+			digest (0),
+			refresh_time (boost::posix_time::neg_infin)
+		{
+		}
+
 /* Fixed name for this stream. */
 		rfa::common::RFA_String rfa_name;
 /* Session token which is valid from login success to login close. */
 		std::vector<rfa::sessionLayer::ItemToken*> token;
+/* Digest of the last published fields, time of the last refresh and the
+ * session tokens it was sent on.
+ */
+		uint64_t digest;
+		boost::posix_time::ptime refresh_time;
+		std::vector<rfa::sessionLayer::ItemToken*> refresh_token;
 	};
 
 	class session_t;
@@ -215,6 +229,35 @@ namespace hilo
 		bool CreateItemStream (const char* name, std::shared_ptr<item_stream_t> item_stream) throw (rfa::common::InvalidUsageException);
 		bool Send (item_stream_t*const item_stream, rfa::message::RespMsg*const msg) throw (rfa::common::InvalidUsageException);
 
+/* Delta publishing: message to send for an item whose fields digest to
+ * digest.  A refresh when delta publishing is off, a session has not received
+ * one on its current token or the refresh interval has passed, an update when
+ * the fields changed, otherwise none.
+ */
+		enum {
+			PUBLISH_NONE = 0,
+			PUBLISH_UPDATE,
+			PUBLISH_REFRESH
+		};
+		int GetPublishType (const item_stream_t& item_stream, uint64_t digest, const boost::posix_time::ptime& now);
+/* A session lacks a refresh of the item on its current token, hilo_republish
+ * was called or the refresh interval has passed at now.
+ */
+		bool IsRefreshDue (const item_stream_t& item_stream, const boost::posix_time::ptime& now) const;
+/* Changes when refreshes become due other than by the refresh interval, i.e.
+ * hilo_republish or new session tokens.
+ */
+		uint64_t GetRefreshGeneration() const {
+			return refresh_generation_;
+		}
+		const boost::posix_time::time_duration& GetRefreshInterval() const {
+			return refresh_interval_;
+		}
+/* Send the message and remember the digest, and the tokens if a refresh. */
+		bool Send (item_stream_t*const item_stream, uint64_t digest, bool is_refresh, rfa::message::RespMsg*const msg) throw (rfa::common::InvalidUsageException);
+/* Refresh every item on its next publish. */
+		void ExpireRefreshes();
+
 		uint8_t GetRwfMajorVersion() const {
 			return min_rwf_major_version_;
 		}
@@ -252,6 +295,13 @@ namespace hilo
 /* Container of all item streams keyed by symbol name. */
 		std::unordered_map<std::string, std::weak_ptr<item_stream_t>> directory_;
 
+/* Maximum time between refreshes of an item, zero to always refresh.  Items
+ * refreshed before the expiry time refresh again.
+ */
+		boost::posix_time::time_duration refresh_interval_;
+		boost::posix_time::ptime refresh_expiry_;
+		uint64_t refresh_generation_;
+
 		friend session_t;
 
 /* COOL measurement: index is read-only */
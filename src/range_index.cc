@@ -0,0 +1,297 @@
+/* Per-symbol high-low segment tree over completed intervals.
+ */
+
+#include "range_index.hh"
+
+#include <algorithm>
+#include <set>
+
+#include "chromium/logging.hh"
+
+/* Seconds per day, capacity hint for one session of intervals. */
+static const int kSecondsPerDay = 24 * 60 * 60;
+
+hilo::range_index_t::tree_t::tree_t (
+	size_t		capacity
+	) :
+	capacity_ (1),
+	size_ (0)
+{
+	while (capacity_ < capacity)
+		capacity_ <<= 1;
+	nodes_.resize (2 * capacity_);
+}
+
+/* Double the leaf count and rebuild every interior node.
+ */
+void
+hilo::range_index_t::tree_t::Grow()
+{
+	std::vector<node_t> nodes (4 * capacity_);
+	std::copy (nodes_.begin() + capacity_, nodes_.begin() + capacity_ + size_, nodes.begin() + (2 * capacity_));
+	nodes_.swap (nodes);
+	capacity_ <<= 1;
+	for (size_t i = capacity_ - 1; i > 0; --i)
+		nodes_[i] = Combine (nodes_[2 * i], nodes_[(2 * i) + 1]);
+}
+
+void
+hilo::range_index_t::tree_t::Append (
+	const bar_t&	bar
+	)
+{
+	if (size_ == capacity_)
+		Grow();
+	Update (size_++, bar);
+}
+
+void
+hilo::range_index_t::tree_t::Set (
+	size_t		index,
+	const bar_t&	bar
+	)
+{
+	DCHECK (index < size_);
+	Update (index, bar);
+}
+
+/* Leaf from the bar then every interior node above it.
+ */
+void
+hilo::range_index_t::tree_t::Update (
+	size_t		index,
+	const bar_t&	bar
+	)
+{
+	size_t i = capacity_ + index;
+	node_t& leaf = nodes_[i];
+	leaf.is_null  = bar.is_null;
+	leaf.low      = bar.low;
+	leaf.high     = bar.high;
+	leaf.has_last = !bar.first.is_null;
+	leaf.last_bid = bar.first.last_bid;
+	leaf.last_ask = bar.first.last_ask;
+	for (i >>= 1; i > 0; i >>= 1)
+		nodes_[i] = Combine (nodes_[2 * i], nodes_[(2 * i) + 1]);
+}
+
+/* Fold leaves [from, till) in time order.
+ */
+hilo::range_index_t::node_t
+hilo::range_index_t::tree_t::Query (
+	size_t		from,
+	size_t		till
+	) const
+{
+	DCHECK (from <= till && till <= size_);
+	node_t left, right;
+	for (size_t l = from + capacity_, r = till + capacity_; l < r; l >>= 1, r >>= 1) {
+		if (l & 1) left  = Combine (left, nodes_[l++]);
+		if (r & 1) right = Combine (nodes_[--r], right);
+	}
+	return Combine (left, right);
+}
+
+/* lhs precedes rhs in time.
+ */
+hilo::range_index_t::node_t
+hilo::range_index_t::Combine (
+	const node_t&	lhs,
+	const node_t&	rhs
+	)
+{
+	node_t node;
+	node.is_null = lhs.is_null && rhs.is_null;
+	if (lhs.is_null) {
+		node.low  = rhs.low;
+		node.high = rhs.high;
+	} else if (rhs.is_null) {
+		node.low  = lhs.low;
+		node.high = lhs.high;
+	} else {
+		node.low  = (rhs.low < lhs.low) ? rhs.low : lhs.low;
+		node.high = (rhs.high > lhs.high) ? rhs.high : lhs.high;
+	}
+	const node_t& last = rhs.has_last ? rhs : lhs;
+	node.has_last = last.has_last;
+	node.last_bid = last.last_bid;
+	node.last_ask = last.last_ask;
+	return node;
+}
+
+std::string
+hilo::range_index_t::MakeKey (
+	const leg_t&	leg
+	)
+{
+	std::string key (leg.symbol_name);
+	key.push_back ('\0');
+	key.append (leg.bid_field);
+	key.push_back ('\0');
+	key.append (leg.ask_field);
+	return key;
+}
+
+hilo::range_index_t::range_index_t() :
+	reset_time_ (0),
+	interval_seconds_ (0),
+	capacity_hint_ (0),
+	interval_count_ (0)
+{
+}
+
+void
+hilo::range_index_t::Reset (
+	__time32_t	reset_time,
+	int		interval_seconds,
+	size_t		capacity_hint
+	)
+{
+	CHECK (interval_seconds > 0);
+	boost::unique_lock<boost::shared_mutex> lock (lock_);
+	reset_time_       = reset_time;
+	interval_seconds_ = interval_seconds;
+	capacity_hint_    = (0 == capacity_hint) ? (1 + (kSecondsPerDay / interval_seconds)) : capacity_hint;
+	interval_count_   = 0;
+	trees_.clear();
+	DVLOG(1) << "Range index reset, interval " << interval_seconds << "s.";
+}
+
+void
+hilo::range_index_t::Clear()
+{
+	boost::unique_lock<boost::shared_mutex> lock (lock_);
+	reset_time_       = 0;
+	interval_seconds_ = 0;
+	capacity_hint_    = 0;
+	interval_count_   = 0;
+	trees_.clear();
+}
+
+void
+hilo::range_index_t::Append (
+	const std::vector<std::shared_ptr<hilo_t>>& query,
+	const std::vector<std::vector<bar_t>>& bars,
+	size_t		bar_count
+	)
+{
+	CHECK (query.size() == bars.size());
+	boost::unique_lock<boost::shared_mutex> lock (lock_);
+	CHECK (interval_seconds_ > 0);
+	std::set<std::string> key_set;
+	for (size_t rule_index = 0; rule_index < query.size(); ++rule_index) {
+		const hilo_t& rule = *query[rule_index].get();
+		if (rule.is_synthetic)
+			continue;
+		const std::string key (MakeKey (rule.legs.first));
+		if (!key_set.insert (key).second)
+			continue;
+		auto it = trees_.find (key);
+		if (trees_.end() == it)
+			it = trees_.emplace (std::make_pair (key, std::make_shared<tree_t> (capacity_hint_))).first;
+		const std::vector<bar_t>& rule_bars = bars[rule_index];
+		CHECK (rule_bars.size() == bar_count);
+		std::for_each (rule_bars.begin(), rule_bars.end(), [&](const bar_t& bar) {
+			it->second->Append (bar);
+		});
+	}
+	interval_count_ += bar_count;
+}
+
+void
+hilo::range_index_t::Replace (
+	const std::vector<std::shared_ptr<hilo_t>>& query,
+	size_t		first_bar,
+	const std::vector<std::vector<bar_t>>& bars,
+	size_t		bar_count
+	)
+{
+	CHECK (query.size() == bars.size());
+	boost::unique_lock<boost::shared_mutex> lock (lock_);
+	CHECK (first_bar + bar_count <= interval_count_);
+	std::set<std::string> key_set;
+	for (size_t rule_index = 0; rule_index < query.size(); ++rule_index) {
+		const hilo_t& rule = *query[rule_index].get();
+		if (rule.is_synthetic)
+			continue;
+		const std::string key (MakeKey (rule.legs.first));
+		if (!key_set.insert (key).second)
+			continue;
+		auto it = trees_.find (key);
+		if (trees_.end() == it)
+			continue;
+		const std::vector<bar_t>& rule_bars = bars[rule_index];
+		CHECK (rule_bars.size() == bar_count);
+		for (size_t bar_index = 0; bar_index < bar_count; ++bar_index)
+			it->second->Set (first_bar + bar_index, rule_bars[bar_index]);
+	}
+}
+
+bool
+hilo::range_index_t::Lookup (
+	const std::vector<std::shared_ptr<hilo_t>>& query,
+	__time32_t	start,
+	__time32_t	end,
+	range_lookup_t* lookup
+	) const
+{
+	CHECK (nullptr != lookup);
+	lookup->rule_indices.clear();
+	lookup->values.clear();
+
+	boost::shared_lock<boost::shared_mutex> lock (lock_);
+	if (0 == interval_count_ || end <= reset_time_)
+		return false;
+
+/* whole intervals only, round start up and end down */
+	const size_t first = (start <= reset_time_) ? 0 : ((start - reset_time_ + interval_seconds_ - 1) / interval_seconds_);
+	const size_t last = std::min (interval_count_, static_cast<size_t> ((end - reset_time_) / interval_seconds_));
+	if (first >= last)
+		return false;
+	lookup->from = reset_time_ + static_cast<__time32_t> (first * interval_seconds_);
+	lookup->till = reset_time_ + static_cast<__time32_t> (last * interval_seconds_);
+
+	for (size_t rule_index = 0; rule_index < query.size(); ++rule_index) {
+		const hilo_t& rule = *query[rule_index].get();
+		if (rule.is_synthetic)
+			continue;
+		auto it = trees_.find (MakeKey (rule.legs.first));
+/* leg added after the session started */
+		if (trees_.end() == it || it->second->size() != interval_count_)
+			continue;
+		const node_t node = it->second->Query (first, last);
+		bar_t value;
+		value.is_null        = node.is_null;
+		value.low            = node.low;
+		value.high           = node.high;
+		value.first.is_null  = !node.has_last;
+		value.first.last_bid = node.last_bid;
+		value.first.last_ask = node.last_ask;
+		lookup->rule_indices.push_back (rule_index);
+		lookup->values.push_back (value);
+	}
+	return !lookup->rule_indices.empty();
+}
+
+void
+hilo::range_index_t::Fold (
+	const bar_t&	value,
+	hilo_t*const	rule
+	)
+{
+	if (!value.is_null) {
+		rule->has_mantissa = false;
+		if (rule->is_null) {
+			rule->is_null = false;
+			rule->low     = value.low;
+			rule->high    = value.high;
+		} else {
+			if (value.low < rule->low)   rule->low  = value.low;
+			if (value.high > rule->high) rule->high = value.high;
+		}
+	}
+	if (!value.first.is_null)
+		value.first.Restore (&rule->legs.first);
+}
+
+/* eof */
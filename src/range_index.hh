@@ -0,0 +1,113 @@
+/* Per-symbol high-low segment tree over completed intervals.
+ *
+ * Each non-synthetic leg, keyed by symbol and bid and ask field, holds one
+ * leaf per interval since the last reset with the lowest bid, highest ask and
+ * last bid and ask.  Any aligned range of intervals folds in O(log n) so an
+ * arbitrary window only needs raw scans of the partial intervals at each edge.
+ */
+
+#ifndef __RANGE_INDEX_HH__
+#define __RANGE_INDEX_HH__
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* Boost noncopyable base class. */
+#include <boost/utility.hpp>
+
+/* Boost threading. */
+#include <boost/thread.hpp>
+
+#include "get_hilo.hh"
+
+namespace hilo
+{
+/* Rules answered from the index over [from, till), values in rule order. */
+	class range_lookup_t
+	{
+	public:
+		range_lookup_t() : from (0), till (0) {}
+
+		__time32_t from, till;
+		std::vector<size_t> rule_indices;
+		std::vector<bar_t> values;
+	};
+
+	class range_index_t : boost::noncopyable
+	{
+	public:
+		range_index_t();
+
+/* Discard all intervals and start a new session at reset_time. */
+		void Reset (__time32_t reset_time, int interval_seconds, size_t capacity_hint);
+		void Clear();
+
+/* Index bar_count consecutive bars indexed [rule][bar], synthetic rules are
+ * skipped.
+ */
+		void Append (const std::vector<std::shared_ptr<hilo_t>>& query, const std::vector<std::vector<bar_t>>& bars, size_t bar_count);
+/* Overwrite bar_count indexed intervals from first_bar. */
+		void Replace (const std::vector<std::shared_ptr<hilo_t>>& query, size_t first_bar, const std::vector<std::vector<bar_t>>& bars, size_t bar_count);
+
+/* Largest run of whole indexed intervals within [start, end) and the index
+ * values of each indexed non-synthetic rule, false if none apply.
+ */
+		bool Lookup (const std::vector<std::shared_ptr<hilo_t>>& query, __time32_t start, __time32_t end, range_lookup_t* lookup) const;
+
+/* Fold an index value into the rule as a scan over the same ticks would. */
+		static void Fold (const bar_t& value, hilo_t*const rule);
+
+	private:
+		class node_t
+		{
+		public:
+			node_t() : low (0.0), high (0.0), last_bid (0.0), last_ask (0.0), is_null (true), has_last (false) {}
+
+			double low, high;
+			double last_bid, last_ask;
+			bool is_null, has_last;
+		};
+
+		class tree_t
+		{
+		public:
+			explicit tree_t (size_t capacity);
+
+			void Append (const bar_t& bar);
+			void Set (size_t index, const bar_t& bar);
+			node_t Query (size_t from, size_t till) const;
+			size_t size() const {
+				return size_;
+			}
+
+		private:
+			void Grow();
+			void Update (size_t index, const bar_t& bar);
+
+/* 1-based implicit binary tree, leaves from capacity_. */
+			std::vector<node_t> nodes_;
+			size_t capacity_;
+			size_t size_;
+		};
+
+		static node_t Combine (const node_t& lhs, const node_t& rhs);
+		static std::string MakeKey (const leg_t& leg);
+
+		mutable boost::shared_mutex lock_;
+		__time32_t reset_time_;
+		int interval_seconds_;
+		size_t capacity_hint_;
+/* intervals held by every tree. */
+		size_t interval_count_;
+		std::unordered_map<std::string, std::shared_ptr<tree_t>> trees_;
+	};
+
+} /* namespace hilo */
+
+#endif /* __RANGE_INDEX_HH__ */
+
+/* eof */
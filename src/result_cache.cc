@@ -0,0 +1,146 @@
+/* Window query result cache.
+ */
+
+#include "result_cache.hh"
+
+#include <algorithm>
+
+#include "chromium/logging.hh"
+#include "rule_plan.hh"
+
+hilo::result_cache_t::result_cache_t (
+	size_t		capacity
+	) :
+	capacity_ (capacity),
+	hit_count_ (0),
+	resume_count_ (0),
+	miss_count_ (0),
+	eviction_count_ (0)
+{
+}
+
+void
+hilo::result_cache_t::Clear()
+{
+	boost::lock_guard<boost::mutex> lock (lock_);
+	entries_.clear();
+	index_.clear();
+}
+
+/* Canonical rules followed by the raw window start. */
+std::string
+hilo::result_cache_t::MakeKey (
+	const std::vector<std::shared_ptr<hilo_t>>& query,
+	__time32_t	start
+	)
+{
+	std::string key (rule_plan_t::MakeKey (query));
+	key.append (reinterpret_cast<const char*> (&start), sizeof (start));
+	return key;
+}
+
+bool
+hilo::result_cache_t::Lookup (
+	const std::vector<std::shared_ptr<hilo_t>>& query,
+	__time32_t	start,
+	__time32_t	end,
+	__time32_t*	cached_end
+	)
+{
+	CHECK (nullptr != cached_end);
+	const std::string key (MakeKey (query, start));
+	boost::lock_guard<boost::mutex> lock (lock_);
+	auto it = index_.find (key);
+	if (index_.end() != it) {
+		auto end_it = it->second.upper_bound (end);
+		if (it->second.begin() != end_it) {
+			--end_it;
+			const std::vector<bar_t>& results = end_it->second->results;
+			DCHECK (results.size() == query.size());
+			for (size_t rule_index = 0; rule_index < query.size(); ++rule_index)
+				results[rule_index].Restore (query[rule_index].get());
+			*cached_end = end_it->first;
+			entries_.splice (entries_.begin(), entries_, end_it->second);
+			if (end == end_it->first)
+				++hit_count_;
+			else
+				++resume_count_;
+			return true;
+		}
+	}
+	++miss_count_;
+	return false;
+}
+
+void
+hilo::result_cache_t::Insert (
+	const std::vector<std::shared_ptr<hilo_t>>& query,
+	__time32_t	start,
+	__time32_t	end
+	)
+{
+	if (0 == capacity_)
+		return;
+	std::string key (MakeKey (query, start));
+	std::vector<bar_t> results;
+	results.reserve (query.size());
+	std::for_each (query.begin(), query.end(), [&results](const std::shared_ptr<hilo_t>& it) {
+		results.push_back (bar_t (*it.get()));
+	});
+
+	boost::lock_guard<boost::mutex> lock (lock_);
+	std::map<__time32_t, std::list<entry_t>::iterator>& ends = index_[key];
+	auto end_it = ends.find (end);
+	if (ends.end() != end_it) {
+/* racing query of the same window */
+		end_it->second->results.swap (results);
+		entries_.splice (entries_.begin(), entries_, end_it->second);
+		return;
+	}
+	entries_.push_front (entry_t());
+	entry_t& entry = entries_.front();
+	entry.key.swap (key);
+	entry.end = end;
+	entry.results.swap (results);
+	ends.emplace (std::make_pair (end, entries_.begin()));
+
+	while (entries_.size() > capacity_) {
+		const entry_t& victim = entries_.back();
+		auto victim_it = index_.find (victim.key);
+		victim_it->second.erase (victim.end);
+		if (victim_it->second.empty())
+			index_.erase (victim_it);
+		entries_.pop_back();
+		++eviction_count_;
+	}
+}
+
+uint64_t
+hilo::result_cache_t::GetHitCount() const
+{
+	boost::lock_guard<boost::mutex> lock (lock_);
+	return hit_count_;
+}
+
+uint64_t
+hilo::result_cache_t::GetResumeCount() const
+{
+	boost::lock_guard<boost::mutex> lock (lock_);
+	return resume_count_;
+}
+
+uint64_t
+hilo::result_cache_t::GetMissCount() const
+{
+	boost::lock_guard<boost::mutex> lock (lock_);
+	return miss_count_;
+}
+
+uint64_t
+hilo::result_cache_t::GetEvictionCount() const
+{
+	boost::lock_guard<boost::mutex> lock (lock_);
+	return eviction_count_;
+}
+
+/* eof */
@@ -0,0 +1,77 @@
+/* Window query result cache.
+ *
+ * Bounded least recently used set of rule set results keyed by the canonical
+ * rules and the window [start, end).  Only windows ending by the last
+ * completed interval are held as their ticks no longer change.  A lookup
+ * returns the longest held window from the same start so a window extending
+ * it resumes from the held leg state.
+ */
+
+#ifndef __RESULT_CACHE_HH__
+#define __RESULT_CACHE_HH__
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* Boost noncopyable base class. */
+#include <boost/utility.hpp>
+
+/* Boost threading. */
+#include <boost/thread.hpp>
+
+#include "get_hilo.hh"
+
+namespace hilo
+{
+	class result_cache_t : boost::noncopyable
+	{
+	public:
+		explicit result_cache_t (size_t capacity);
+
+		void Clear();
+
+/* Restore the rules to the longest held window [start, *cached_end) with
+ * *cached_end no later than end, false if none and the rules are unchanged.
+ * Counts a hit when the whole window is held, a resume or a miss otherwise.
+ */
+		bool Lookup (const std::vector<std::shared_ptr<hilo_t>>& query, __time32_t start, __time32_t end, __time32_t* cached_end);
+
+/* Hold the rule results and leg state over [start, end). */
+		void Insert (const std::vector<std::shared_ptr<hilo_t>>& query, __time32_t start, __time32_t end);
+
+		uint64_t GetHitCount() const;
+		uint64_t GetResumeCount() const;
+		uint64_t GetMissCount() const;
+		uint64_t GetEvictionCount() const;
+
+	private:
+		class entry_t
+		{
+		public:
+			std::string key;
+			__time32_t end;
+			std::vector<bar_t> results;
+		};
+
+		static std::string MakeKey (const std::vector<std::shared_ptr<hilo_t>>& query, __time32_t start);
+
+		mutable boost::mutex lock_;
+		size_t capacity_;
+/* most recently used first. */
+		std::list<entry_t> entries_;
+/* rule set and start to entries by window end. */
+		std::unordered_map<std::string, std::map<__time32_t, std::list<entry_t>::iterator>> index_;
+		uint64_t hit_count_, resume_count_, miss_count_, eviction_count_;
+	};
+
+} /* namespace hilo */
+
+#endif /* __RESULT_CACHE_HH__ */
+
+/* eof */
@@ -0,0 +1,100 @@
+/* Parsed Tcl rule lists.
+ */
+
+#include "rule_cache.hh"
+
+#include <algorithm>
+
+#include "chromium/logging.hh"
+#include "rule_plan.hh"
+
+hilo::rule_cache_t::rule_cache_t (
+	size_t		capacity
+	) :
+	capacity_ (capacity),
+	hit_count_ (0),
+	miss_count_ (0)
+{
+}
+
+void
+hilo::rule_cache_t::Clear()
+{
+	boost::lock_guard<boost::mutex> lock (lock_);
+	entries_.clear();
+	index_.clear();
+}
+
+bool
+hilo::rule_cache_t::Lookup (
+	const std::string& list_text,
+	std::vector<std::shared_ptr<hilo_t>>* query
+	)
+{
+	CHECK (nullptr != query);
+	std::vector<std::shared_ptr<const hilo_t>> rules;
+	{
+		boost::lock_guard<boost::mutex> lock (lock_);
+		auto it = index_.find (list_text);
+		if (index_.end() == it) {
+			++miss_count_;
+			return false;
+		}
+		entries_.splice (entries_.begin(), entries_, it->second);
+		rules = it->second->rules;
+		++hit_count_;
+	}
+/* definitions are immutable, copy outside the lock */
+	query->clear();
+	query->reserve (rules.size());
+	std::for_each (rules.begin(), rules.end(), [query](const std::shared_ptr<const hilo_t>& rule) {
+		query->push_back (CopyRule (*rule.get()));
+	});
+	return true;
+}
+
+void
+hilo::rule_cache_t::Insert (
+	const std::string& list_text,
+	const std::vector<std::shared_ptr<hilo_t>>& query
+	)
+{
+	if (0 == capacity_)
+		return;
+	entry_t entry;
+	entry.list_text = list_text;
+	entry.rules.reserve (query.size());
+	std::for_each (query.begin(), query.end(), [&entry](const std::shared_ptr<hilo_t>& rule) {
+		entry.rules.push_back (CopyRule (*rule.get()));
+	});
+	entry.plan = rule_plan_t::Get (query);
+
+	boost::lock_guard<boost::mutex> lock (lock_);
+	if (index_.end() != index_.find (list_text))
+		return;
+	entries_.push_front (entry_t());
+	entries_.front().list_text.swap (entry.list_text);
+	entries_.front().rules.swap (entry.rules);
+	entries_.front().plan.swap (entry.plan);
+	index_.emplace (std::make_pair (list_text, entries_.begin()));
+	while (entries_.size() > capacity_) {
+		index_.erase (entries_.back().list_text);
+		entries_.pop_back();
+	}
+}
+
+uint64_t
+hilo::rule_cache_t::GetHitCount() const
+{
+	boost::lock_guard<boost::mutex> lock (lock_);
+	return hit_count_;
+}
+
+uint64_t
+hilo::rule_cache_t::GetMissCount() const
+{
+	boost::lock_guard<boost::mutex> lock (lock_);
+	return miss_count_;
+}
+
+/* eof */
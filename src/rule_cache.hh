@@ -0,0 +1,69 @@
+/* Parsed Tcl rule lists.
+ *
+ * Bounded least recently used set of rule definitions keyed by the string
+ * representation of the Tcl symbol list, each holding the compiled plan of
+ * its rules.  A repeated list skips parsing and planning, every lookup returns
+ * new rules so concurrent queries of the same list do not share state.
+ */
+
+#ifndef __RULE_CACHE_HH__
+#define __RULE_CACHE_HH__
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* Boost noncopyable base class. */
+#include <boost/utility.hpp>
+
+/* Boost threading. */
+#include <boost/thread.hpp>
+
+#include "get_hilo.hh"
+
+namespace hilo
+{
+	class rule_plan_t;
+
+	class rule_cache_t : boost::noncopyable
+	{
+	public:
+		explicit rule_cache_t (size_t capacity);
+
+		void Clear();
+
+/* Cleared rules of the list into *query, false if not held. */
+		bool Lookup (const std::string& list_text, std::vector<std::shared_ptr<hilo_t>>* query);
+
+/* Hold the rule definitions of the list and compile their plan. */
+		void Insert (const std::string& list_text, const std::vector<std::shared_ptr<hilo_t>>& query);
+
+		uint64_t GetHitCount() const;
+		uint64_t GetMissCount() const;
+
+	private:
+		class entry_t
+		{
+		public:
+			std::string list_text;
+			std::vector<std::shared_ptr<const hilo_t>> rules;
+			std::shared_ptr<const rule_plan_t> plan;
+		};
+
+		mutable boost::mutex lock_;
+		size_t capacity_;
+/* most recently used first. */
+		std::list<entry_t> entries_;
+		std::unordered_map<std::string, std::list<entry_t>::iterator> index_;
+		uint64_t hit_count_, miss_count_;
+	};
+
+} /* namespace hilo */
+
+#endif /* __RULE_CACHE_HH__ */
+
+/* eof */
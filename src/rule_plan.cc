@@ -0,0 +1,255 @@
+/* Rule set compiled into symbol slots, bound fields and a compressed sparse
+ * row fan-out graph.
+ */
+
+#include "rule_plan.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <list>
+
+/* Boost Posix Time */
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+/* Boost threading. */
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
+
+#include "chromium/logging.hh"
+#include "math_op.hh"
+
+/* Compiled rule sets held, typically the timer rules and recent Tcl queries. */
+static const size_t kPlanCacheSize = 16;
+
+namespace {
+
+	typedef std::list<std::pair<std::string, std::shared_ptr<const hilo::rule_plan_t>>> plan_list_t;
+
+	boost::mutex g_plan_lock;
+/* most recently used first */
+	plan_list_t g_plan_list;
+	std::unordered_map<std::string, plan_list_t::iterator> g_plan_map;
+/* plans evicted from the list, alive while another owner holds them. */
+	std::unordered_map<std::string, std::weak_ptr<const hilo::rule_plan_t>> g_held_map;
+	uint64_t g_hit_count = 0, g_build_count = 0, g_build_us = 0;
+
+/* Most recently used plan, caller holds g_plan_lock. */
+	void
+	PushFront (
+		const std::string& key,
+		const std::shared_ptr<const hilo::rule_plan_t>& plan
+		)
+	{
+		g_plan_list.push_front (std::make_pair (key, plan));
+		g_plan_map.emplace (std::make_pair (key, g_plan_list.begin()));
+		if (g_plan_list.size() <= kPlanCacheSize)
+			return;
+		const plan_list_t::value_type& last = g_plan_list.back();
+		if (!last.second.unique()) {
+/* sweep released plans before the map outgrows the held set */
+			if (g_held_map.size() >= kPlanCacheSize) {
+				for (auto it = g_held_map.begin(); it != g_held_map.end();) {
+					if (it->second.expired())
+						it = g_held_map.erase (it);
+					else
+						++it;
+				}
+			}
+			g_held_map[last.first] = last.second;
+		}
+		g_plan_map.erase (last.first);
+		g_plan_list.pop_back();
+	}
+
+
+} /* anonymous namespace */
+
+hilo::rule_plan_t::rule_plan_t (
+	const std::vector<std::shared_ptr<hilo_t>>& query
+	)
+{
+	std::unordered_map<std::string, size_t> symbol_map;
+	auto AddSymbol = [&](const std::string& name) -> size_t {
+		auto it = symbol_map.find (name);
+		if (symbol_map.end() != it)
+			return it->second;
+		const size_t slot = symbol_ids_.size();
+		symbol_ids_.push_back (symbol_table_t::Intern (name));
+		symbol_set_.insert (name);
+		symbol_map.emplace (std::make_pair (name, slot));
+		return slot;
+	};
+	auto AddField = [&](const std::string& name) -> uint32_t {
+		auto it = field_map_.find (name);
+		if (field_map_.end() != it)
+			return static_cast<uint32_t> (it->second);
+		const size_t idx = field_map_.size();
+		field_map_.emplace (std::make_pair (name, idx));
+		return static_cast<uint32_t> (idx);
+	};
+
+	rules_.reserve (query.size());
+	std::for_each (query.begin(), query.end(), [&](const std::shared_ptr<hilo_t>& query_it) {
+		rule_t rule;
+		rule.first      = AddSymbol (query_it->legs.first.symbol_name);
+		rule.first_bid  = AddField (query_it->legs.first.bid_field);
+		rule.first_ask  = AddField (query_it->legs.first.ask_field);
+		rule.second     = symbol_index_t::npos;
+		rule.second_bid = rule.second_ask = 0;
+		if (query_it->is_synthetic) {
+			assert (query_it->legs.first.symbol_name != query_it->legs.second.symbol_name);
+			rule.second     = AddSymbol (query_it->legs.second.symbol_name);
+			rule.second_bid = AddField (query_it->legs.second.bid_field);
+			rule.second_ask = AddField (query_it->legs.second.ask_field);
+		}
+		rules_.push_back (rule);
+	});
+
+/* group of each edge end, non-synthetic rules have one end. */
+	auto FirstGroup = [&](size_t rule_index) -> int {
+		if (!query[rule_index]->is_synthetic)
+			return EDGE_NON_SYNTHETIC;
+		return (MATH_OP_TIMES == GetSyntheticOp (*query[rule_index].get())) ? EDGE_FIRST_LEG_TIMES : EDGE_FIRST_LEG_DIVIDE;
+	};
+	auto SecondGroup = [&](size_t rule_index) -> int {
+		return (MATH_OP_TIMES == GetSyntheticOp (*query[rule_index].get())) ? EDGE_SECOND_LEG_TIMES : EDGE_SECOND_LEG_DIVIDE;
+	};
+
+/* count, prefix sum, then fill in rule order */
+	offsets_.assign ((symbol_ids_.size() * EDGE_GROUP_COUNT) + 1, 0);
+	for (size_t rule_index = 0; rule_index < rules_.size(); ++rule_index) {
+		const rule_t& rule = rules_[rule_index];
+		++offsets_[1 + (rule.first * EDGE_GROUP_COUNT) + FirstGroup (rule_index)];
+		if (symbol_index_t::npos != rule.second)
+			++offsets_[1 + (rule.second * EDGE_GROUP_COUNT) + SecondGroup (rule_index)];
+	}
+	for (size_t i = 1; i < offsets_.size(); ++i)
+		offsets_[i] += offsets_[i - 1];
+
+	edges_.resize (offsets_.back());
+	std::vector<size_t> cursor (offsets_.begin(), offsets_.end() - 1);
+	for (size_t rule_index = 0; rule_index < rules_.size(); ++rule_index) {
+		const rule_t& rule = rules_[rule_index];
+		edge_t edge;
+		edge.rule       = static_cast<uint32_t> (rule_index);
+		edge.first_bid  = rule.first_bid;
+		edge.first_ask  = rule.first_ask;
+		edge.second_bid = rule.second_bid;
+		edge.second_ask = rule.second_ask;
+		if (symbol_index_t::npos == rule.second) {
+			edge.other = static_cast<uint32_t> (rule.first);
+			edges_[cursor[(rule.first * EDGE_GROUP_COUNT) + EDGE_NON_SYNTHETIC]++] = edge;
+			continue;
+		}
+		edge.other = static_cast<uint32_t> (rule.second);
+		edges_[cursor[(rule.first * EDGE_GROUP_COUNT) + FirstGroup (rule_index)]++] = edge;
+		edge.other = static_cast<uint32_t> (rule.first);
+		edges_[cursor[(rule.second * EDGE_GROUP_COUNT) + SecondGroup (rule_index)]++] = edge;
+	}
+
+/* per slot field lists, a leg usually reads two of the bound fields */
+	std::vector<std::vector<uint32_t>> slot_fields (symbol_ids_.size());
+	std::for_each (rules_.begin(), rules_.end(), [&](const rule_t& rule) {
+		slot_fields[rule.first].push_back (rule.first_bid);
+		slot_fields[rule.first].push_back (rule.first_ask);
+		if (symbol_index_t::npos == rule.second)
+			return;
+		slot_fields[rule.second].push_back (rule.second_bid);
+		slot_fields[rule.second].push_back (rule.second_ask);
+	});
+	field_offsets_.reserve (symbol_ids_.size() + 1);
+	field_offsets_.push_back (0);
+	std::for_each (slot_fields.begin(), slot_fields.end(), [this](std::vector<uint32_t>& fields) {
+		std::sort (fields.begin(), fields.end());
+		slot_fields_.insert (slot_fields_.end(), fields.begin(), std::unique (fields.begin(), fields.end()));
+		field_offsets_.push_back (slot_fields_.size());
+	});
+	DVLOG(1) << "Rule plan compiled, #" << rules_.size() << " rules, #" << symbol_ids_.size() << " symbols, #" << edges_.size() << " edges.";
+}
+
+/* Rule definitions in order, unit and record separators between values.
+ */
+std::string
+hilo::rule_plan_t::MakeKey (
+	const std::vector<std::shared_ptr<hilo_t>>& query
+	)
+{
+	std::string key;
+	std::for_each (query.begin(), query.end(), [&key](const std::shared_ptr<hilo_t>& query_it) {
+		key.append (query_it->legs.first.symbol_name);	key.push_back ('\x1f');
+		key.append (query_it->legs.first.bid_field);	key.push_back ('\x1f');
+		key.append (query_it->legs.first.ask_field);
+		if (query_it->is_synthetic) {
+			key.push_back ('\x1f');
+			key.push_back (MATH_OP_TIMES == GetSyntheticOp (*query_it.get()) ? '*' : '/');
+			key.push_back ('\x1f');
+			key.append (query_it->legs.second.symbol_name);	key.push_back ('\x1f');
+			key.append (query_it->legs.second.bid_field);	key.push_back ('\x1f');
+			key.append (query_it->legs.second.ask_field);
+		}
+		key.push_back ('\x1e');
+	});
+	return key;
+}
+
+std::shared_ptr<const hilo::rule_plan_t>
+hilo::rule_plan_t::Get (
+	const std::vector<std::shared_ptr<hilo_t>>& query
+	)
+{
+	using namespace boost::posix_time;
+	const std::string key (MakeKey (query));
+	{
+		boost::lock_guard<boost::mutex> lock (g_plan_lock);
+		auto it = g_plan_map.find (key);
+		if (g_plan_map.end() != it) {
+			g_plan_list.splice (g_plan_list.begin(), g_plan_list, it->second);
+			++g_hit_count;
+			return it->second->second;
+		}
+		auto held_it = g_held_map.find (key);
+		if (g_held_map.end() != held_it) {
+			std::shared_ptr<const rule_plan_t> plan (held_it->second.lock());
+			g_held_map.erase (held_it);
+			if ((bool)plan) {
+				PushFront (key, plan);
+				++g_hit_count;
+				return plan;
+			}
+		}
+	}
+/* compile outside the lock, a racing caller may compile the same rules. */
+	const ptime t0 (microsec_clock::universal_time());
+	std::shared_ptr<const rule_plan_t> plan (new rule_plan_t (query));
+	const time_duration td = microsec_clock::universal_time() - t0;
+	boost::lock_guard<boost::mutex> lock (g_plan_lock);
+	++g_build_count;
+	g_build_us += td.total_microseconds();
+	if (g_plan_map.end() != g_plan_map.find (key))
+		return plan;
+	PushFront (key, plan);
+	return plan;
+}
+
+uint64_t
+hilo::rule_plan_t::GetHitCount()
+{
+	boost::lock_guard<boost::mutex> lock (g_plan_lock);
+	return g_hit_count;
+}
+
+uint64_t
+hilo::rule_plan_t::GetBuildCount()
+{
+	boost::lock_guard<boost::mutex> lock (g_plan_lock);
+	return g_build_count;
+}
+
+uint64_t
+hilo::rule_plan_t::GetBuildMicroseconds()
+{
+	boost::lock_guard<boost::mutex> lock (g_plan_lock);
+	return g_build_us;
+}
+
+/* eof */
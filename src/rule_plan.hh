@@ -0,0 +1,129 @@
+/* Rule set compiled into symbol slots, bound fields and a compressed sparse
+ * row fan-out graph.
+ *
+ * Each symbol slot owns a contiguous run of edges per group: non-synthetic
+ * rules, then synthetic rules where the symbol is the first or second leg by
+ * operator.  Each slot also lists the bound fields its rules read so a tick
+ * caches only those.  Plans are immutable and shared by every query with the
+ * same rules.
+ */
+
+#ifndef __RULE_PLAN_HH__
+#define __RULE_PLAN_HH__
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* Boost noncopyable base class. */
+#include <boost/utility.hpp>
+
+#include "get_hilo.hh"
+#include "symbol_table.hh"
+
+namespace hilo
+{
+	class rule_plan_t : boost::noncopyable
+	{
+	public:
+		enum {
+			EDGE_NON_SYNTHETIC = 0,
+			EDGE_FIRST_LEG_TIMES,
+			EDGE_FIRST_LEG_DIVIDE,
+			EDGE_SECOND_LEG_TIMES,
+			EDGE_SECOND_LEG_DIVIDE,
+			EDGE_GROUP_COUNT
+		};
+
+/* rule index, slot of the other leg and field indices of both legs. */
+		struct edge_t {
+			uint32_t rule;
+			uint32_t other;
+			uint32_t first_bid, first_ask;
+			uint32_t second_bid, second_ask;
+		};
+
+/* leg slots and field indices per rule, second is npos if not synthetic. */
+		struct rule_t {
+			size_t first, second;
+			uint32_t first_bid, first_ask;
+			uint32_t second_bid, second_ask;
+		};
+
+		explicit rule_plan_t (const std::vector<std::shared_ptr<hilo_t>>& query);
+
+/* Shared plan of the rule set, compiled on first use.  A plan still held by
+ * the caller, such as the timer rules or a cached Tcl list, is found after it
+ * leaves the recently used set.
+ */
+		static std::shared_ptr<const rule_plan_t> Get (const std::vector<std::shared_ptr<hilo_t>>& query);
+/* Canonical text of the rule legs, fields and operators in rule order. */
+		static std::string MakeKey (const std::vector<std::shared_ptr<hilo_t>>& query);
+
+/* Process wide lookups served by an existing plan, plans compiled and their
+ * total compile time.
+ */
+		static uint64_t GetHitCount();
+		static uint64_t GetBuildCount();
+		static uint64_t GetBuildMicroseconds();
+
+		size_t GetSymbolCount() const {
+			return symbol_ids_.size();
+		}
+		size_t GetFieldCount() const {
+			return field_map_.size();
+		}
+		size_t GetRuleCount() const {
+			return rules_.size();
+		}
+		symbol_id_t GetSymbolId (size_t slot) const {
+			return symbol_ids_[slot];
+		}
+		const std::set<std::string>& GetSymbolSet() const {
+			return symbol_set_;
+		}
+		const std::unordered_map<std::string, size_t>& GetFieldMap() const {
+			return field_map_;
+		}
+		const rule_t& GetRule (size_t rule_index) const {
+			return rules_[rule_index];
+		}
+
+/* Edges of one group of a symbol slot. */
+		const edge_t* begin (size_t slot, int group) const {
+			return edges_.data() + offsets_[(slot * EDGE_GROUP_COUNT) + group];
+		}
+		const edge_t* end (size_t slot, int group) const {
+			return edges_.data() + offsets_[(slot * EDGE_GROUP_COUNT) + group + 1];
+		}
+
+/* Ascending field indices read by any rule with the slot as a leg. */
+		const uint32_t* field_begin (size_t slot) const {
+			return slot_fields_.data() + field_offsets_[slot];
+		}
+		const uint32_t* field_end (size_t slot) const {
+			return slot_fields_.data() + field_offsets_[slot + 1];
+		}
+
+	private:
+		std::vector<symbol_id_t> symbol_ids_;
+		std::set<std::string> symbol_set_;
+		std::unordered_map<std::string, size_t> field_map_;
+		std::vector<rule_t> rules_;
+/* EDGE_GROUP_COUNT runs per slot, offsets_ has one trailing entry. */
+		std::vector<size_t> offsets_;
+		std::vector<edge_t> edges_;
+/* used fields per slot, field_offsets_ has one trailing entry. */
+		std::vector<size_t> field_offsets_;
+		std::vector<uint32_t> slot_fields_;
+	};
+
+} /* namespace hilo */
+
+#endif /* __RULE_PLAN_HH__ */
+
+/* eof */
@@ -531,6 +531,7 @@ hilo::session_t::ResetTokens()
 			cumulative_stats_[SESSION_PC_TOKENS_GENERATED]++;
 		}
 	});
+	++provider_->refresh_generation_;
 	return true;
 }
 
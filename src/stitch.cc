@@ -16,7 +16,16 @@
 
 #include "chromium/logging.hh"
 #include "microsoft/unique_handle.hh"
+#include "bar_encoder.hh"
+#include "bar_journal.hh"
 #include "get_hilo.hh"
+#include "result_cache.hh"
+#include "rule_cache.hh"
+#include "rule_plan.hh"
+#include "stream_engine.hh"
+#include "thread_pool.hh"
+#include "tick_cache.hh"
+#include "tick_feed.hh"
 #include "snmp_agent.hh"
 #include "error.hh"
 #include "rfa_logging.hh"
@@ -36,12 +45,16 @@ static const int kFieldListId = 3;
 /* RDF direct limit on symbol list entries */
 static const unsigned kSymbolListLimit = 150;
 
-/* RDM FIDs. */
-static const int kRdmTimeOfUpdateId	= 5;
-static const int kRdmTodaysHighId	= 12;
-static const int kRdmTodaysLowId	= 13;
-static const int kRdmActiveDateId	= 17;
+/* Tcl symbol lists held parsed. */
+static const size_t kRuleCacheSize = 64;
+
+/* FNV-1a of published field values for delta publishing. */
+static const uint64_t kDigestBasis = UINT64_C(14695981039346656037);
+
+/* Published bars per encoder task. */
+static const size_t kEncodeBatchSize = 256;
 
+/* RDM FIDs. */
 static const int kRdmReferenceCountId	= 239;
 static const int kRdmLinkId[]		= { 800, 801, 802, 803, 804, 805, 806, 807, 808, 809, 810, 811, 812, 813 };
 static const int kRdmNextLinkId		= 815;
@@ -50,6 +63,13 @@ static const int kRdmPreviousLinkId	= 814;
 /* FlexRecord Quote identifier. */
 static const uint32_t kQuoteId = 40002;
 
+/* Tick feed polling period, settling delay for late inserts, and the longest
+ * wait at an interval end for the feed to catch up before scanning instead.
+ */
+static const unsigned kFeedPollMs = 250;
+static const unsigned kFeedSettleSeconds = 1;
+static const int kFeedWaitSeconds = 5;
+
 /* Default FlexRecord fields. */
 static const char* kDefaultBidField = "BidPrice";
 static const char* kDefaultAskField = "AskPrice";
@@ -76,6 +96,39 @@ to_unix_epoch (
 	return (t - boost::posix_time::ptime (kUnixEpoch)).total_seconds();
 }
 
+static inline
+uint64_t
+Digest (
+	uint64_t	hash,
+	const void*	data,
+	size_t		len
+	)
+{
+	const uint8_t* octets = static_cast<const uint8_t*> (data);
+	for (size_t i = 0; i < len; ++i) {
+		hash ^= octets[i];
+		hash *= UINT64_C(1099511628211);
+	}
+	return hash;
+}
+
+/* Published fields of a price item: TIMACT and ACTIV_DATE from the interval
+ * end, HIGH_1 and LOW_1 mantissas.
+ */
+static inline
+uint64_t
+BarDigest (
+	__time32_t		end_time,
+	const hilo::bar_t&	bar
+	)
+{
+	uint64_t digest = kDigestBasis;
+	digest = Digest (digest, &end_time, sizeof (end_time));
+	digest = Digest (digest, &bar.high_mantissa, sizeof (bar.high_mantissa));
+	digest = Digest (digest, &bar.low_mantissa, sizeof (bar.low_mantissa));
+	return digest;
+}
+
 bool
 hilo::stitch_t::ParseRule (
 	const std::string&	str,
@@ -156,7 +209,15 @@ hilo::stitch_t::ParseRule (
 }
 
 hilo::stitch_t::stitch_t() :
+	engine_ (ENGINE_SINGLE_ITERATOR),
+	shard_count_ (1),
+	chunk_symbols_ (0),
 	is_shutdown_ (false),
+	late_window_ (0),
+	is_publish_once_ (false),
+	published_bar_count_ (0),
+	historical_refresh_generation_ (0),
+	historical_refresh_due_ (boost::posix_time::neg_infin),
 	last_activity_ (boost::posix_time::microsec_clock::universal_time()),
 	min_tcl_time_ (boost::posix_time::pos_infin),
 	max_tcl_time_ (boost::posix_time::neg_infin),
@@ -227,6 +288,35 @@ hilo::stitch_t::Init()
 {
 	LOG(INFO) << config_;
 
+/* calculation engine */
+	if (!ParseEngine (config_.engine, &engine_)) {
+		LOG(ERROR) << "Unknown engine \"" << config_.engine << "\".";
+		return false;
+	}
+	size_t encode_threads = 1, tick_cache_mb = 0, result_cache_size = 0, late_window = 0;
+	if (!ParseNonNegative ("shards", config_.shards, 1, &shard_count_) ||
+	    !ParseNonNegative ("encode threads", config_.encode_threads, 1, &encode_threads) ||
+	    !ParseNonNegative ("chunk symbols", config_.chunk_symbols, 0, &chunk_symbols_) ||
+	    !ParseNonNegative ("tick cache size", config_.tick_cache, 0, &tick_cache_mb) ||
+	    !ParseNonNegative ("result cache size", config_.result_cache, 0, &result_cache_size) ||
+	    !ParseNonNegative ("late window", config_.late_window, 0, &late_window))
+	{
+		return false;
+	}
+	if (shard_count_ > 1)
+		shard_pool_.reset (new thread_pool_t (shard_count_));
+	if (encode_threads > 1)
+		encode_pool_.reset (new thread_pool_t (encode_threads));
+	if (tick_cache_mb > 0)
+		tick_cache_.reset (new tick_cache_t (tick_cache_mb * 1024 * 1024));
+	if (result_cache_size > 0)
+		result_cache_.reset (new result_cache_t (result_cache_size));
+	if (!config_.journal.empty())
+		bar_journal_.reset (new bar_journal_t (config_.journal));
+	late_window_ = static_cast<int> (late_window);
+	is_publish_once_ = (0 == config_.historical_publish.compare ("once"));
+	rule_cache_.reset (new rule_cache_t (kRuleCacheSize));
+
 /** RFA initialisation. **/
 	try {
 /* RFA context. */
@@ -277,7 +367,7 @@ hilo::stitch_t::Init()
 
 			const int interval_seconds = std::stoi (config_.interval);
 			time_iterator time_it (start, seconds (interval_seconds));
-			unsigned link_count = 0;
+			std::vector<std::string> link_names;
 			while (++time_it <= end) {
 				const time_duration interval_end_tod = time_it->time_of_day();
 				std::ostringstream ss;
@@ -290,32 +380,27 @@ hilo::stitch_t::Init()
 				assert ((bool)historical_stream);
 				if (!provider_->CreateItemStream (ss.str().c_str(), historical_stream))
 					return false;
-				auto status = stream->historical.insert (std::make_pair (ss.str(), std::move (historical_stream)));
-				assert (true == status.second);
-
-				++link_count;
+				stream->historical.push_back (std::move (historical_stream));
+				link_names.push_back (ss.str());
 			}
 
-			assert (link_count > 0);
+			assert (link_names.size() > 0);
 
 /* marketfeed chain, not rdm symbol list */
-			for (int i = link_count - 1; i >= 0; i -= _countof (kRdmLinkId))
+			stream->chain.reset (new chain_t (symbol_name, link_names, _countof (kRdmLinkId)));
+			for (int j = (int)stream->chain->GetPageCount() - 1; j >= 0; j--)
 			{
-				const unsigned chain_index = (i > 0) ? (i / _countof (kRdmLinkId)) : 0;
-				std::ostringstream chain_name;
-				chain_name << chain_index
-					   << '#'
-					   << symbol_name;
+				chain_page_t& page = stream->chain->GetPage (j);
 				auto chain_stream = std::make_shared<item_stream_t> ();
 				assert ((bool)chain_stream);
-				if (!provider_->CreateItemStream (chain_name.str().c_str(), chain_stream))
+				if (!provider_->CreateItemStream (page.name.c_str(), chain_stream))
 					return false;
-				auto status = stream->chain.insert (std::make_pair (chain_name.str(), std::move (chain_stream)));
-				assert (true == status.second);
+				page.stream = std::move (chain_stream);
 			}
 
 			stream_vector_.push_back (std::move (stream));
 		}
+		query_plan_ = rule_plan_t::Get (query_vector_);
 
 	} catch (const rfa::common::InvalidUsageException& e) {
 		LOG(ERROR) << "InvalidUsageException: { "
@@ -381,6 +466,26 @@ hilo::stitch_t::Init()
 		return false;
 	}
 
+	try {
+/* Live tick feed from the start of the session.
+ */
+		if (!config_.feed.empty()) {
+			__time32_t last_reset_time;
+			GetLastResetTime (&last_reset_time);
+			stream_engine_.reset (new stream_engine_t (query_vector_));
+			stream_engine_->Align (last_reset_time, std::stoi (config_.interval));
+			tick_feed_.reset (new flexrec_feed_t (kFeedPollMs, kFeedSettleSeconds));
+			if (!tick_feed_->Subscribe (stream_engine_->GetSymbolSet(), stream_engine_->GetFieldMap(), last_reset_time, stream_engine_.get())) {
+				LOG(ERROR) << "Cannot subscribe tick feed.";
+				return false;
+			}
+		}
+	} catch (const std::exception& e) {
+		LOG(ERROR) << "TickFeed::Exception: { "
+			"\"What\": \"" << e.what() << "\" }";
+		return false;
+	}
+
 	try {
 /* Timer for periodic publishing.
  */
@@ -423,6 +528,10 @@ hilo::stitch_t::Clear()
 	timer_thread_.reset();
 	timer_.reset();
 
+/* Stop the tick feed before the engine it updates. */
+	tick_feed_.reset();
+	stream_engine_.reset();
+
 /* Close SNMP agent. */
 	snmp_agent_.reset();
 
@@ -438,6 +547,17 @@ hilo::stitch_t::Clear()
 	event_pump_.reset();
 	stream_vector_.clear();
 	query_vector_.clear();
+	bar_store_.Clear();
+	bar_journal_.reset();
+	watermarks_.clear();
+	has_watermark_.clear();
+	range_index_.Clear();
+	tick_cache_.reset();
+	result_cache_.reset();
+	rule_cache_.reset();
+	query_plan_.reset();
+	shard_pool_.reset();
+	encode_pool_.reset();
 	if ((bool)provider_)
 		provider_->Clear();
 	CHECK (provider_.use_count() <= 1);
@@ -630,13 +750,99 @@ hilo::stitch_t::SendRefresh()
 		LOG(INFO) << "refresh " << from_str << "-" << till_str;
 	}
 
-/* clear state for all items */
-	std::for_each (stream_vector_.begin(), stream_vector_.end(), [](const std::shared_ptr<broadcast_stream_t>& stream) {
-		stream->hilo->Clear();
-	});
+/* Bars are immutable once the interval has passed, discard the store only on
+ * a new session or when the clock has moved backwards.
+ */
+	const int interval_seconds = std::stoi (config_.interval);
+	if (bar_store_.GetResetTime() != last_reset_time ||
+	    bar_store_.GetIntervalSeconds() != interval_seconds ||
+	    bar_store_.GetRuleCount() != query_vector_.size() ||
+	    bar_store_.GetEndTime() > till)
+	{
+		bar_store_.Reset (last_reset_time, interval_seconds, query_vector_.size());
+		range_index_.Reset (last_reset_time, interval_seconds, 0 /* one day */);
+		watermarks_.clear();
+		has_watermark_.clear();
+		published_bar_count_ = 0;
+		if ((bool)tick_cache_)
+			tick_cache_->Reset();
+		if ((bool)stream_engine_)
+			stream_engine_->Align (last_reset_time, interval_seconds);
+/* bars of this session journaled before a restart */
+		if ((bool)bar_journal_) {
+			std::vector<std::vector<bar_t>> bars;
+			const size_t bar_count = bar_journal_->Open (last_reset_time, interval_seconds, query_vector_, (till - last_reset_time) / interval_seconds, &bars);
+			if (bar_count > 0) {
+				bar_store_.Append (bars, bar_count);
+				range_index_.Append (query_vector_, bars, bar_count);
+				LOG(INFO) << "Restored #" << bar_count << " bars from journal.";
+			}
+		}
+	}
 
-	DLOG(INFO) << "get_hilo /" << to_simple_string (ptime (kUnixEpoch, seconds (from))) << "/ /" << to_simple_string (ptime (kUnixEpoch, seconds (till))) << "/";
-	single_iterator::get_hilo (query_vector_, from, till);
+/* closed bars with late ticks, checked before the scan so that a tick landing
+ * in between is caught on the next refresh.
+ */
+	if (late_window_ > 0) {
+		const size_t late_count = RecalculateLateBars (interval_seconds);
+		if (late_count > 0)
+			LOG(INFO) << "Recalculated #" << late_count << " bars with late ticks.";
+	}
+
+/* calculate only the intervals missing from the store in one pass, typically
+ * the last, bars are reset before each interval as per hilo_t::Clear().
+ */
+	const __time32_t scan_from = bar_store_.GetEndTime();
+	if (scan_from < till)
+	{
+		const size_t bar_count = (till - scan_from) / interval_seconds;
+		const size_t scan_bar = bar_store_.GetBarCount();
+		std::vector<std::vector<bar_t>> bars;
+		std::vector<watermark_t> marks;
+/* streamed bars are complete once the feed has passed the interval end */
+		bool is_streamed = false;
+		if ((bool)stream_engine_) {
+			is_streamed = stream_engine_->Close (scan_from, till, seconds (kFeedWaitSeconds), &bars);
+			if (!is_streamed)
+				LOG(INFO) << "Streamed intervals incomplete, scanning.";
+			VLOG(1) << "stream engine ticks " << stream_engine_->GetTickCount() << " late " << stream_engine_->GetLateCount();
+		}
+		if (!is_streamed) {
+			DLOG(INFO) << "get_hilo /" << to_simple_string (ptime (kUnixEpoch, seconds (scan_from))) << "/ /" << to_simple_string (ptime (kUnixEpoch, seconds (till))) << "/";
+			scan_options_t options (tick_cache_.get(), true /* record */);
+			if (late_window_ > 0)
+				options.watermarks = &marks;
+/* bars of a failed tick source are incomplete, keep the store end so the next
+ * refresh scans the intervals again.
+ */
+			if (!hilo::sharded::get_hilo (engine_, shard_pool_.get(), shard_count_, chunk_symbols_, query_vector_, scan_from, till, interval_seconds, false /* reset legs */, &bars, options)) {
+				LOG(ERROR) << "Scan of #" << bar_count << " intervals failed, retrying on next refresh.";
+				return false;
+			}
+		}
+		bar_store_.Append (bars, bar_count);
+		range_index_.Append (query_vector_, bars, bar_count);
+		if ((bool)bar_journal_)
+			bar_journal_->Append (bars, bar_count);
+/* baseline for late ticks as read by the scan itself */
+		if (late_window_ > 0) {
+			watermarks_.resize (bar_store_.GetBarCount());
+			has_watermark_.resize (bar_store_.GetBarCount(), false);
+			for (size_t i = 0; i < marks.size() && i < bar_count; ++i) {
+				watermarks_[scan_bar + i] = marks[i];
+				has_watermark_[scan_bar + i] = true;
+			}
+		}
+		DLOG(INFO) << "scanned #" << bar_count << " of #" << bar_store_.GetBarCount() << " bars";
+		if ((bool)tick_cache_)
+			VLOG(1) << "tick cache " << tick_cache_->GetSizeBytes() << " bytes, hits " << tick_cache_->GetHitCount()
+				<< " partial " << tick_cache_->GetPartialCount() << " misses " << tick_cache_->GetMissCount();
+	}
+	CHECK (!bar_store_.empty());
+	CHECK (bar_store_.GetEndTime() == till);
+
+/* last interval for the analytic publish stream */
+	bar_store_.Restore (bar_store_.GetBarCount() - 1, query_vector_);
 
 /* 7.5.9.1 Create a response message (4.2.2) */
 	rfa::message::RespMsg response (false);	/* reference */
@@ -656,6 +862,13 @@ hilo::stitch_t::SendRefresh()
 	attribInfo.setServiceName (service_name);
 	response.setAttribInfo (attribInfo);
 
+/* Update of an item already refreshed whose fields changed. */
+	rfa::message::RespMsg update (false);	/* reference */
+	update.setMsgModelType (rfa::rdm::MMT_MARKET_PRICE);
+	update.setRespType (rfa::message::RespMsg::UpdateEnum);
+	update.setRespTypeNum (rfa::rdm::INSTRUMENT_UPDATE_UNSPECIFIED);
+	update.setAttribInfo (attribInfo);
+
 /* 6.2.8 Quality of Service. */
 	rfa::common::QualityOfService QoS;
 /* Timeliness: age of data, either real-time, unspecified delayed timeliness,
@@ -679,35 +892,6 @@ hilo::stitch_t::SendRefresh()
 	rfa::data::FieldListWriteIterator it;
 	rfa::data::FieldEntry field (false);
 	rfa::data::DataBuffer data (false);
-#ifdef CONFIG_32BIT_PRICE
-	rfa::data::Real32 real_value;
-	auto SetReal = [](rfa::data::DataBuffer*const data, const rfa::data::Real32& value) {
-		data->setReal32 (value);
-	};
-#else
-	rfa::data::Real64 real_value;
-	auto SetReal = [](rfa::data::DataBuffer*const data, const rfa::data::Real64& value) {
-		data->setReal64 (value);
-	};
-#endif /* CONFIG_32BIT_PRICE */
-	rfa::data::Time rfaTime;
-	rfa::data::Date rfaDate;
-	struct tm _tm;
-
-/* TIMEACT */
-	_gmtime32_s (&_tm, &till);
-	rfaTime.setHour   (_tm.tm_hour);
-	rfaTime.setMinute (_tm.tm_min);
-	rfaTime.setSecond (_tm.tm_sec);
-	rfaTime.setMillisecond (0);
-
-/* HIGH_1, LOW_1 as PRICE field type */
-	real_value.setMagnitudeType (bnymellon::kMagnitude);
-
-/* ACTIV_DATE */
-	rfaDate.setDay   (/* rfa(1-31) */ _tm.tm_mday        /* tm(1-31) */);
-	rfaDate.setMonth (/* rfa(1-12) */ 1 + _tm.tm_mon     /* tm(0-11) */);
-	rfaDate.setYear  (/* rfa(yyyy) */ 1900 + _tm.tm_year /* tm(yyyy-1900 */);
 
 	rfa::common::RespStatus status;
 /* Item interaction state: Open, Closed, ClosedRecover, Redirected, NonStreaming, or Unspecified. */
@@ -718,36 +902,11 @@ hilo::stitch_t::SendRefresh()
 	status.setStatusCode (rfa::common::RespStatus::NoneEnum);
 	response.setRespStatus (status);
 
-	std::for_each (stream_vector_.begin(), stream_vector_.end(), [&](const std::shared_ptr<broadcast_stream_t>& stream)
-	{
-		attribInfo.setName (stream->rfa_name);
-		it.start (fields_);
-/* TIMACT */
-		field.setFieldID (kRdmTimeOfUpdateId);
-		data.setTime (rfaTime);
-		field.setData (data), it.bind (field);
-
-/* PRICE field is a rfa::Real64 value specified as <mantissa>  10?.
- * Rfa deprecates setting via <double> data types so we create a mantissa from
- * source value and consider that we publish to 6 decimal places.
- */
-/* HIGH_1 */
-		field.setFieldID (kRdmTodaysHighId);
-		real_value.setValue (bnymellon::mantissa (stream->hilo->high));
-		SetReal (&data, real_value);
-		field.setData (data), it.bind (field);
-/* LOW_1 */
-		field.setFieldID (kRdmTodaysLowId);
-		real_value.setValue (bnymellon::mantissa (stream->hilo->low));
-		SetReal (&data, real_value);
-		field.setData (data), it.bind (field);
-/* ACTIV_DATE */
-		field.setFieldID (kRdmActiveDateId);
-		data.setDate (rfaDate);
-		field.setData (data), it.bind (field);
-
-		it.complete();
-		response.setPayload (fields_);
+/* encoded fields as a refresh or update per GetPublishType() */
+	auto Publish = [&](item_stream_t*const item_stream, uint64_t digest, int publish_type, const rfa::data::FieldList& payload) {
+		const bool is_refresh = (provider_t::PUBLISH_REFRESH == publish_type);
+		rfa::message::RespMsg& msg = is_refresh ? response : update;
+		msg.setPayload (payload);
 
 #ifdef DEBUG
 /* 4.2.8 Message Validation.  RFA provides an interface to verify that
@@ -755,217 +914,230 @@ hilo::stitch_t::SendRefresh()
  * Models as specified in RFA API 7 RDM Usage Guide.
  */
 		RFA_String warningText;
-		const uint8_t validation_status = response.validateMsg (&warningText);
+		const uint8_t validation_status = msg.validateMsg (&warningText);
 		if (rfa::message::MsgValidationWarning == validation_status) {
 			LOG(ERROR) << "respMsg::validateMsg: { \"warningText\": \"" << warningText << "\" }";
 		} else {
 			assert (rfa::message::MsgValidationOk == validation_status);
 		}
 #endif
-		provider_->Send (stream.get(), &response);
-		VLOG(1) << stream->rfa_name << " hi:" << stream->hilo->high << " lo:" << stream->hilo->low;
-	});
-
-/* create time period for bar and shift x-minutes for the specified range */
-	const auto end_time32 (till);
-	const int interval_seconds = std::stoi (config_.interval);
-	time_period tp (ptime (kUnixEpoch, seconds (last_reset_time)), seconds (interval_seconds));
-
-	while (true) {
-		const __time32_t from = to_unix_epoch<__time32_t> (tp.begin());
-		const __time32_t till = to_unix_epoch<__time32_t> (tp.end());
+		provider_->Send (item_stream, digest, is_refresh, &msg);
+	};
 
-/* inclusive of specified end time */
-		if (till > end_time32)
-			break;
+/* Bars to publish in stream order, every result is computed before encoding
+ * starts.
+ */
+	std::vector<publish_job_t> jobs;
+	auto AddJob = [&](item_stream_t*const item_stream, uint64_t digest, int publish_type, __time32_t end_time, const bar_t& bar) {
+		publish_job_t job;
+		job.item_stream  = item_stream;
+		job.digest       = digest;
+		job.publish_type = publish_type;
+		job.end_time     = end_time;
+		job.bar          = bar;
+		jobs.push_back (job);
+	};
 
-/* reset bars */
-		std::for_each (stream_vector_.begin(), stream_vector_.end(), [](const std::shared_ptr<broadcast_stream_t>& stream) {
-			stream->hilo->Clear();
-		});
+/* one clock read for every refresh check of this publish */
+	const boost::posix_time::ptime now (boost::posix_time::microsec_clock::universal_time());
+	const size_t last_bar_index = bar_store_.GetBarCount() - 1;
+	size_t rule_index = 0;
+	std::for_each (stream_vector_.begin(), stream_vector_.end(), [&](const std::shared_ptr<broadcast_stream_t>& stream)
+	{
+		const bar_t& bar = bar_store_.GetBar (last_bar_index, rule_index++);
+		const uint64_t digest = BarDigest (till, bar);
+		const int publish_type = provider_->GetPublishType (*stream.get(), digest, now);
+		if (provider_t::PUBLISH_NONE == publish_type)
+			return;
+		AddJob (stream.get(), digest, publish_type, till, bar);
+		VLOG(1) << stream->rfa_name << " hi:" << stream->hilo->high << " lo:" << stream->hilo->low;
+	});
 
-		DLOG(INFO) << "get_hilo /" << to_simple_string (ptime (kUnixEpoch, seconds (from))) << "/ /" << to_simple_string (ptime (kUnixEpoch, seconds (till))) << "/";
-		single_iterator::get_hilo (query_vector_, from, till);
-		
-/* create flexrecord for each pair */
-		std::ostringstream ss;
-		ss << std::setfill ('0')
-		   << '.'
-		   << std::setw (2) << tp.end().time_of_day().hours()
-		   << std::setw (2) << tp.end().time_of_day().minutes();
-
-/* TIMEACT */
-		_gmtime32_s (&_tm, &till);
-		rfaTime.setHour   (_tm.tm_hour);
-		rfaTime.setMinute (_tm.tm_min);
-		rfaTime.setSecond (_tm.tm_sec);
-		rfaTime.setMillisecond (0);
-
-/* ACTIV_DATE */
-		rfaDate.setDay   (/* rfa(1-31) */ _tm.tm_mday        /* tm(1-31) */);
-		rfaDate.setMonth (/* rfa(1-12) */ 1 + _tm.tm_mon     /* tm(0-11) */);
-		rfaDate.setYear  (/* rfa(yyyy) */ 1900 + _tm.tm_year /* tm(yyyy-1900 */);
+/* Historical bars from the store, in publish once mode bars already sent are
+ * skipped unless a refresh of the item is due, e.g. re-login or hilo_republish.
+ * Sent bars are only walked when a refresh can be due: the refresh generation
+ * changed or the earliest refresh interval of a sent item passed.
+ */
+	const size_t first_unpublished = is_publish_once_ ? published_bar_count_ : 0;
+	const uint64_t refresh_generation = provider_->GetRefreshGeneration();
+	const bool is_refresh_walk = refresh_generation != historical_refresh_generation_ || now >= historical_refresh_due_;
+	const boost::posix_time::time_duration& refresh_interval = provider_->GetRefreshInterval();
+	boost::posix_time::ptime refresh_due (is_refresh_walk ? boost::posix_time::pos_infin : historical_refresh_due_);
+/* forced until this publish completes */
+	historical_refresh_due_ = boost::posix_time::neg_infin;
+	for (size_t bar_index = is_refresh_walk ? 0 : first_unpublished; bar_index < bar_store_.GetBarCount(); ++bar_index)
+	{
+		const __time32_t till = bar_store_.GetBarEndTime (bar_index);
+		const bool is_published = bar_index < first_unpublished;
 
+		rule_index = 0;
 		std::for_each (stream_vector_.begin(), stream_vector_.end(), [&](const std::shared_ptr<broadcast_stream_t>& stream)
 		{
-			rfa::common::RFA_String rfa_name (stream->rfa_name);
-			rfa_name.append (ss.str().c_str());
-			attribInfo.setName (rfa_name);
-			it.start (fields_);
-/* TIMACT */
-			field.setFieldID (kRdmTimeOfUpdateId);
-			data.setTime (rfaTime);
-			field.setData (data), it.bind (field);
-
-/* PRICE field is a rfa::Real64 value specified as <mantissa>  10?.
- * Rfa deprecates setting via <double> data types so we create a mantissa from
- * source value and consider that we publish to 6 decimal places.
- */
-/* HIGH_1 */
-			field.setFieldID (kRdmTodaysHighId);
-			real_value.setValue (bnymellon::mantissa (stream->hilo->high));
-			SetReal (&data, real_value);
-			field.setData (data), it.bind (field);
-/* LOW_1 */
-			field.setFieldID (kRdmTodaysLowId);
-			real_value.setValue (bnymellon::mantissa (stream->hilo->low));
-			SetReal (&data, real_value);
-			field.setData (data), it.bind (field);
-/* ACTIV_DATE */
-			field.setFieldID (kRdmActiveDateId);
-			data.setDate (rfaDate);
-			field.setData (data), it.bind (field);
-
-			it.complete();
-			response.setPayload (fields_);
-
-#ifdef DEBUG
-/* 4.2.8 Message Validation.  RFA provides an interface to verify that
- * constructed messages of these types conform to the Reuters Domain
- * Models as specified in RFA API 7 RDM Usage Guide.
- */
-			RFA_String warningText;
-			const uint8_t validation_status = response.validateMsg (&warningText);
-			if (rfa::message::MsgValidationWarning == validation_status) {
-				LOG(ERROR) << "respMsg::validateMsg: { \"warningText\": \"" << warningText << "\" }";
+			const bar_t& bar = bar_store_.GetBar (bar_index, rule_index++);
+			DCHECK (bar_index < stream->historical.size());
+			item_stream_t*const item_stream = stream->historical[bar_index].get();
+			int publish_type = provider_t::PUBLISH_REFRESH;
+			uint64_t digest = 0;
+			if (is_published) {
+				if (!provider_->IsRefreshDue (*item_stream, now))
+					publish_type = provider_t::PUBLISH_NONE;
+				else
+					digest = BarDigest (till, bar);
 			} else {
-				assert (rfa::message::MsgValidationOk == validation_status);
+				digest = BarDigest (till, bar);
+				publish_type = provider_->GetPublishType (*item_stream, digest, now);
 			}
-#endif
-			const std::string key (rfa_name.c_str());
-			provider_->Send (stream->historical[key].get(), &response);
-			DVLOG(1) << rfa_name << " hi:" << stream->hilo->high << " lo:" << stream->hilo->low;
-
-/* do not reset analytic result set so next query extends previous result set */
-
+			if (refresh_interval > boost::posix_time::seconds (0)) {
+				const boost::posix_time::ptime due ((provider_t::PUBLISH_REFRESH == publish_type ? now : item_stream->refresh_time) + refresh_interval);
+				if (due < refresh_due)
+					refresh_due = due;
+			}
+			if (provider_t::PUBLISH_NONE == publish_type)
+				return;
+			AddJob (item_stream, digest, publish_type, till, bar);
+			DVLOG(1) << item_stream->rfa_name << " hi:" << bar.high << " lo:" << bar.low;
 		});
-
-		tp.shift (seconds (interval_seconds));
 	}
+	published_bar_count_ = bar_store_.GetBarCount();
 
-/* Publish a symbol list aka chain of all published historical item streams. */
-	std::vector<std::string> link_times;
-	link_times.reserve ((24 * 60 * 60) / interval_seconds);
-	const ptime last_reset_ptime (kUnixEpoch, seconds (last_reset_time));
-	const ptime till_ptime (kUnixEpoch, seconds (till));
-	for (time_iterator time_it (last_reset_ptime, seconds (interval_seconds)); ++time_it <= till_ptime;)
-	{
-		std::ostringstream ss;
-		ss << std::setfill ('0')
-		   << '.'
-		   << std::setw (2) << time_it->time_of_day().hours()
-		   << std::setw (2) << time_it->time_of_day().minutes();
-		link_times.push_back (ss.str());
+/* Encode serially on this thread, or in batches on the encoder pool each into
+ * its own field lists.  Batches are submitted in order as each completes so
+ * the message order of every stream and session is unchanged.
+ */
+	if (!(bool)encode_pool_) {
+		bar_encoder_t encoder;
+		std::for_each (jobs.begin(), jobs.end(), [&](const publish_job_t& job) {
+			attribInfo.setName (job.item_stream->rfa_name);
+			encoder.Encode (job.bar, job.end_time, &fields_);
+			Publish (job.item_stream, job.digest, job.publish_type, fields_);
+		});
+	} else {
+		const uint8_t rwf_major_version = provider_->GetRwfMajorVersion();
+		const uint8_t rwf_minor_version = provider_->GetRwfMinorVersion();
+		std::vector<std::unique_ptr<rfa::data::FieldList>> payloads (jobs.size());
+/* declared last so destruction waits for outstanding batches */
+		std::vector<std::unique_ptr<task_group_t>> batches;
+		for (size_t first = 0; first < jobs.size(); first += kEncodeBatchSize)
+		{
+			const size_t last = (jobs.size() - first) < kEncodeBatchSize ? jobs.size() : (first + kEncodeBatchSize);
+			std::unique_ptr<task_group_t> batch (new task_group_t (encode_pool_.get()));
+			batch->Post ([&jobs, &payloads, first, last, rwf_major_version, rwf_minor_version]() {
+				bar_encoder_t encoder;
+				for (size_t i = first; i < last; ++i) {
+/* RFA exceptions do not derive from std::exception, a failed job is left
+ * without a payload and re-encoded on the timer thread.  Anything else,
+ * including SEH exceptions under /EHa, propagates.
+ */
+					try {
+						std::unique_ptr<rfa::data::FieldList> payload (new rfa::data::FieldList);
+						payload->setAssociatedMetaInfo (rwf_major_version, rwf_minor_version);
+						payload->setInfo (kDictionaryId, kFieldListId);
+						encoder.Encode (jobs[i].bar, jobs[i].end_time, payload.get());
+						payloads[i] = std::move (payload);
+					} catch (const rfa::common::InvalidUsageException& e) {
+						LOG(WARNING) << "InvalidUsageException: { "
+							  "\"Severity\": \"" << internal::severity_string (e.getSeverity()) << "\""
+							", \"Classification\": \"" << internal::classification_string (e.getClassification()) << "\""
+							", \"StatusText\": \"" << e.getStatus().getStatusText() << "\" }";
+						payloads[i].reset();
+					} catch (const std::exception& e) {
+						LOG(WARNING) << "Encoding failed: { \"what\": \"" << e.what() << "\" }";
+						payloads[i].reset();
+					}
+				}
+			});
+			batches.push_back (std::move (batch));
+		}
+		bar_encoder_t encoder;
+		for (size_t i = 0; i < jobs.size(); ++i)
+		{
+			if (0 == (i % kEncodeBatchSize))
+				batches[i / kEncodeBatchSize]->Wait();
+			attribInfo.setName (jobs[i].item_stream->rfa_name);
+			if (!(bool)payloads[i]) {
+				LOG(WARNING) << "Encoding \"" << jobs[i].item_stream->rfa_name << "\" failed on the encode pool, encoding serially.";
+				encoder.Encode (jobs[i].bar, jobs[i].end_time, &fields_);
+				Publish (jobs[i].item_stream, jobs[i].digest, jobs[i].publish_type, fields_);
+				continue;
+			}
+			Publish (jobs[i].item_stream, jobs[i].digest, jobs[i].publish_type, *payloads[i]);
+			payloads[i].reset();
+		}
 	}
-	assert (link_times.size() > 0);
 
-	const size_t chain_index_max = link_times.size() / _countof (kRdmLinkId);
+	historical_refresh_generation_ = refresh_generation;
+	historical_refresh_due_        = refresh_due;
+
+/* Publish a symbol list aka chain of all published historical item streams,
+ * only pages whose links changed are sent as updates unless a refresh is due.
+ */
+	const size_t link_count = (till - last_reset_time) / interval_seconds;
+	assert (link_count > 0);
+
+/* unused links of every page encoded once */
+	RFA_String empty_string ("", 0, false);
+	rfa::data::DataBuffer empty_data (false);
+	empty_data.setFromString (empty_string, rfa::data::DataBuffer::StringRMTESEnum);
 	std::for_each (stream_vector_.begin(), stream_vector_.end(), [&](const std::shared_ptr<broadcast_stream_t>& stream)
 	{
+		chain_t& chain = *stream->chain;
+		chain.SetLinkCount (link_count);
+		const size_t tail_page = chain.GetTailPage();
 /* e.g. 0#.DJI .. 3#.DJI */
-		for (int j = chain_index_max; j >= 0; j--)
+		for (int j = (int)tail_page; j >= 0; j--)
 		{
-			size_t i = j * _countof (kRdmLinkId);
-			std::ostringstream ss;
-			ss << j
-			   << '#'
-			   << stream->rfa_name.c_str();
-			RFA_String rfa_name (ss.str().c_str(), (int)ss.str().length(), true);
+			chain_page_t& page = chain.GetPage (j);
+			const bool is_refresh_due = provider_->IsRefreshDue (*page.stream, now);
+			if (!page.is_dirty && !is_refresh_due)
+				continue;
+			RFA_String rfa_name (page.name.c_str(), (int)page.name.length(), false);
 			attribInfo.setName (rfa_name);
+			const uint32_t ref_count = (uint32_t)chain.GetLinkCount (j);
+			uint64_t digest = kDigestBasis;
+			digest = Digest (digest, &last_reset_time, sizeof (last_reset_time));
+			digest = Digest (digest, &tail_page, sizeof (tail_page));
+			digest = Digest (digest, &ref_count, sizeof (ref_count));
 
 			it.start (fields_);
 
 /* REF_COUNT */
 			field.setFieldID (kRdmReferenceCountId);
-			const uint32_t ref_count = min (_countof (kRdmLinkId), (uint32_t)(link_times.size() - i));
 			data.setUInt32 (ref_count);
 			field.setData (data), it.bind (field);
 /* LONGLINKx */
-			for (unsigned k = 0;
-			     k < _countof (kRdmLinkId);
-			     k++, i++)
+			for (unsigned k = 0; k < _countof (kRdmLinkId); k++)
 			{
 				field.setFieldID (kRdmLinkId[k]);
-				if (i < link_times.size()) {
-					RFA_String link_name (stream->rfa_name);
-					link_name.append (link_times[i].c_str());
-					data.setFromString (link_name, rfa::data::DataBuffer::StringRMTESEnum);
+				if (k < ref_count) {
+					const std::string& link_name = chain.GetLinkName (j, k);
+					data.setFromString (RFA_String (link_name.c_str(), (int)link_name.length(), false), rfa::data::DataBuffer::StringRMTESEnum);
 					field.setData (data), it.bind (field);
 				} else {
-					RFA_String empty_string ("", 0, false);
-					data.setFromString (empty_string, rfa::data::DataBuffer::StringRMTESEnum);
-					field.setData (data), it.bind (field);
-				}				
-			} 
+					field.setData (empty_data), it.bind (field);
+				}
+			}
 /* LONGPREVLR */
 			field.setFieldID (kRdmPreviousLinkId);
 			if (j > 0) {
-				std::ostringstream ss;
-				ss << (j - 1)
-				   << '#'
-				   << stream->rfa_name.c_str();
-				RFA_String previous_name (ss.str().c_str(), (int)ss.str().length(), true);
-				data.setFromString (previous_name, rfa::data::DataBuffer::StringRMTESEnum);
+				const std::string& previous_name = chain.GetPage (j - 1).name;
+				data.setFromString (RFA_String (previous_name.c_str(), (int)previous_name.length(), false), rfa::data::DataBuffer::StringRMTESEnum);
 				field.setData (data), it.bind (field);
 			} else {
-				RFA_String empty_string ("", 0, false);
-				data.setFromString (empty_string, rfa::data::DataBuffer::StringRMTESEnum);
-				field.setData (data), it.bind (field);
+				field.setData (empty_data), it.bind (field);
 			}
 /* LONGNEXTLR */
 			field.setFieldID (kRdmNextLinkId);
-			if (j < chain_index_max) {
-				std::ostringstream ss;
-				ss << (j + 1)
-				   << '#'
-				   << stream->rfa_name.c_str();
-				RFA_String next_name (ss.str().c_str(), (int)ss.str().length(), true);
-				data.setFromString (next_name, rfa::data::DataBuffer::StringRMTESEnum);
+			if ((size_t)j < tail_page) {
+				const std::string& next_name = chain.GetPage (j + 1).name;
+				data.setFromString (RFA_String (next_name.c_str(), (int)next_name.length(), false), rfa::data::DataBuffer::StringRMTESEnum);
 				field.setData (data), it.bind (field);
 			} else {
-				RFA_String empty_string ("", 0, false);
-				data.setFromString (empty_string, rfa::data::DataBuffer::StringRMTESEnum);
-				field.setData (data), it.bind (field);
+				field.setData (empty_data), it.bind (field);
 			}
 
 			it.complete();
-			response.setPayload (fields_);
-
-#ifdef DEBUG
-/* 4.2.8 Message Validation.  RFA provides an interface to verify that
- * constructed messages of these types conform to the Reuters Domain
- * Models as specified in RFA API 7 RDM Usage Guide.
- */
-			RFA_String warningText;
-			const uint8_t validation_status = response.validateMsg (&warningText);
-			if (rfa::message::MsgValidationWarning == validation_status) {
-				LOG(ERROR) << "respMsg::validateMsg: { \"warningText\": \"" << warningText << "\" }";
-			} else {
-				assert (rfa::message::MsgValidationOk == validation_status);
-			}
-#endif
-			const std::string key (rfa_name.c_str());
-			provider_->Send (stream->chain[key].get(), &response);
+			Publish (page.stream.get(), digest, is_refresh_due ? provider_t::PUBLISH_REFRESH : provider_t::PUBLISH_UPDATE, fields_);
+			page.is_dirty = false;
 		}
 	});
 
@@ -980,4 +1152,74 @@ hilo::stitch_t::SendRefresh()
 	return true;
 }
 
+/* The bar that just closed catches most late ticks and the bar leaving the
+ * late window any straggler before it is final, each is re-read with one
+ * cursor and compared with the watermark recorded when it was scanned.  Legs
+ * reset each interval so a changed bar is recalculated alone, later bars and
+ * the analytic stream are unaffected as every bar is republished from the
+ * store.  A failed recalculation keeps the old watermark so the bar is tried
+ * again as it leaves the window.
+ */
+size_t
+hilo::stitch_t::RecalculateLateBars (
+	int		interval_seconds
+	)
+{
+	const size_t bar_count = bar_store_.GetBarCount();
+	const size_t window_bars = (late_window_ + interval_seconds - 1) / interval_seconds;
+	if (0 == bar_count || 0 == window_bars)
+		return 0;
+	std::vector<size_t> probes (1, bar_count - 1);
+	if (window_bars > 1 && bar_count >= window_bars)
+		probes.push_back (bar_count - window_bars);
+
+	watermarks_.resize (bar_count);
+	has_watermark_.resize (bar_count, false);
+	size_t late_count = 0;
+	std::for_each (probes.begin(), probes.end(), [&](size_t bar_index) {
+		const __time32_t bar_start = bar_store_.GetBarStartTime (bar_index);
+		const __time32_t bar_end   = bar_store_.GetBarStartTime (bar_index + 1);
+		std::vector<watermark_t> marks;
+		if (!get_watermarks (query_vector_, bar_start, bar_end, interval_seconds, &marks)) {
+			LOG(WARNING) << "Late tick watermark of bar #" << bar_index << " incomplete, skipping check.";
+			return;
+		}
+		CHECK (1 == marks.size());
+/* streamed or journaled bars, first read is the baseline */
+		if (!has_watermark_[bar_index]) {
+			watermarks_[bar_index] = marks.front();
+			has_watermark_[bar_index] = true;
+			return;
+		}
+		if (watermarks_[bar_index] == marks.front())
+			return;
+		DLOG(INFO) << "late bar #" << bar_index;
+		std::vector<std::vector<bar_t>> bars;
+		std::vector<watermark_t> scan_marks;
+		scan_options_t options;
+		options.watermarks = &scan_marks;
+		if (!hilo::sharded::get_hilo (engine_, shard_pool_.get(), shard_count_, chunk_symbols_, query_vector_, bar_start, bar_end, interval_seconds, false /* reset legs */, &bars, options)) {
+			LOG(WARNING) << "Recalculating late bar #" << bar_index << " failed.";
+			return;
+		}
+		DCHECK (1 == scan_marks.size());
+		watermarks_[bar_index] = scan_marks.empty() ? marks.front() : scan_marks.front();
+		bar_store_.Replace (bar_index, bars, 1);
+		if (bar_index < published_bar_count_)
+			published_bar_count_ = bar_index;
+		range_index_.Replace (query_vector_, bar_index, bars, 1);
+		if ((bool)bar_journal_)
+			bar_journal_->Replace (bar_index, bars, 1);
+		++late_count;
+	});
+	if (late_count > 0) {
+/* recorded ticks and held results predate the late ticks */
+		if ((bool)tick_cache_)
+			tick_cache_->Reset();
+		if ((bool)result_cache_)
+			result_cache_->Clear();
+	}
+	return late_count;
+}
+
 /* eof */
\ No newline at end of file
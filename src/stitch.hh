@@ -26,8 +26,11 @@
 
 #include "chromium/logging.hh"
 
+#include "bar_store.hh"
+#include "chain.hh"
 #include "config.hh"
 #include "provider.hh"
+#include "range_index.hh"
 
 namespace logging
 {
@@ -52,10 +55,18 @@ namespace hilo
 		STITCH_PC_MAX
 	};
 
+	class bar_journal_t;
 	class hilo_t;
 	class rfa_t;
 	class provider_t;
+	class result_cache_t;
+	class rule_cache_t;
+	class rule_plan_t;
 	class snmp_agent_t;
+	class stream_engine_t;
+	class thread_pool_t;
+	class tick_cache_t;
+	class tick_feed_t;
 
 /* Basic state for each item stream. */
 	class broadcast_stream_t : public item_stream_t
@@ -67,8 +78,20 @@ namespace hilo
 		}
 
 		std::shared_ptr<hilo_t>	hilo;
-		std::unordered_map<std::string, std::shared_ptr<item_stream_t>> historical;
-		std::unordered_map<std::string, std::shared_ptr<item_stream_t>> chain;
+/* indexed by interval since the reset time. */
+		std::vector<std::shared_ptr<item_stream_t>> historical;
+		std::unique_ptr<chain_t> chain;
+	};
+
+/* Bar of one item to publish, computed before encoding. */
+	class publish_job_t
+	{
+	public:
+		item_stream_t* item_stream;
+		uint64_t digest;
+		int publish_type;
+		__time32_t end_time;
+		bar_t bar;
 	};
 
 	class event_pump_t
@@ -186,6 +209,18 @@ namespace hilo
 
 /* Broadcast out message. */
 		bool SendRefresh() throw (rfa::common::InvalidUsageException);
+/* Recalculate closed bars of the late window whose ticks changed since they
+ * were scanned, returns the number of bars replaced.  Each refresh re-reads
+ * only the bar that just closed and the bar leaving the window.
+ */
+		size_t RecalculateLateBars (int interval_seconds);
+
+/* Window query answered from the range index where possible, false if a
+ * cursor could not open.
+ */
+		bool GetHiloRange (const std::vector<std::shared_ptr<hilo_t>>& query, __time32_t start, __time32_t end);
+/* As GetHiloRange resuming from and holding results of completed intervals. */
+		void GetCachedHiloRange (const std::vector<std::shared_ptr<hilo_t>>& query, __time32_t start, __time32_t end);
 
 /* Unique instance number per process. */
 		LONG instance_;
@@ -197,6 +232,18 @@ namespace hilo
 /* Application configuration. */
 		config_t config_;
 
+/* Calculation engine from configuration. */
+		int engine_;
+
+/* Parallel cursor shards and their workers, no pool when serial. */
+		size_t shard_count_;
+		std::unique_ptr<thread_pool_t> shard_pool_;
+/* Symbols per cursor, zero for one cursor per shard. */
+		size_t chunk_symbols_;
+
+/* Message encoder workers, no pool when encoding on the timer thread. */
+		std::unique_ptr<thread_pool_t> encode_pool_;
+
 /* Significant failure has occurred, so ignore all runtime events flag. */
 		bool is_shutdown_;
 
@@ -235,6 +282,51 @@ namespace hilo
 		std::vector<std::shared_ptr<broadcast_stream_t>> stream_vector_;
 		boost::shared_mutex query_mutex_;
 
+/* Completed bars since last reset, protected by query_mutex_. */
+		bar_store_t bar_store_;
+
+/* Optional file copy of the bar store for restarts, protected by query_mutex_. */
+		std::unique_ptr<bar_journal_t> bar_journal_;
+
+/* Closed intervals re-checked for late ticks, zero for none.  Watermark of
+ * each bar as recorded by the scan that calculated it, has_watermark_ is false
+ * for streamed or journaled bars until first re-read.
+ */
+		int late_window_;
+		std::vector<watermark_t> watermarks_;
+		std::vector<bool> has_watermark_;
+
+/* Historical bars sent once as they close, bars before published_bar_count_
+ * are only re-sent when a refresh is due.  Late recalculation lowers the count
+ * to the first replaced bar.
+ */
+		bool is_publish_once_;
+		size_t published_bar_count_;
+/* Published bars are only walked for due refreshes when the provider refresh
+ * generation changes or at the earliest time the refresh interval can pass.
+ */
+		uint64_t historical_refresh_generation_;
+		boost::posix_time::ptime historical_refresh_due_;
+
+/* Per-symbol high-low over the same bars for arbitrary window queries. */
+		range_index_t range_index_;
+
+/* Optional ticks since last reset recorded by the timer scan. */
+		std::unique_ptr<tick_cache_t> tick_cache_;
+
+/* Optional hilo_query results of completed intervals. */
+		std::unique_ptr<result_cache_t> result_cache_;
+
+/* Parsed Tcl symbol lists, and the plan of the timer rules held so that Tcl
+ * queries never evict it.
+ */
+		std::unique_ptr<rule_cache_t> rule_cache_;
+		std::shared_ptr<const rule_plan_t> query_plan_;
+
+/* Optional live tick feed and the streaming engine it updates. */
+		std::unique_ptr<stream_engine_t> stream_engine_;
+		std::unique_ptr<tick_feed_t> tick_feed_;
+
 /* Event pump and thread. */
 		std::unique_ptr<event_pump_t> event_pump_;
 		std::unique_ptr<boost::thread> event_thread_;
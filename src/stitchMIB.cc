@@ -47,6 +47,9 @@ static_assert (__netsnmp_LOG_DEBUG   == LOG_DEBUG,   "LOG_DEBUG mismatch");
 #include "chromium/logging.hh"
 #include "stitch.hh"
 #include "provider.hh"
+#include "result_cache.hh"
+#include "rule_cache.hh"
+#include "rule_plan.hh"
 #include "session.hh"
 
 namespace hilo {
@@ -405,7 +408,7 @@ initialize_table_stitchPluginPerformanceTable(void)
 					  ASN_UNSIGNED,  /* index: stitchPluginPerformanceInstance */
 					  0);
 	table_info->min_column = COLUMN_STITCHTCLQUERYRECEIVED;
-	table_info->max_column = COLUMN_STITCHLASTMSGSSENT;
+	table_info->max_column = COLUMN_STITCHMSGSSUPPRESSED;
     
 	iinfo = SNMP_MALLOC_TYPEDEF( netsnmp_iterator_info );
 	if (nullptr == iinfo)
@@ -673,6 +676,99 @@ stitchPluginPerformanceTable_handler (
 				}
 				break;
 
+			case COLUMN_STITCHRESULTCACHEHITS:
+				{
+/* truncation of 64-bit counter */
+					const unsigned hits = (bool)stitch->result_cache_ ? (unsigned)stitch->result_cache_->GetHitCount() : 0;
+					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
+						(const u_char*)&hits, sizeof (hits));
+				}
+				break;
+
+			case COLUMN_STITCHRESULTCACHERESUMES:
+				{
+					const unsigned resumes = (bool)stitch->result_cache_ ? (unsigned)stitch->result_cache_->GetResumeCount() : 0;
+					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
+						(const u_char*)&resumes, sizeof (resumes));
+				}
+				break;
+
+			case COLUMN_STITCHRESULTCACHEMISSES:
+				{
+					const unsigned misses = (bool)stitch->result_cache_ ? (unsigned)stitch->result_cache_->GetMissCount() : 0;
+					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
+						(const u_char*)&misses, sizeof (misses));
+				}
+				break;
+
+			case COLUMN_STITCHRESULTCACHEEVICTIONS:
+				{
+					const unsigned evictions = (bool)stitch->result_cache_ ? (unsigned)stitch->result_cache_->GetEvictionCount() : 0;
+					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
+						(const u_char*)&evictions, sizeof (evictions));
+				}
+				break;
+
+			case COLUMN_STITCHRULECACHEHITS:
+				{
+					const unsigned hits = (bool)stitch->rule_cache_ ? (unsigned)stitch->rule_cache_->GetHitCount() : 0;
+					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
+						(const u_char*)&hits, sizeof (hits));
+				}
+				break;
+
+			case COLUMN_STITCHRULECACHEMISSES:
+				{
+					const unsigned misses = (bool)stitch->rule_cache_ ? (unsigned)stitch->rule_cache_->GetMissCount() : 0;
+					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
+						(const u_char*)&misses, sizeof (misses));
+				}
+				break;
+
+/* rule plans are shared by every instance of the process */
+			case COLUMN_STITCHRULEPLANHITS:
+				{
+					const unsigned hits = (unsigned)hilo::rule_plan_t::GetHitCount();
+					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
+						(const u_char*)&hits, sizeof (hits));
+				}
+				break;
+
+			case COLUMN_STITCHRULEPLANBUILDS:
+				{
+					const unsigned builds = (unsigned)hilo::rule_plan_t::GetBuildCount();
+					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
+						(const u_char*)&builds, sizeof (builds));
+				}
+				break;
+
+			case COLUMN_STITCHRULEPLANBUILDTIMEMEAN:
+				{
+					const uint64_t builds = hilo::rule_plan_t::GetBuildCount();
+					unsigned mean_build_time = 0;
+					if (builds > 0)
+						mean_build_time = (unsigned)(hilo::rule_plan_t::GetBuildMicroseconds() / builds);
+					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
+						(const u_char*)&mean_build_time, sizeof (mean_build_time));
+				}
+				break;
+
+			case COLUMN_STITCHUPDATESSENT:
+				{
+					const unsigned updates_sent = (bool)stitch->provider_ ? stitch->provider_->cumulative_stats_[PROVIDER_PC_UPDATES_SENT] : 0;
+					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
+						(const u_char*)&updates_sent, sizeof (updates_sent));
+				}
+				break;
+
+			case COLUMN_STITCHMSGSSUPPRESSED:
+				{
+					const unsigned msgs_suppressed = (bool)stitch->provider_ ? stitch->provider_->cumulative_stats_[PROVIDER_PC_MSGS_SUPPRESSED] : 0;
+					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
+						(const u_char*)&msgs_suppressed, sizeof (msgs_suppressed));
+				}
+				break;
+
 			default:
 				snmp_log (__netsnmp_LOG_ERR, "stitchPluginPerformanceTable_handler: unknown column.\n");
 				netsnmp_set_request_error (reqinfo, request, SNMP_NOSUCHOBJECT);
@@ -37,6 +37,17 @@ bool init_stitchMIB(void);
        #define COLUMN_STITCHTIMERSVCTIMEMAX		11
        #define COLUMN_STITCHMSGSSENT		12
        #define COLUMN_STITCHLASTMSGSSENT		13
+       #define COLUMN_STITCHRESULTCACHEHITS		14
+       #define COLUMN_STITCHRESULTCACHERESUMES		15
+       #define COLUMN_STITCHRESULTCACHEMISSES		16
+       #define COLUMN_STITCHRESULTCACHEEVICTIONS		17
+       #define COLUMN_STITCHRULECACHEHITS		18
+       #define COLUMN_STITCHRULECACHEMISSES		19
+       #define COLUMN_STITCHRULEPLANHITS		20
+       #define COLUMN_STITCHRULEPLANBUILDS		21
+       #define COLUMN_STITCHRULEPLANBUILDTIMEMEAN		22
+       #define COLUMN_STITCHUPDATESSENT		23
+       #define COLUMN_STITCHMSGSSUPPRESSED		24
 
 /* column number definitions for table stitchSessionTable */
        #define COLUMN_STITCHSESSIONPLUGINID		1
@@ -0,0 +1,278 @@
+/* Streaming high-low calculation fed by live ticks.
+ */
+
+#include "stream_engine.hh"
+
+#include <algorithm>
+
+#include "chromium/logging.hh"
+#include "math_op.hh"
+#include "rule_plan.hh"
+
+/* Seconds per day, closed intervals held for one session. */
+static const int kSecondsPerDay = 24 * 60 * 60;
+
+hilo::stream_engine_t::stream_engine_t (
+	const std::vector<std::shared_ptr<hilo_t>>& query
+	) :
+	plan_ (rule_plan_t::Get (query)),
+	field_count_ (plan_->GetFieldCount()),
+	interval_seconds_ (0),
+	bucket_end_ (0),
+	valid_from_ (0),
+	watermark_ (0),
+	closed_limit_ (0),
+	tick_count_ (0),
+	late_count_ (0)
+{
+	rules_.reserve (query.size());
+	std::for_each (query.begin(), query.end(), [this](const std::shared_ptr<hilo_t>& query_it) {
+		auto rule = std::make_shared<hilo_t>();
+		rule->name         = query_it->name;
+		rule->math_op      = query_it->math_op;
+		rule->is_synthetic = query_it->is_synthetic;
+		rules_.push_back (std::move (rule));
+	});
+	for (size_t slot = 0; slot < plan_->GetSymbolCount(); ++slot) {
+		const size_t index = symbol_index_.Insert (plan_->GetSymbolId (slot));
+		DCHECK (index == slot);
+	}
+	last_values_.resize (plan_->GetSymbolCount() * field_count_);
+	is_null_.resize (plan_->GetSymbolCount());
+	ClearState();
+}
+
+const std::set<std::string>&
+hilo::stream_engine_t::GetSymbolSet() const
+{
+	return plan_->GetSymbolSet();
+}
+
+const std::unordered_map<std::string, size_t>&
+hilo::stream_engine_t::GetFieldMap() const
+{
+	return plan_->GetFieldMap();
+}
+
+void
+hilo::stream_engine_t::Align (
+	__time32_t	reset_time,
+	int		interval_seconds
+	)
+{
+	CHECK (interval_seconds > 0);
+	boost::lock_guard<boost::mutex> lock (lock_);
+	if (interval_seconds == interval_seconds_ &&
+	    0 == ((bucket_end_ - reset_time) % interval_seconds))
+	{
+		return;
+	}
+	interval_seconds_ = interval_seconds;
+	closed_limit_     = 1 + (kSecondsPerDay / interval_seconds);
+	closed_.clear();
+	ClearState();
+/* intervals the feed has already entered are incomplete */
+	__time32_t start = reset_time;
+	if (watermark_ > reset_time)
+		start += ((watermark_ - reset_time + interval_seconds - 1) / interval_seconds) * interval_seconds;
+	valid_from_ = start;
+	bucket_end_ = start + interval_seconds;
+	DVLOG(1) << "Stream engine aligned, interval " << interval_seconds << "s valid from " << valid_from_ << ".";
+}
+
+bool
+hilo::stream_engine_t::Close (
+	__time32_t	from,
+	__time32_t	till,
+	boost::posix_time::time_duration timeout,
+	std::vector<std::vector<bar_t>>* bars
+	)
+{
+	CHECK (nullptr != bars);
+	boost::unique_lock<boost::mutex> lock (lock_);
+	if (0 == interval_seconds_ || till <= from || from < valid_from_ || 0 != ((till - from) % interval_seconds_))
+		return false;
+	const boost::system_time deadline = boost::get_system_time() + timeout;
+	while (watermark_ < till) {
+		if (!watermark_cond_.timed_wait (lock, deadline)) {
+			LOG(WARNING) << "Tick feed behind interval end by " << (till - watermark_) << "s.";
+			return false;
+		}
+	}
+	while (bucket_end_ <= till)
+		CloseBucket();
+
+/* discard intervals before from, consumed or superseded by a scan */
+	while (!closed_.empty() && closed_.front().first <= from)
+		closed_.pop_front();
+	const size_t bar_count = static_cast<size_t> ((till - from) / interval_seconds_);
+	if (closed_.size() < bar_count ||
+	    closed_.front().first != (from + interval_seconds_))
+	{
+		return false;
+	}
+	bars->assign (rules_.size(), std::vector<bar_t>());
+	for (size_t rule_index = 0; rule_index < rules_.size(); ++rule_index) {
+		std::vector<bar_t>& rule_bars = (*bars)[rule_index];
+		rule_bars.reserve (bar_count);
+		for (size_t i = 0; i < bar_count; ++i)
+			rule_bars.push_back (closed_[i].second[rule_index]);
+	}
+	closed_.erase (closed_.begin(), closed_.begin() + bar_count);
+	return true;
+}
+
+void
+hilo::stream_engine_t::OnTick (
+	const char*	symbol_name,
+	__time32_t	timestamp,
+	const std::vector<double>& fields
+	)
+{
+	DCHECK (fields.size() == field_count_);
+	boost::lock_guard<boost::mutex> lock (lock_);
+	if (0 == interval_seconds_)
+		return;
+	++tick_count_;
+/* closed intervals are immutable */
+	if (timestamp < (bucket_end_ - interval_seconds_)) {
+		++late_count_;
+		return;
+	}
+	while (timestamp >= bucket_end_)
+		CloseBucket();
+	const size_t slot = symbol_index_.Find (symbol_name);
+	if (symbol_index_t::npos == slot) {
+		LOG(WARNING) << "Unexpected symbol \"" << symbol_name << "\" in tick feed.";
+		return;
+	}
+
+/* non-synthetic */
+	for (const rule_plan_t::edge_t* it = plan_->begin (slot, rule_plan_t::EDGE_NON_SYNTHETIC); it != plan_->end (slot, rule_plan_t::EDGE_NON_SYNTHETIC); ++it)
+		UpdateNonSynthetic (rules_[it->rule].get(), fields[it->first_bid], fields[it->first_ask]);
+/* synthetics */
+	is_null_[slot] = false;
+	double*const last_values = last_values_.data() + (slot * field_count_);
+	for (const uint32_t* field = plan_->field_begin (slot); field != plan_->field_end (slot); ++field)
+		last_values[*field] = fields[*field];
+	UpdateSynthetics<MATH_OP_TIMES,  true>  (slot, rule_plan_t::EDGE_FIRST_LEG_TIMES);
+	UpdateSynthetics<MATH_OP_DIVIDE, true>  (slot, rule_plan_t::EDGE_FIRST_LEG_DIVIDE);
+	UpdateSynthetics<MATH_OP_TIMES,  false> (slot, rule_plan_t::EDGE_SECOND_LEG_TIMES);
+	UpdateSynthetics<MATH_OP_DIVIDE, false> (slot, rule_plan_t::EDGE_SECOND_LEG_DIVIDE);
+}
+
+void
+hilo::stream_engine_t::OnWatermark (
+	__time32_t	till
+	)
+{
+	boost::lock_guard<boost::mutex> lock (lock_);
+	if (till <= watermark_)
+		return;
+	watermark_ = till;
+	if (0 != interval_seconds_) {
+		while (bucket_end_ <= till)
+			CloseBucket();
+	}
+	watermark_cond_.notify_all();
+}
+
+uint64_t
+hilo::stream_engine_t::GetTickCount() const
+{
+	boost::lock_guard<boost::mutex> lock (lock_);
+	return tick_count_;
+}
+
+uint64_t
+hilo::stream_engine_t::GetLateCount() const
+{
+	boost::lock_guard<boost::mutex> lock (lock_);
+	return late_count_;
+}
+
+/* Save the open interval of every rule and start the next, lock held.
+ */
+void
+hilo::stream_engine_t::CloseBucket()
+{
+	std::vector<bar_t> bucket;
+	bucket.reserve (rules_.size());
+	for (size_t rule_index = 0; rule_index < rules_.size(); ++rule_index) {
+		hilo_t*const rule = rules_[rule_index].get();
+		const rule_plan_t::rule_t& slots = plan_->GetRule (rule_index);
+		const double*const first_leg = GetLastValues (slots.first);
+		rule->legs.first.is_null  = 0 != is_null_[slots.first];
+		rule->legs.first.last_bid = first_leg[slots.first_bid];
+		rule->legs.first.last_ask = first_leg[slots.first_ask];
+		if (rule->is_synthetic) {
+			const double*const second_leg = GetLastValues (slots.second);
+			rule->legs.second.is_null  = 0 != is_null_[slots.second];
+			rule->legs.second.last_bid = second_leg[slots.second_bid];
+			rule->legs.second.last_ask = second_leg[slots.second_ask];
+		}
+		bucket.push_back (bar_t (*rule));
+	}
+	closed_.push_back (std::make_pair (bucket_end_, std::move (bucket)));
+	if (closed_.size() > closed_limit_)
+		closed_.pop_front();
+	ClearState();
+	bucket_end_ += interval_seconds_;
+}
+
+/* Reset every rule and leg, equivalent to hilo_t::Clear().
+ */
+void
+hilo::stream_engine_t::ClearState()
+{
+	std::for_each (rules_.begin(), rules_.end(), [](const std::shared_ptr<hilo_t>& rule) {
+		rule->Clear();
+	});
+	std::fill (last_values_.begin(), last_values_.end(), 0.0);
+	std::fill (is_null_.begin(), is_null_.end(), true);
+}
+
+void
+hilo::stream_engine_t::UpdateNonSynthetic (
+	hilo_t*const	rule,
+	double		bid_price,
+	double		ask_price
+	)
+{
+	if (rule->is_null) {
+		rule->is_null = false;
+		rule->low     = bid_price;
+		rule->high    = ask_price;
+		return;
+	}
+	if (bid_price < rule->low)  rule->low  = bid_price;
+	if (ask_price > rule->high) rule->high = ask_price;
+}
+
+/* Fan-out to every synthetic of one edge group where slot is the IsFirstLeg
+ * leg, slot is non-null.
+ */
+template <int MathOp, bool IsFirstLeg>
+void
+hilo::stream_engine_t::UpdateSynthetics (
+	size_t		slot,
+	int		group
+	)
+{
+	const double*const values = GetLastValues (slot);
+	for (const rule_plan_t::edge_t* it = plan_->begin (slot, group); it != plan_->end (slot, group); ++it)
+	{
+		if (is_null_[it->other])
+			continue;
+		const double*const other = GetLastValues (it->other);
+		const double*const first_leg  = IsFirstLeg ? values : other;
+		const double*const second_leg = IsFirstLeg ? other : values;
+		UpdateSynthetic<MathOp> (rules_[it->rule].get(),
+					 first_leg[it->first_bid],
+					 first_leg[it->first_ask],
+					 second_leg[it->second_bid],
+					 second_leg[it->second_ask]);
+	}
+}
+
+/* eof */
@@ -0,0 +1,104 @@
+/* Streaming high-low calculation fed by live ticks.
+ *
+ * Rule and leg state is updated per tick through the compiled rule plan and
+ * closed into bars on interval boundaries, so the periodic refresh only
+ * collects completed bars.  Leg state is reset each interval as per the
+ * timer scan.
+ */
+
+#ifndef __STREAM_ENGINE_HH__
+#define __STREAM_ENGINE_HH__
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* Boost Posix Time */
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+/* Boost noncopyable base class. */
+#include <boost/utility.hpp>
+
+/* Boost threading. */
+#include <boost/thread.hpp>
+
+#include "get_hilo.hh"
+#include "symbol_table.hh"
+#include "tick_feed.hh"
+
+namespace hilo
+{
+	class rule_plan_t;
+
+	class stream_engine_t :
+		public tick_handler_t,
+		boost::noncopyable
+	{
+	public:
+		explicit stream_engine_t (const std::vector<std::shared_ptr<hilo_t>>& query);
+
+		const std::set<std::string>& GetSymbolSet() const;
+		const std::unordered_map<std::string, size_t>& GetFieldMap() const;
+
+/* Interval grid from reset_time, state is kept when the grid is unchanged
+ * otherwise bars are only complete from the next boundary after the
+ * watermark.
+ */
+		void Align (__time32_t reset_time, int interval_seconds);
+
+/* Completed bars[rule][interval] of [from, till), waits up to timeout for the
+ * feed to pass till.  False if any interval is not held.
+ */
+		bool Close (__time32_t from, __time32_t till, boost::posix_time::time_duration timeout, std::vector<std::vector<bar_t>>* bars);
+
+		virtual void OnTick (const char* symbol_name, __time32_t timestamp, const std::vector<double>& fields) override;
+		virtual void OnWatermark (__time32_t till) override;
+
+		uint64_t GetTickCount() const;
+		uint64_t GetLateCount() const;
+
+	private:
+		void CloseBucket();
+		void ClearState();
+		void UpdateNonSynthetic (hilo_t*const rule, double bid_price, double ask_price);
+		template <int MathOp, bool IsFirstLeg>
+		void UpdateSynthetics (size_t slot, int group);
+
+		const double* GetLastValues (size_t slot) const {
+			return last_values_.data() + (slot * field_count_);
+		}
+
+		mutable boost::mutex lock_;
+		boost::condition_variable watermark_cond_;
+
+		const std::shared_ptr<const rule_plan_t> plan_;
+		const size_t field_count_;
+/* private copies of the rules, the published rules are replayed from bars. */
+		std::vector<std::shared_ptr<hilo_t>> rules_;
+		symbol_index_t symbol_index_;
+		std::vector<double> last_values_;
+		std::vector<char> is_null_;
+
+		int interval_seconds_;
+/* open interval [bucket_end_ - interval_seconds_, bucket_end_). */
+		__time32_t bucket_end_;
+/* first interval with every tick delivered. */
+		__time32_t valid_from_;
+		__time32_t watermark_;
+/* closed intervals by end time, bars per rule. */
+		std::deque<std::pair<__time32_t, std::vector<bar_t>>> closed_;
+		size_t closed_limit_;
+
+		uint64_t tick_count_, late_count_;
+	};
+
+} /* namespace hilo */
+
+#endif /* __STREAM_ENGINE_HH__ */
+
+/* eof */
@@ -0,0 +1,189 @@
+/* Process-wide symbol interning and per-query symbol lookup.
+ */
+
+#include "symbol_table.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <deque>
+#include <unordered_map>
+
+/* Boost threading. */
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/locks.hpp>
+
+namespace {
+
+	boost::shared_mutex g_symbol_lock;
+/* deque for stable references on append. */
+	std::deque<std::string> g_symbol_names;
+	std::vector<uint32_t> g_symbol_hashes;
+	std::unordered_map<std::string, hilo::symbol_id_t> g_symbol_ids;
+
+} /* anonymous namespace */
+
+uint32_t
+hilo::symbol_table_t::Hash (
+	const char*	name,
+	size_t*		length
+	)
+{
+	const char* p = name;
+	uint32_t hash = 2166136261U;
+	while ('\0' != *p) {
+		hash ^= static_cast<unsigned char> (*p++);
+		hash *= 16777619U;
+	}
+	*length = p - name;
+	return hash;
+}
+
+hilo::symbol_id_t
+hilo::symbol_table_t::Intern (
+	const std::string& name
+	)
+{
+	{
+		boost::shared_lock<boost::shared_mutex> lock (g_symbol_lock);
+		auto it = g_symbol_ids.find (name);
+		if (g_symbol_ids.end() != it)
+			return it->second;
+	}
+	boost::unique_lock<boost::shared_mutex> lock (g_symbol_lock);
+/* raced by another caller */
+	auto it = g_symbol_ids.find (name);
+	if (g_symbol_ids.end() != it)
+		return it->second;
+	const symbol_id_t id = static_cast<symbol_id_t> (g_symbol_names.size());
+	size_t length;
+	g_symbol_names.push_back (name);
+	g_symbol_hashes.push_back (Hash (name.c_str(), &length));
+	g_symbol_ids.emplace (std::make_pair (name, id));
+	return id;
+}
+
+hilo::symbol_id_t
+hilo::symbol_table_t::Find (
+	const std::string& name
+	)
+{
+	boost::shared_lock<boost::shared_mutex> lock (g_symbol_lock);
+	auto it = g_symbol_ids.find (name);
+	return (g_symbol_ids.end() == it) ? kInvalidSymbolId : it->second;
+}
+
+const std::string&
+hilo::symbol_table_t::GetName (
+	symbol_id_t	id
+	)
+{
+	boost::shared_lock<boost::shared_mutex> lock (g_symbol_lock);
+	assert (id < g_symbol_names.size());
+	return g_symbol_names[id];
+}
+
+uint32_t
+hilo::symbol_table_t::GetHash (
+	symbol_id_t	id
+	)
+{
+	boost::shared_lock<boost::shared_mutex> lock (g_symbol_lock);
+	assert (id < g_symbol_hashes.size());
+	return g_symbol_hashes[id];
+}
+
+size_t
+hilo::symbol_table_t::size()
+{
+	boost::shared_lock<boost::shared_mutex> lock (g_symbol_lock);
+	return g_symbol_names.size();
+}
+
+hilo::symbol_index_t::symbol_index_t() :
+	mask_ (0),
+	last_name_ (nullptr),
+	last_interned_name_ (nullptr),
+	last_slot_ (npos)
+{
+	Rehash (16);
+}
+
+void
+hilo::symbol_index_t::Rehash (
+	size_t		capacity
+	)
+{
+	entry_t empty;
+	memset (&empty, 0, sizeof (empty));
+	std::vector<entry_t> table (capacity, empty);
+	const size_t mask = capacity - 1;
+	std::for_each (table_.begin(), table_.end(), [&](const entry_t& entry) {
+		if (nullptr == entry.name)
+			return;
+		size_t i = entry.hash & mask;
+		while (nullptr != table[i].name)
+			i = (i + 1) & mask;
+		table[i] = entry;
+	});
+	table_.swap (table);
+	mask_ = mask;
+}
+
+size_t
+hilo::symbol_index_t::Insert (
+	symbol_id_t	id
+	)
+{
+	const std::string& name = symbol_table_t::GetName (id);
+	const uint32_t hash = symbol_table_t::GetHash (id);
+	size_t i = hash & mask_;
+	while (nullptr != table_[i].name) {
+		if (table_[i].name == name.c_str())
+			return table_[i].slot;
+		i = (i + 1) & mask_;
+	}
+	const size_t slot = ids_.size();
+	ids_.push_back (id);
+	table_[i].name   = name.c_str();
+	table_[i].length = name.size();
+	table_[i].hash   = hash;
+	table_[i].slot   = static_cast<uint32_t> (slot);
+/* keep load factor at or below one half */
+	if ((2 * ids_.size()) > table_.size())
+		Rehash (2 * table_.size());
+	last_name_ = nullptr;
+	return slot;
+}
+
+size_t
+hilo::symbol_index_t::Find (
+	const char*	name
+	)
+{
+/* same buffer as the last hit, confirm the reader did not overwrite it. */
+	if (name == last_name_ &&
+	    0 == strcmp (name, last_interned_name_))
+	{
+		return last_slot_;
+	}
+	size_t length;
+	const uint32_t hash = symbol_table_t::Hash (name, &length);
+	size_t i = hash & mask_;
+	while (nullptr != table_[i].name) {
+		const entry_t& entry = table_[i];
+		if (entry.hash == hash &&
+		    entry.length == length &&
+		    0 == memcmp (entry.name, name, length))
+		{
+			last_name_          = name;
+			last_interned_name_ = entry.name;
+			last_slot_          = entry.slot;
+			return entry.slot;
+		}
+		i = (i + 1) & mask_;
+	}
+	return npos;
+}
+
+/* eof */
@@ -0,0 +1,96 @@
+/* Process-wide symbol interning and per-query symbol lookup.
+ *
+ * RICs are interned once when a query is built into dense integer ids, the
+ * cursor loop then resolves the reader's symbol name buffer through a fixed
+ * open addressing table without allocating or hashing a std::string.
+ */
+
+#ifndef __SYMBOL_TABLE_HH__
+#define __SYMBOL_TABLE_HH__
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace hilo
+{
+	typedef uint32_t symbol_id_t;
+
+	static const symbol_id_t kInvalidSymbolId = UINT32_MAX;
+
+/* Append only table shared by all plugin instances, ids and names are stable
+ * for the lifetime of the process.
+ */
+	class symbol_table_t
+	{
+	public:
+		static symbol_id_t Intern (const std::string& name);
+
+/* Returns kInvalidSymbolId if the name has never been interned. */
+		static symbol_id_t Find (const std::string& name);
+
+		static const std::string& GetName (symbol_id_t id);
+		static uint32_t GetHash (symbol_id_t id);
+		static size_t size();
+
+/* FNV-1a over a NULL terminated string, length returned as a side effect. */
+		static uint32_t Hash (const char* name, size_t* length);
+	};
+
+/* Immutable set of symbols referenced by one query, each mapped to a dense
+ * slot in insertion order.
+ */
+	class symbol_index_t
+	{
+	public:
+		static const size_t npos = SIZE_MAX;
+
+		symbol_index_t();
+
+/* Returns the slot of the interned symbol, adding it if new. */
+		size_t Insert (symbol_id_t id);
+
+/* Resolve a cursor symbol name into a slot, npos if not in the query.
+ *
+ * The last matched name pointer is cached, readers that keep a stable buffer
+ * per symbol skip hashing on repeat ticks.
+ */
+		size_t Find (const char* name);
+
+		symbol_id_t GetId (size_t slot) const {
+			return ids_[slot];
+		}
+		size_t size() const {
+			return ids_.size();
+		}
+		bool empty() const {
+			return ids_.empty();
+		}
+
+	private:
+		void Rehash (size_t capacity);
+
+		struct entry_t {
+			const char* name;	/* interned storage, nullptr if empty. */
+			size_t length;
+			uint32_t hash;
+			uint32_t slot;
+		};
+
+/* power of two, at most half full. */
+		std::vector<entry_t> table_;
+		size_t mask_;
+		std::vector<symbol_id_t> ids_;
+
+/* pointer keyed cache of the last hit. */
+		const char* last_name_;
+		const char* last_interned_name_;
+		size_t last_slot_;
+	};
+
+} /* namespace hilo */
+
+#endif /* __SYMBOL_TABLE_HH__ */
+
+/* eof */
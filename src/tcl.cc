@@ -16,6 +16,8 @@
 #include "chromium/logging.hh"
 #include "microsoft/unique_handle.hh"
 #include "get_hilo.hh"
+#include "result_cache.hh"
+#include "rule_cache.hh"
 #include "error.hh"
 #include "rfa_logging.hh"
 #include "rfaostream.hh"
@@ -152,6 +154,81 @@ hilo::stitch_t::execute (
 	return retval;
 }
 
+/* Whole indexed intervals of non-synthetic rules are folded from the range
+ * index between raw scans of the partial intervals at each edge, synthetic and
+ * unindexed rules scan the full window.
+ */
+bool
+hilo::stitch_t::GetHiloRange (
+	const std::vector<std::shared_ptr<hilo_t>>& query,
+	__time32_t	start,
+	__time32_t	end
+	)
+{
+	const scan_options_t options (tick_cache_.get(), false /* read */);
+	range_lookup_t lookup;
+	if (!range_index_.Lookup (query, start, end, &lookup))
+		return hilo::sharded::get_hilo (engine_, shard_pool_.get(), shard_count_, chunk_symbols_, query, start, end, options);
+
+	DLOG(INFO) << "range index /" << lookup.from << "/ /" << lookup.till << "/ #" << lookup.rule_indices.size() << " rules.";
+
+	std::vector<std::shared_ptr<hilo_t>> indexed, scanned;
+	auto index_it = lookup.rule_indices.begin();
+	for (size_t rule_index = 0; rule_index < query.size(); ++rule_index) {
+		if (lookup.rule_indices.end() != index_it && *index_it == rule_index) {
+			indexed.push_back (query[rule_index]);
+			++index_it;
+		} else {
+			scanned.push_back (query[rule_index]);
+		}
+	}
+
+	bool is_open = true;
+	if (!scanned.empty() && !hilo::sharded::get_hilo (engine_, shard_pool_.get(), shard_count_, chunk_symbols_, scanned, start, end, options))
+		is_open = false;
+/* leading partial interval, then the index, then trailing partial interval */
+	if (start < lookup.from && !hilo::sharded::get_hilo (engine_, shard_pool_.get(), shard_count_, chunk_symbols_, indexed, start, lookup.from, options))
+		is_open = false;
+	for (size_t i = 0; i < indexed.size(); ++i)
+		range_index_t::Fold (lookup.values[i], indexed[i].get());
+	if (lookup.till < end && !hilo::sharded::get_hilo (engine_, shard_pool_.get(), shard_count_, chunk_symbols_, indexed, lookup.till, end, options))
+		is_open = false;
+	return is_open;
+}
+
+/* Results to the end of the last completed interval no longer change, that
+ * part of the window resumes from the longest held window with the same start
+ * and is held when every cursor opened.  The remainder is always scanned.
+ */
+void
+hilo::stitch_t::GetCachedHiloRange (
+	const std::vector<std::shared_ptr<hilo_t>>& query,
+	__time32_t	start,
+	__time32_t	end
+	)
+{
+	if (!(bool)result_cache_) {
+		GetHiloRange (query, start, end);
+		return;
+	}
+	__time32_t completed_end;
+	GetEndOfLastInterval (&completed_end);
+	const __time32_t cacheable_end = (end < completed_end) ? end : completed_end;
+	__time32_t from = start;
+	if (start < cacheable_end) {
+		if (!result_cache_->Lookup (query, start, cacheable_end, &from))
+			from = start;
+		if (from < cacheable_end) {
+			DLOG(INFO) << "result cache resume /" << from << "/ /" << cacheable_end << "/";
+			if (GetHiloRange (query, from, cacheable_end))
+				result_cache_->Insert (query, start, cacheable_end);
+		}
+		from = cacheable_end;
+	}
+	if (from < end)
+		GetHiloRange (query, from, end);
+}
+
 /* hilo_query <symbol-list> [startTime] [endTime]
  */
 int
@@ -205,28 +282,35 @@ hilo::stitch_t::TclHiloQuery (
 
 	DLOG(INFO) << "symbol list with #" << listLen << " entries";
 
-/* Convert TCl list parameter into STL container. */
+/* Convert TCl list parameter into STL container, a repeated list is held parsed. */
+	int list_text_len = 0;
+	const char* list_text = Tcl_GetStringFromObj (objv[1], &list_text_len);
+	const std::string list_key (list_text, list_text_len);
 	std::vector<std::shared_ptr<hilo_t>> query;
-	for (int i = 0; i < listLen; i++)
+	if (!rule_cache_->Lookup (list_key, &query))
 	{
-		Tcl_Obj* objPtr = nullptr;
-
-		Tcl_ListObjIndex (interp, objv[1], i, &objPtr);
-
-		int len = 0;
-		char* rule_text = Tcl_GetStringFromObj (objPtr, &len);
-		auto rule = std::make_shared<hilo_t> ();
-		assert ((bool)rule);
-		if (len > 0 && ParseRule (rule_text, *rule.get())) {
-			query.push_back (rule);
-			DLOG(INFO) << "#" << (1 + i) << " " << rule->name;
-		} else {
-			Tcl_SetResult (interp, "bad symbol list", TCL_STATIC);
-			return TCL_ERROR;
+		for (int i = 0; i < listLen; i++)
+		{
+			Tcl_Obj* objPtr = nullptr;
+
+			Tcl_ListObjIndex (interp, objv[1], i, &objPtr);
+
+			int len = 0;
+			char* rule_text = Tcl_GetStringFromObj (objPtr, &len);
+			auto rule = std::make_shared<hilo_t> ();
+			assert ((bool)rule);
+			if (len > 0 && ParseRule (rule_text, *rule.get())) {
+				query.push_back (rule);
+				DLOG(INFO) << "#" << (1 + i) << " " << rule->name;
+			} else {
+				Tcl_SetResult (interp, "bad symbol list", TCL_STATIC);
+				return TCL_ERROR;
+			}
 		}
+		rule_cache_->Insert (list_key, query);
 	}
 
-	single_iterator::get_hilo (query, startTime, endTime);
+	GetCachedHiloRange (query, startTime, endTime);
 
 /* Convert STL container result set into a new Tcl list. */
 	Tcl_Obj* resultListPtr = Tcl_NewListObj (0, NULL);
@@ -342,6 +426,10 @@ hilo::stitch_t::TclFeedLogQuery (
 /* interval period */
 	long interval;
 	Tcl_GetLongFromObj (interp, objv[3], &interval);
+	if (interval <= 0) {
+		Tcl_SetResult (interp, "bad interval", TCL_STATIC);
+		return TCL_ERROR;
+	}
 
 	DLOG(INFO) << "interval=" << interval;
 
@@ -380,55 +468,64 @@ hilo::stitch_t::TclFeedLogQuery (
 
 	DLOG(INFO) << "symbol list with #" << listLen << " entries";
 
-/* Convert TCl list parameter into STL container. */
+/* Convert TCl list parameter into STL container, a repeated list is held parsed. */
+	int list_text_len = 0;
+	const char* list_text = Tcl_GetStringFromObj (objv[2], &list_text_len);
+	const std::string list_key (list_text, list_text_len);
 	std::vector<std::shared_ptr<hilo_t>> query;
-	for (int i = 0; i < listLen; i++)
+	if (!rule_cache_->Lookup (list_key, &query))
 	{
-		Tcl_Obj* objPtr = nullptr;
-
-		Tcl_ListObjIndex (interp, objv[2], i, &objPtr);
-
-		int len = 0;
-		char* rule_text = Tcl_GetStringFromObj (objPtr, &len);
-		auto rule = std::make_shared<hilo_t> ();
-		assert ((bool)rule);
-		if (len > 0 && ParseRule (rule_text, *rule.get())) {
-			query.push_back (rule);
-			DLOG(INFO) << "#" << (1 + i) << " " << rule.get()->name;
-		} else {
-			Tcl_SetResult (interp, "bad symbol list", TCL_STATIC);
-			return TCL_ERROR;
+		for (int i = 0; i < listLen; i++)
+		{
+			Tcl_Obj* objPtr = nullptr;
+
+			Tcl_ListObjIndex (interp, objv[2], i, &objPtr);
+
+			int len = 0;
+			char* rule_text = Tcl_GetStringFromObj (objPtr, &len);
+			auto rule = std::make_shared<hilo_t> ();
+			assert ((bool)rule);
+			if (len > 0 && ParseRule (rule_text, *rule.get())) {
+				query.push_back (rule);
+				DLOG(INFO) << "#" << (1 + i) << " " << rule.get()->name;
+			} else {
+				Tcl_SetResult (interp, "bad symbol list", TCL_STATIC);
+				return TCL_ERROR;
+			}
 		}
+		rule_cache_->Insert (list_key, query);
+	}
+
+/* one cursor for every bar inclusive of specified end time, bars are reset
+ * before each interval as per hilo_t::Clear().
+ */
+	std::vector<std::vector<bar_t>> bars;
+	const scan_options_t options (tick_cache_.get(), false /* read */);
+	if (!hilo::sharded::get_hilo (engine_, shard_pool_.get(), shard_count_, chunk_symbols_, query, start_time32, end_time32, static_cast<int> (interval), false /* reset legs */, &bars, options)) {
+		Tcl_SetResult (interp, "scan failed", TCL_STATIC);
+		return TCL_ERROR;
 	}
+	const size_t bar_count = bars.empty() ? 0 : bars.front().size();
 
 /* create time period for bar and shift x-minutes for the specified range */
 	using namespace boost::posix_time;
 
 	time_period tp (ptime (kUnixEpoch, seconds (start_time32)), seconds (interval));
 
-	while (true) {
-		const __time32_t from = to_unix_epoch<__time32_t> (tp.begin());
+	for (size_t bar_index = 0; bar_index < bar_count; ++bar_index)
+	{
 		const __time32_t till = to_unix_epoch<__time32_t> (tp.end());
 
-/* inclusive of specified end time */
-		if (till > end_time32)
-			break;
-
-/* reset bars */
-		std::for_each (query.begin(), query.end(), [](const std::shared_ptr<hilo_t>& it) {
-			it->Clear();
-		});
-
-		single_iterator::get_hilo (query, from, till);
-		
 /* create flexrecord for each pair */
+		auto bar_it = bars.begin();
 		std::for_each (query.begin(), query.end(), [&](const std::shared_ptr<hilo_t>& it)
 		{
+			const bar_t& bar = (*bar_it++)[bar_index];
 			std::ostringstream symbol_name;
 			symbol_name << it->name << config_.suffix;
 
-			const double high_rounded = bnymellon::round (it->high);
-			const double low_rounded  = bnymellon::round (it->low);
+			const double high_rounded = bnymellon::round (bar.high);
+			const double low_rounded  = bnymellon::round (bar.low);
 
 			flexrecord_t fr (till, symbol_name.str().c_str(), kHiloFlexRecordName);
 			fr.stream() << high_rounded
@@ -442,12 +539,10 @@ hilo::stitch_t::TclFeedLogQuery (
 			if (!result || written != line.length()) {
 				LOG(WARNING) << "Writing file " << feedlog_file << " failed, error code=" << GetLastError();
 			}
-
-/* do not reset analytic result set so next query extends previous result set */
 		});
 
 		tp.shift (seconds (interval));
-	};
+	}
 
 	return TCL_OK;
 }
@@ -471,8 +566,14 @@ hilo::stitch_t::TclRepublishQuery (
 		return TCL_ERROR;
 	}
 
+/* republish every item as a refresh regardless of change. */
 	try {
-		SendRefresh();
+		if ((bool)provider_)
+			provider_->ExpireRefreshes();
+		if (!SendRefresh()) {
+			Tcl_SetResult (interp, "scan failed", TCL_STATIC);
+			return TCL_ERROR;
+		}
 	} catch (rfa::common::InvalidUsageException& e) {
 		LOG(ERROR) << "InvalidUsageException: { "
 			  "\"Severity\": \"" << internal::severity_string (e.getSeverity()) << "\""
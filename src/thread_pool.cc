@@ -0,0 +1,118 @@
+/* Fixed size worker pool for parallel cursor shards.
+ */
+
+#include "thread_pool.hh"
+
+#include "chromium/logging.hh"
+
+hilo::thread_pool_t::thread_pool_t (
+	size_t		thread_count
+	) :
+	thread_count_ (thread_count),
+	is_shutdown_ (false)
+{
+	CHECK (thread_count > 0);
+	for (size_t i = 0; i < thread_count; ++i)
+		threads_.create_thread ([this]() { Run(); });
+	VLOG(1) << "Thread pool started with #" << thread_count << " workers.";
+}
+
+hilo::thread_pool_t::~thread_pool_t()
+{
+	{
+		boost::lock_guard<boost::mutex> lock (lock_);
+		is_shutdown_ = true;
+	}
+	cond_.notify_all();
+	threads_.join_all();
+	VLOG(1) << "Thread pool stopped.";
+}
+
+void
+hilo::thread_pool_t::Post (
+	std::function<void()> task
+	)
+{
+	{
+		boost::lock_guard<boost::mutex> lock (lock_);
+		CHECK (!is_shutdown_);
+		tasks_.push_back (std::move (task));
+	}
+	cond_.notify_one();
+}
+
+/* Worker loop, drains remaining tasks before shutdown.
+ */
+void
+hilo::thread_pool_t::Run()
+{
+	while (true) {
+		std::function<void()> task;
+		{
+			boost::unique_lock<boost::mutex> lock (lock_);
+			while (tasks_.empty() && !is_shutdown_)
+				cond_.wait (lock);
+			if (tasks_.empty())
+				return;
+			task = std::move (tasks_.front());
+			tasks_.pop_front();
+		}
+		try {
+			task();
+		} catch (const std::exception& e) {
+			LOG(ERROR) << "Worker task raised exception " << e.what();
+		}
+	}
+}
+
+hilo::task_group_t::task_group_t (
+	thread_pool_t*	pool
+	) :
+	pool_ (pool),
+	pending_ (0)
+{
+	CHECK (nullptr != pool);
+}
+
+hilo::task_group_t::~task_group_t()
+{
+/* tasks reference caller state, never return with work outstanding. */
+	Wait();
+}
+
+void
+hilo::task_group_t::Post (
+	std::function<void()> task
+	)
+{
+	{
+		boost::lock_guard<boost::mutex> lock (lock_);
+		++pending_;
+	}
+	pool_->Post ([this, task]() {
+		try {
+			task();
+		} catch (const std::exception& e) {
+			LOG(ERROR) << "Worker task raised exception " << e.what();
+		}
+		OnComplete();
+	});
+}
+
+void
+hilo::task_group_t::Wait()
+{
+	boost::unique_lock<boost::mutex> lock (lock_);
+	while (pending_ > 0)
+		cond_.wait (lock);
+}
+
+void
+hilo::task_group_t::OnComplete()
+{
+	boost::lock_guard<boost::mutex> lock (lock_);
+	if (0 == --pending_)
+		cond_.notify_all();
+}
+
+/* eof */
@@ -0,0 +1,67 @@
+/* Fixed size worker pool for parallel cursor shards.
+ */
+
+#ifndef __THREAD_POOL_HH__
+#define __THREAD_POOL_HH__
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+
+/* Boost noncopyable base class. */
+#include <boost/utility.hpp>
+
+/* Boost threading. */
+#include <boost/thread.hpp>
+
+namespace hilo
+{
+	class thread_pool_t : boost::noncopyable
+	{
+	public:
+		explicit thread_pool_t (size_t thread_count);
+		~thread_pool_t();
+
+/* Queue task for the next idle worker. */
+		void Post (std::function<void()> task);
+
+		size_t size() const {
+			return thread_count_;
+		}
+
+	private:
+		void Run();
+
+		size_t thread_count_;
+		boost::mutex lock_;
+		boost::condition_variable cond_;
+		std::deque<std::function<void()>> tasks_;
+		bool is_shutdown_;
+		boost::thread_group threads_;
+	};
+
+/* Set of tasks posted to a pool, Wait() returns when all have completed. */
+	class task_group_t : boost::noncopyable
+	{
+	public:
+		explicit task_group_t (thread_pool_t* pool);
+		~task_group_t();
+
+		void Post (std::function<void()> task);
+		void Wait();
+
+	private:
+		void OnComplete();
+
+		thread_pool_t* pool_;
+		boost::mutex lock_;
+		boost::condition_variable cond_;
+		size_t pending_;
+	};
+
+} /* namespace hilo */
+
+#endif /* __THREAD_POOL_HH__ */
+
+/* eof */
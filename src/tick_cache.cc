@@ -0,0 +1,443 @@
+/* Intraday tick cache recorded by the periodic scan.
+ */
+
+#include "tick_cache.hh"
+
+#include <algorithm>
+
+#include "chromium/logging.hh"
+
+/* Initial ring size in ticks, doubled while under the memory cap. */
+static const size_t kMinimumTickCapacity = 64;
+
+hilo::tick_cache_t::symbol_t::symbol_t (
+	const std::string& name_,
+	unsigned	stream_
+	) :
+	name (name_),
+	stream (stream_),
+	valid_from (0),
+	till (0)
+{
+}
+
+/* Drop every tick keeping capacity, held from from onwards. */
+void
+hilo::tick_cache_t::symbol_t::Clear (
+	__time32_t	from
+	)
+{
+	sequences.clear();
+	timestamps.clear();
+	values.clear();
+	valid_from = till = from;
+}
+
+size_t
+hilo::tick_cache_t::symbol_t::LowerBound (
+	__time32_t	timestamp
+	) const
+{
+	return std::lower_bound (timestamps.begin(), timestamps.end(), timestamp) - timestamps.begin();
+}
+
+hilo::tick_cache_t::tick_cache_t (
+	size_t		capacity_bytes
+	) :
+	capacity_bytes_ (capacity_bytes),
+	size_bytes_ (0),
+	sequence_ (0),
+	hit_count_ (0),
+	partial_count_ (0),
+	miss_count_ (0)
+{
+}
+
+void
+hilo::tick_cache_t::Reset()
+{
+	boost::unique_lock<boost::shared_mutex> lock (lock_);
+	symbols_.clear();
+	field_names_.clear();
+	field_map_.clear();
+	size_bytes_ = 0;
+	DVLOG(1) << "Tick cache reset.";
+}
+
+size_t
+hilo::tick_cache_t::GetTickBytes() const
+{
+	return sizeof (uint64_t) + sizeof (__time32_t) + (field_names_.size() * sizeof (double));
+}
+
+/* Append one tick, growing the ring while under the memory cap otherwise
+ * overwriting the oldest tick.
+ */
+void
+hilo::tick_cache_t::Push (
+	symbol_t*const	symbol,
+	__time32_t	timestamp,
+	const double*	values
+	)
+{
+	const size_t field_count = field_names_.size();
+	if (symbol->timestamps.full()) {
+		const size_t capacity = symbol->timestamps.capacity();
+		const size_t new_capacity = std::max (kMinimumTickCapacity, 2 * capacity);
+		const size_t grow_bytes = (new_capacity - capacity) * GetTickBytes();
+		if ((size_bytes_ + grow_bytes) <= capacity_bytes_) {
+			symbol->sequences.set_capacity (new_capacity);
+			symbol->timestamps.set_capacity (new_capacity);
+			symbol->values.set_capacity (new_capacity * field_count);
+			size_bytes_ += grow_bytes;
+		} else if (0 == capacity) {
+/* no room at all, nothing held up to and including this second */
+			symbol->valid_from = timestamp + 1;
+			return;
+		} else {
+			symbol->valid_from = symbol->timestamps.front() + 1;
+		}
+	}
+	symbol->sequences.push_back (++sequence_);
+	symbol->timestamps.push_back (timestamp);
+	for (size_t i = 0; i < field_count; ++i)
+		symbol->values.push_back (values[i]);
+}
+
+bool
+hilo::tick_cache_t::Covers (
+	const symbol_t& symbol,
+	__time32_t	from,
+	__time32_t	till
+	) const
+{
+	return symbol.valid_from <= from && till <= symbol.till;
+}
+
+void
+hilo::tick_cache_t::CountLookup (
+	bool		is_hit,
+	bool		is_partial
+	) const
+{
+	boost::lock_guard<boost::mutex> lock (stats_lock_);
+	if (is_hit)
+		++hit_count_;
+	else if (is_partial)
+		++partial_count_;
+	else
+		++miss_count_;
+}
+
+bool
+hilo::tick_cache_t::GetCoverage (
+	const std::vector<std::shared_ptr<hilo_t>>& query,
+	__time32_t	from,
+	__time32_t	till,
+	__time32_t*	covered_from,
+	__time32_t*	covered_till
+	) const
+{
+	boost::shared_lock<boost::shared_mutex> lock (lock_);
+	__time32_t held_from = from, held_till = till;
+	bool is_held = !field_names_.empty() && !query.empty();
+	auto HoldsLeg = [&](const leg_t& leg) -> const symbol_t* {
+		auto it = symbols_.find (leg.symbol_name);
+		if (symbols_.end() == it ||
+		    field_map_.end() == field_map_.find (leg.bid_field) ||
+		    field_map_.end() == field_map_.find (leg.ask_field))
+		{
+			return nullptr;
+		}
+		const symbol_t* symbol = it->second.get();
+		held_from = std::max (held_from, symbol->valid_from);
+		held_till = std::min (held_till, symbol->till);
+		return symbol;
+	};
+	for (auto it = query.begin(); is_held && it != query.end(); ++it) {
+		const hilo_t& rule = *it->get();
+		const symbol_t* first = HoldsLeg (rule.legs.first);
+		if (nullptr == first) {
+			is_held = false;
+			break;
+		}
+		if (!rule.is_synthetic)
+			continue;
+/* legs must share one stream to replay in cursor order */
+		const symbol_t* second = HoldsLeg (rule.legs.second);
+		if (nullptr == second || first->stream != second->stream)
+			is_held = false;
+	}
+	lock.unlock();
+
+	is_held = is_held && held_from < held_till;
+	CountLookup (is_held && held_from == from && held_till == till, is_held);
+	if (!is_held)
+		return false;
+	*covered_from = held_from;
+	*covered_till = held_till;
+	return true;
+}
+
+uint64_t
+hilo::tick_cache_t::GetHitCount() const
+{
+	boost::lock_guard<boost::mutex> lock (stats_lock_);
+	return hit_count_;
+}
+
+uint64_t
+hilo::tick_cache_t::GetPartialCount() const
+{
+	boost::lock_guard<boost::mutex> lock (stats_lock_);
+	return partial_count_;
+}
+
+uint64_t
+hilo::tick_cache_t::GetMissCount() const
+{
+	boost::lock_guard<boost::mutex> lock (stats_lock_);
+	return miss_count_;
+}
+
+size_t
+hilo::tick_cache_t::GetSizeBytes() const
+{
+	boost::shared_lock<boost::shared_mutex> lock (lock_);
+	return size_bytes_;
+}
+
+hilo::tick_cache_t::reader_t::reader_t (
+	const tick_cache_t& cache
+	) :
+	cache_ (cache),
+	fields_ (nullptr),
+	current_ (SIZE_MAX)
+{
+}
+
+hilo::tick_cache_t::reader_t::~reader_t()
+{
+	Close();
+}
+
+/* lhs ticks after rhs, std heap functions build a max-heap. */
+bool
+hilo::tick_cache_t::reader_t::IsAfter (
+	size_t		lhs,
+	size_t		rhs
+	) const
+{
+	const range_t& a = ranges_[lhs];
+	const range_t& b = ranges_[rhs];
+	const __time32_t a_time = a.symbol->timestamps[a.position];
+	const __time32_t b_time = b.symbol->timestamps[b.position];
+	if (a_time != b_time)
+		return a_time > b_time;
+	return a.symbol->sequences[a.position] > b.symbol->sequences[b.position];
+}
+
+/* Cache is read locked until Close().
+ */
+bool
+hilo::tick_cache_t::reader_t::Open (
+	std::set<std::string>& symbol_set,
+	const std::unordered_map<std::string, size_t>& field_map,
+	std::vector<double>*const fields,
+	__time32_t	from,
+	__time32_t	till
+	)
+{
+	Close();
+	lock_.reset (new boost::shared_lock<boost::shared_mutex> (cache_.lock_));
+	for (auto it = field_map.begin(); it != field_map.end(); ++it) {
+		auto field_it = cache_.field_map_.find (it->first);
+		if (cache_.field_map_.end() == field_it) {
+			Close();
+			return false;
+		}
+		field_map_.push_back (std::make_pair (field_it->second, it->second));
+	}
+	for (auto it = symbol_set.begin(); it != symbol_set.end(); ++it) {
+		auto symbol_it = cache_.symbols_.find (*it);
+		if (cache_.symbols_.end() == symbol_it || !cache_.Covers (*symbol_it->second.get(), from, till)) {
+			Close();
+			return false;
+		}
+		range_t range;
+		range.symbol   = symbol_it->second.get();
+		range.position = range.symbol->LowerBound (from);
+		range.end      = range.symbol->LowerBound (till);
+		if (range.position == range.end)
+			continue;
+		heap_.push_back (ranges_.size());
+		ranges_.push_back (range);
+	}
+	fields_ = fields;
+	std::make_heap (heap_.begin(), heap_.end(), [this](size_t lhs, size_t rhs) { return IsAfter (lhs, rhs); });
+	return true;
+}
+
+bool
+hilo::tick_cache_t::reader_t::Next()
+{
+	auto Compare = [this](size_t lhs, size_t rhs) { return IsAfter (lhs, rhs); };
+	if (SIZE_MAX != current_) {
+		if (++ranges_[current_].position < ranges_[current_].end) {
+			heap_.push_back (current_);
+			std::push_heap (heap_.begin(), heap_.end(), Compare);
+		}
+		current_ = SIZE_MAX;
+	}
+	if (heap_.empty())
+		return false;
+	std::pop_heap (heap_.begin(), heap_.end(), Compare);
+	current_ = heap_.back();
+	heap_.pop_back();
+
+	const range_t& range = ranges_[current_];
+	const size_t offset = range.position * cache_.field_names_.size();
+	std::for_each (field_map_.begin(), field_map_.end(), [&](const std::pair<size_t, size_t>& field) {
+		(*fields_)[field.second] = range.symbol->values[offset + field.first];
+	});
+	return true;
+}
+
+const char*
+hilo::tick_cache_t::reader_t::GetCurrentSymbolName() const
+{
+	return ranges_[current_].symbol->name.c_str();
+}
+
+__time32_t
+hilo::tick_cache_t::reader_t::GetCurrentTime32() const
+{
+	const range_t& range = ranges_[current_];
+	return range.symbol->timestamps[range.position];
+}
+
+void
+hilo::tick_cache_t::reader_t::Close()
+{
+	ranges_.clear();
+	heap_.clear();
+	field_map_.clear();
+	current_ = SIZE_MAX;
+	lock_.reset();
+}
+
+hilo::tick_cache_t::writer_t::writer_t (
+	tick_cache_t*	cache,
+	unsigned	stream
+	) :
+	cache_ (cache),
+	stream_ (stream),
+	from_ (0),
+	till_ (0),
+	fields_ (nullptr)
+{
+	CHECK (nullptr != cache);
+}
+
+void
+hilo::tick_cache_t::writer_t::Open (
+	const std::set<std::string>& symbol_set,
+	const std::unordered_map<std::string, size_t>& field_map,
+	const std::vector<double>* fields,
+	__time32_t	from,
+	__time32_t	till
+	)
+{
+	from_ = from; till_ = till;
+	symbol_names_.assign (symbol_set.begin(), symbol_set.end());
+	symbol_map_.clear();
+	for (size_t i = 0; i < symbol_names_.size(); ++i)
+		symbol_map_.emplace (std::make_pair (symbol_names_[i], i));
+	field_names_.clear();
+	field_indices_.clear();
+	std::for_each (field_map.begin(), field_map.end(), [this](const std::pair<const std::string, size_t>& field) {
+		field_names_.push_back (field.first);
+		field_indices_.push_back (field.second);
+	});
+	fields_ = fields;
+	tick_symbols_.clear();
+	tick_times_.clear();
+	tick_values_.clear();
+}
+
+void
+hilo::tick_cache_t::writer_t::Append (
+	const char*	symbol_name,
+	__time32_t	timestamp
+	)
+{
+	auto it = symbol_map_.find (symbol_name);
+	if (symbol_map_.end() == it)
+		return;
+	tick_symbols_.push_back (it->second);
+	tick_times_.push_back (timestamp);
+	std::for_each (field_indices_.begin(), field_indices_.end(), [this](size_t field_idx) {
+		tick_values_.push_back ((*fields_)[field_idx]);
+	});
+}
+
+/* Append a completed scan, symbols not held up to the start of the scan
+ * restart from it.
+ */
+void
+hilo::tick_cache_t::writer_t::Commit()
+{
+	boost::unique_lock<boost::shared_mutex> lock (cache_->lock_);
+
+/* the first scan of a session fixes the cached fields */
+	if (cache_->field_names_.empty()) {
+		cache_->field_names_ = field_names_;
+		for (size_t i = 0; i < field_names_.size(); ++i)
+			cache_->field_map_.emplace (std::make_pair (field_names_[i], i));
+	}
+	const size_t field_count = cache_->field_names_.size();
+	if (field_names_.size() != field_count) {
+		LOG(WARNING) << "Tick cache fields do not match scan, discarding #" << tick_times_.size() << " ticks.";
+		return;
+	}
+/* scan field order to cache field order */
+	std::vector<size_t> cache_field (field_count);
+	for (size_t i = 0; i < field_count; ++i) {
+		auto it = cache_->field_map_.find (field_names_[i]);
+		if (cache_->field_map_.end() == it) {
+			LOG(WARNING) << "Tick cache fields do not match scan, discarding #" << tick_times_.size() << " ticks.";
+			return;
+		}
+		cache_field[i] = it->second;
+	}
+
+	std::vector<symbol_t*> symbols (symbol_names_.size());
+	for (size_t i = 0; i < symbol_names_.size(); ++i) {
+		auto it = cache_->symbols_.find (symbol_names_[i]);
+		if (cache_->symbols_.end() == it) {
+			std::shared_ptr<symbol_t> symbol (new symbol_t (symbol_names_[i], stream_));
+			symbol->Clear (from_);
+			it = cache_->symbols_.emplace (std::make_pair (symbol_names_[i], symbol)).first;
+		}
+		symbol_t*const symbol = it->second.get();
+		if (symbol->stream != stream_ || symbol->till != from_) {
+			symbol->stream = stream_;
+			symbol->Clear (from_);
+		}
+		symbols[i] = symbol;
+	}
+
+	std::vector<double> values (field_count);
+	for (size_t i = 0; i < tick_times_.size(); ++i) {
+		const double* tick_values = &tick_values_[i * field_count];
+		for (size_t j = 0; j < field_count; ++j)
+			values[cache_field[j]] = tick_values[j];
+		cache_->Push (symbols[tick_symbols_[i]], tick_times_[i], &values[0]);
+	}
+	std::for_each (symbols.begin(), symbols.end(), [this](symbol_t*const symbol) {
+		symbol->till = till_;
+	});
+	DVLOG(1) << "Tick cache appended #" << tick_times_.size() << " ticks, " << cache_->size_bytes_ << " bytes.";
+}
+
+/* eof */
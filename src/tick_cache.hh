@@ -0,0 +1,157 @@
+/* Intraday tick cache recorded by the periodic scan.
+ *
+ * One ring buffer per symbol of every cursor record since the last reset,
+ * timestamp and the value of each bound field.  Windows held for every symbol
+ * of a query are replayed from memory in the original cursor order, anything
+ * else is read through FlexRecReader.
+ *
+ * Symbol rings grow until the memory cap is reached, then evict their oldest
+ * ticks and the symbol is only held from the second after the last eviction.
+ */
+
+#ifndef __TICK_CACHE_HH__
+#define __TICK_CACHE_HH__
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* Boost circular buffer. */
+#include <boost/circular_buffer.hpp>
+
+/* Boost noncopyable base class. */
+#include <boost/utility.hpp>
+
+/* Boost threading. */
+#include <boost/thread.hpp>
+
+#include "get_hilo.hh"
+
+namespace hilo
+{
+	class tick_cache_t : boost::noncopyable
+	{
+		class symbol_t;
+	public:
+		explicit tick_cache_t (size_t capacity_bytes);
+
+/* Discard all ticks, a new session. */
+		void Reset();
+
+/* Largest window [*covered_from, *covered_till) within [from, till) held for
+ * every symbol and field of the query, false if none.  Counts a hit when the
+ * whole window is held, a partial hit or a miss otherwise.
+ */
+		bool GetCoverage (const std::vector<std::shared_ptr<hilo_t>>& query, __time32_t from, __time32_t till, __time32_t* covered_from, __time32_t* covered_till) const;
+
+		uint64_t GetHitCount() const;
+		uint64_t GetPartialCount() const;
+		uint64_t GetMissCount() const;
+		size_t GetSizeBytes() const;
+
+/* Cursor over cached ticks with the FlexRecReader binding interface. */
+		class reader_t : boost::noncopyable
+		{
+		public:
+			explicit reader_t (const tick_cache_t& cache);
+			~reader_t();
+
+/* Fails unless the whole window is held for every symbol and field. */
+			bool Open (std::set<std::string>& symbol_set, const std::unordered_map<std::string, size_t>& field_map, std::vector<double>*const fields, __time32_t from, __time32_t till);
+			bool Next();
+			const char* GetCurrentSymbolName() const;
+			__time32_t GetCurrentTime32() const;
+			void Close();
+
+		private:
+			struct range_t {
+				const symbol_t* symbol;
+				size_t position, end;
+			};
+			bool IsAfter (size_t lhs, size_t rhs) const;
+
+			const tick_cache_t& cache_;
+			std::unique_ptr<boost::shared_lock<boost::shared_mutex>> lock_;
+			std::vector<range_t> ranges_;
+/* min-heap of ranges_ by timestamp then sequence. */
+			std::vector<size_t> heap_;
+/* pairs of cache field index and bound field index. */
+			std::vector<std::pair<size_t, size_t>> field_map_;
+			std::vector<double>* fields_;
+			size_t current_;
+		};
+
+/* Collects the records of one cursor scan and appends them to the cache when
+ * the scan completes.  Symbols of one stream are ordered with each other,
+ * synthetic rules are only replayed when both legs share a stream.
+ */
+		class writer_t : boost::noncopyable
+		{
+		public:
+			writer_t (tick_cache_t* cache, unsigned stream);
+
+			void Open (const std::set<std::string>& symbol_set, const std::unordered_map<std::string, size_t>& field_map, const std::vector<double>* fields, __time32_t from, __time32_t till);
+			void Append (const char* symbol_name, __time32_t timestamp);
+			void Commit();
+
+		private:
+			tick_cache_t* cache_;
+			unsigned stream_;
+			__time32_t from_, till_;
+			std::vector<std::string> symbol_names_;
+			std::unordered_map<std::string, size_t> symbol_map_;
+			std::vector<std::string> field_names_;
+			std::vector<size_t> field_indices_;
+			const std::vector<double>* fields_;
+			std::vector<size_t> tick_symbols_;
+			std::vector<__time32_t> tick_times_;
+			std::vector<double> tick_values_;
+		};
+
+	private:
+		class symbol_t
+		{
+		public:
+			symbol_t (const std::string& name_, unsigned stream_);
+
+			void Clear (__time32_t from);
+/* first tick at or after timestamp. */
+			size_t LowerBound (__time32_t timestamp) const;
+
+			std::string name;
+			unsigned stream;
+/* held window [valid_from, till). */
+			__time32_t valid_from, till;
+			boost::circular_buffer<uint64_t> sequences;
+			boost::circular_buffer<__time32_t> timestamps;
+/* field_count values per tick. */
+			boost::circular_buffer<double> values;
+		};
+
+		size_t GetTickBytes() const;
+		void Push (symbol_t*const symbol, __time32_t timestamp, const double* values);
+		bool Covers (const symbol_t& symbol, __time32_t from, __time32_t till) const;
+		void CountLookup (bool is_hit, bool is_partial) const;
+
+		mutable boost::shared_mutex lock_;
+		size_t capacity_bytes_;
+		size_t size_bytes_;
+		uint64_t sequence_;
+/* fields of every tick, set by the first scan of a session. */
+		std::vector<std::string> field_names_;
+		std::unordered_map<std::string, size_t> field_map_;
+		std::unordered_map<std::string, std::shared_ptr<symbol_t>> symbols_;
+
+		mutable boost::mutex stats_lock_;
+		mutable uint64_t hit_count_, partial_count_, miss_count_;
+	};
+
+} /* namespace hilo */
+
+#endif /* __TICK_CACHE_HH__ */
+
+/* eof */
@@ -0,0 +1,120 @@
+/* Push-based source of live quote ticks.
+ */
+
+#include "tick_feed.hh"
+
+#include <algorithm>
+#include <ctime>
+
+#include "chromium/logging.hh"
+#include "flexrec_source.hh"
+
+/* Widest window per cursor while catching up, seconds. */
+static const __time32_t kMaxReadSeconds = 15 * 60;
+
+hilo::flexrec_feed_t::flexrec_feed_t (
+	unsigned	poll_ms,
+	unsigned	settle_seconds
+	) :
+	poll_ms_ (poll_ms),
+	settle_seconds_ (settle_seconds),
+	position_ (0),
+	handler_ (nullptr)
+{
+}
+
+hilo::flexrec_feed_t::~flexrec_feed_t()
+{
+	Unsubscribe();
+}
+
+bool
+hilo::flexrec_feed_t::Subscribe (
+	const std::set<std::string>& symbol_set,
+	const std::unordered_map<std::string, size_t>& field_map,
+	__time32_t	from,
+	tick_handler_t*	handler
+	)
+{
+	CHECK (nullptr != handler);
+	Unsubscribe();
+	symbol_set_ = symbol_set;
+	field_map_  = field_map;
+	fields_.assign (field_map.size(), 0.0);
+	position_   = from;
+	handler_    = handler;
+	thread_.reset (new boost::thread ([this]() { Run(); }));
+	LOG(INFO) << "Tick feed subscribed #" << symbol_set_.size() << " symbols, poll " << poll_ms_ << "ms.";
+	return true;
+}
+
+void
+hilo::flexrec_feed_t::Unsubscribe()
+{
+	if (!(bool)thread_)
+		return;
+	thread_->interrupt();
+	thread_->join();
+	thread_.reset();
+	handler_ = nullptr;
+}
+
+void
+hilo::flexrec_feed_t::Run()
+{
+	try {
+		while (true) {
+			boost::this_thread::sleep (boost::posix_time::milliseconds (poll_ms_));
+/* completed seconds only, held back for late inserts */
+			const __time32_t till = _time32 (nullptr) - static_cast<__time32_t> (settle_seconds_);
+			while (position_ < till) {
+				const __time32_t next = std::min (till, position_ + kMaxReadSeconds);
+				if (!Read (position_, next))
+					break;
+				position_ = next;
+				handler_->OnWatermark (position_);
+				boost::this_thread::interruption_point();
+			}
+		}
+	} catch (const boost::thread_interrupted&) {
+		LOG(INFO) << "Tick feed thread interrupted.";
+	}
+}
+
+/* One forward cursor over [from, till), false to retry the window later.  The
+ * source opens a window without ticks as empty, so a failed open is a store
+ * failure and the watermark must not pass the window.  Ticks are held until
+ * the cursor completes so a retried window is never counted twice.
+ */
+bool
+hilo::flexrec_feed_t::Read (
+	__time32_t	from,
+	__time32_t	till
+	)
+{
+	symbol_names_.clear();
+	timestamps_.clear();
+	values_.clear();
+	flexrec_source_t source;
+	if (!source.Open (symbol_set_, field_map_, &fields_, from, till))
+		return false;
+	try {
+		while (source.Next()) {
+			symbol_names_.push_back (source.GetCurrentSymbolName());
+			timestamps_.push_back (source.GetCurrentTime32());
+			values_.insert (values_.end(), fields_.begin(), fields_.end());
+		}
+		source.Close();
+	} catch (std::exception& e) {
+		LOG(ERROR) << "FlexRecReader raised exception " << e.what();
+		return false;
+	}
+	const size_t field_count = fields_.size();
+	for (size_t i = 0; i < timestamps_.size(); ++i) {
+		std::copy (values_.begin() + (i * field_count), values_.begin() + ((i + 1) * field_count), fields_.begin());
+		handler_->OnTick (symbol_names_[i].c_str(), timestamps_[i], fields_);
+	}
+	return true;
+}
+
+/* eof */
@@ -0,0 +1,107 @@
+/* Push-based source of live quote ticks.
+ *
+ * Feeds deliver every tick of the subscribed symbols in timestamp order with
+ * the value of each bound field, then a watermark once every tick before it
+ * has been delivered.
+ */
+
+#ifndef __TICK_FEED_HH__
+#define __TICK_FEED_HH__
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* Boost noncopyable base class. */
+#include <boost/utility.hpp>
+
+/* Boost threading. */
+#include <boost/thread.hpp>
+
+#ifndef _MSC_VER
+/* Microsoft CRT 32-bit time for the stand-alone benchmarks. */
+typedef int32_t __time32_t;
+#endif
+
+namespace hilo
+{
+	class tick_handler_t
+	{
+	public:
+/* fields indexed per the subscribed field map. */
+		virtual void OnTick (const char* symbol_name, __time32_t timestamp, const std::vector<double>& fields) = 0;
+/* every tick before till has been delivered. */
+		virtual void OnWatermark (__time32_t till) = 0;
+	};
+
+	class tick_feed_t : boost::noncopyable
+	{
+	public:
+		virtual ~tick_feed_t() {}
+
+/* Deliver ticks from the from timestamp onwards to the handler. */
+		virtual bool Subscribe (const std::set<std::string>& symbol_set, const std::unordered_map<std::string, size_t>& field_map, __time32_t from, tick_handler_t* handler) = 0;
+		virtual void Unsubscribe() = 0;
+	};
+
+/* Tails the Velocity Analytics tick store on a worker thread, reading each
+ * completed second once.  Ticks are held back by a settling delay for late
+ * inserts, each window is delivered whole or not at all.
+ */
+	class flexrec_feed_t : public tick_feed_t
+	{
+	public:
+		flexrec_feed_t (unsigned poll_ms, unsigned settle_seconds);
+		virtual ~flexrec_feed_t();
+
+		virtual bool Subscribe (const std::set<std::string>& symbol_set, const std::unordered_map<std::string, size_t>& field_map, __time32_t from, tick_handler_t* handler) override;
+		virtual void Unsubscribe() override;
+
+	private:
+		void Run();
+		bool Read (__time32_t from, __time32_t till);
+
+		unsigned poll_ms_, settle_seconds_;
+		std::set<std::string> symbol_set_;
+		std::unordered_map<std::string, size_t> field_map_;
+		std::vector<double> fields_;
+/* ticks of the window being read, fields flattened per tick. */
+		std::vector<std::string> symbol_names_;
+		std::vector<__time32_t> timestamps_;
+		std::vector<double> values_;
+		__time32_t position_;
+		tick_handler_t* handler_;
+		std::unique_ptr<boost::thread> thread_;
+	};
+
+/* In-process stand-in, ticks pushed by the caller on the calling thread. */
+	class memory_feed_t : public tick_feed_t
+	{
+	public:
+		memory_feed_t();
+
+		virtual bool Subscribe (const std::set<std::string>& symbol_set, const std::unordered_map<std::string, size_t>& field_map, __time32_t from, tick_handler_t* handler) override;
+		virtual void Unsubscribe() override;
+
+/* Values by field name, unbound fields are ignored and missing fields zero. */
+		void Push (const char* symbol_name, __time32_t timestamp, const std::unordered_map<std::string, double>& values);
+		void Advance (__time32_t till);
+
+	private:
+		boost::mutex lock_;
+		std::set<std::string> symbol_set_;
+		std::unordered_map<std::string, size_t> field_map_;
+		std::vector<double> fields_;
+		__time32_t from_;
+		tick_handler_t* handler_;
+	};
+
+} /* namespace hilo */
+
+#endif /* __TICK_FEED_HH__ */
+
+/* eof */
@@ -0,0 +1,317 @@
+/* Memory-mapped columnar tick file.
+ */
+
+#include "tick_file.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include "chromium/logging.hh"
+
+static const char kTickFileMagic[8] = { 'H', 'I', 'L', 'O', 'T', 'I', 'C', 'K' };
+static const uint32_t kTickFileVersion = 1;
+
+static inline
+uint64_t
+Align8 (
+	uint64_t	offset
+	)
+{
+	return (offset + 7) & ~UINT64_C(7);
+}
+
+/* Reorder values so position i holds the value previously at order[i]. */
+template <class T>
+static
+void
+Permute (
+	const std::vector<size_t>& order,
+	std::vector<T>*	values
+	)
+{
+	std::vector<T> permuted;
+	permuted.reserve (values->size());
+	std::for_each (order.begin(), order.end(), [&](size_t position) { permuted.push_back ((*values)[position]); });
+	values->swap (permuted);
+}
+
+namespace {
+
+	class tick_file_cursor_t : public hilo::tick_source_t
+	{
+	public:
+		explicit tick_file_cursor_t (const hilo::tick_file_t& file) :
+			file_ (file),
+			fields_ (nullptr),
+			position_ (0),
+			end_ (0),
+			current_ (0)
+		{
+		}
+
+		virtual bool Open (std::set<std::string>& symbol_set, const std::unordered_map<std::string, size_t>& field_map, std::vector<double>*const fields, __time32_t from, __time32_t till) override {
+			CHECK (nullptr != fields);
+			if (!file_.is_open())
+				return false;
+			const std::vector<std::string>& symbol_names = file_.GetSymbolNames();
+			is_selected_.resize (symbol_names.size());
+			for (size_t i = 0; i < symbol_names.size(); ++i)
+				is_selected_[i] = 0 != symbol_set.count (symbol_names[i]);
+
+/* pairs of file column and bound field index */
+			const std::vector<std::string>& field_names = file_.GetFieldNames();
+			columns_.clear();
+			for (auto it = field_map.begin(); it != field_map.end(); ++it) {
+				auto name_it = std::find (field_names.begin(), field_names.end(), it->first);
+				if (field_names.end() == name_it) {
+					LOG(ERROR) << "Tick file has no field \"" << it->first << "\".";
+					return false;
+				}
+				columns_.push_back (std::make_pair (file_.GetColumn (name_it - field_names.begin()), it->second));
+			}
+
+			const int32_t* timestamps = file_.GetTimestamps();
+			const size_t tick_count = static_cast<size_t> (file_.GetHeader().tick_count);
+			position_ = std::lower_bound (timestamps, timestamps + tick_count, static_cast<int32_t> (from)) - timestamps;
+			end_      = std::lower_bound (timestamps, timestamps + tick_count, static_cast<int32_t> (till)) - timestamps;
+			fields_   = fields;
+			return true;
+		}
+
+		virtual bool Next() override {
+			const uint32_t* symbols = file_.GetSymbols();
+			while (position_ < end_) {
+				const size_t position = position_++;
+				if (!is_selected_[symbols[position]])
+					continue;
+				std::for_each (columns_.begin(), columns_.end(), [&](const std::pair<const double*, size_t>& column) {
+					(*fields_)[column.second] = column.first[position];
+				});
+				current_ = position;
+				return true;
+			}
+			return false;
+		}
+
+		virtual const char* GetCurrentSymbolName() override {
+			return file_.GetSymbolNames()[file_.GetSymbols()[current_]].c_str();
+		}
+
+		virtual __time32_t GetCurrentTime32() override {
+			return static_cast<__time32_t> (file_.GetTimestamps()[current_]);
+		}
+
+		virtual void Close() override {
+			fields_ = nullptr;
+		}
+
+	private:
+		const hilo::tick_file_t& file_;
+		std::vector<char> is_selected_;
+		std::vector<std::pair<const double*, size_t>> columns_;
+		std::vector<double>* fields_;
+		size_t position_, end_, current_;
+	};
+
+} /* anonymous namespace */
+
+hilo::tick_file_t::tick_file_t (
+	const std::string& path
+	) :
+	header_ (nullptr),
+	timestamps_ (nullptr),
+	symbols_ (nullptr),
+	values_ (nullptr)
+{
+	try {
+		if (!Map (path))
+			header_ = nullptr;
+	} catch (const boost::interprocess::interprocess_exception& e) {
+		LOG(ERROR) << "Cannot map tick file \"" << path << "\": " << e.what();
+		header_ = nullptr;
+	}
+}
+
+bool
+hilo::tick_file_t::Map (
+	const std::string& path
+	)
+{
+	using namespace boost::interprocess;
+	file_mapping file (path.c_str(), read_only);
+	mapped_region region (file, read_only);
+	const char* base = static_cast<const char*> (region.get_address());
+	const uint64_t size = region.get_size();
+	if (size < sizeof (header_t)) {
+		LOG(ERROR) << "Tick file \"" << path << "\" truncated.";
+		return false;
+	}
+	const header_t* header = reinterpret_cast<const header_t*> (base);
+	if (0 != memcmp (header->magic, kTickFileMagic, sizeof (kTickFileMagic)) || kTickFileVersion != header->version) {
+		LOG(ERROR) << "Tick file \"" << path << "\" unknown format.";
+		return false;
+	}
+	if (0 != ((header->names_offset | header->timestamps_offset | header->symbols_offset | header->values_offset) & 7) ||
+	    header->names_offset < sizeof (header_t) ||
+	    header->names_offset > header->timestamps_offset)
+	{
+		LOG(ERROR) << "Tick file \"" << path << "\" malformed sections.";
+		return false;
+	}
+/* count elements of width from offset within the file, without overflow */
+	auto Fits = [size](uint64_t offset, uint64_t count, uint64_t width) -> bool {
+		return offset <= size && count <= (size - offset) / width;
+	};
+	const uint64_t tick_count = header->tick_count;
+	if (!Fits (header->timestamps_offset, tick_count, sizeof (int32_t)) ||
+	    !Fits (header->symbols_offset, tick_count, sizeof (uint32_t)) ||
+	    !Fits (header->values_offset, tick_count, sizeof (double)) ||
+	    (tick_count > 0 && !Fits (header->values_offset, header->field_count, tick_count * sizeof (double))))
+	{
+		LOG(ERROR) << "Tick file \"" << path << "\" truncated.";
+		return false;
+	}
+
+/* NUL terminated names up to the timestamps */
+	const char* name = base + header->names_offset;
+	const char* names_end = base + header->timestamps_offset;
+	std::vector<std::string> names;
+	while (names.size() < (header->symbol_count + header->field_count)) {
+		const char* nul = static_cast<const char*> (memchr (name, '\0', names_end - name));
+		if (nullptr == nul) {
+			LOG(ERROR) << "Tick file \"" << path << "\" truncated names.";
+			return false;
+		}
+		names.push_back (std::string (name, nul));
+		name = nul + 1;
+	}
+
+/* cursors seek by timestamp and index the symbol names by tick */
+	const int32_t* timestamps = reinterpret_cast<const int32_t*> (base + header->timestamps_offset);
+	const uint32_t* symbols = reinterpret_cast<const uint32_t*> (base + header->symbols_offset);
+	for (uint64_t i = 0; i < tick_count; ++i) {
+		if (symbols[i] >= header->symbol_count || (i > 0 && timestamps[i] < timestamps[i - 1])) {
+			LOG(ERROR) << "Tick file \"" << path << "\" malformed tick #" << i << ".";
+			return false;
+		}
+	}
+	symbol_names_.assign (names.begin(), names.begin() + header->symbol_count);
+	field_names_.assign (names.begin() + header->symbol_count, names.end());
+
+	file_.swap (file);
+	region_.swap (region);
+	header_     = reinterpret_cast<const header_t*> (region_.get_address());
+	timestamps_ = reinterpret_cast<const int32_t*> (static_cast<const char*> (region_.get_address()) + header_->timestamps_offset);
+	symbols_    = reinterpret_cast<const uint32_t*> (static_cast<const char*> (region_.get_address()) + header_->symbols_offset);
+	values_     = reinterpret_cast<const double*> (static_cast<const char*> (region_.get_address()) + header_->values_offset);
+	LOG(INFO) << "Mapped tick file \"" << path << "\" #" << tick_count << " ticks, #" << symbol_names_.size() << " symbols, #" << field_names_.size() << " fields.";
+	return true;
+}
+
+std::unique_ptr<hilo::tick_source_t>
+hilo::tick_file_t::Create() const
+{
+	return std::unique_ptr<tick_source_t> (new tick_file_cursor_t (*this));
+}
+
+bool
+hilo::tick_file_t::Write (
+	const std::string& path,
+	tick_source_t*	source,
+	std::set<std::string>& symbol_set,
+	const std::vector<std::string>& field_names,
+	__time32_t	from,
+	__time32_t	till
+	)
+{
+	CHECK (nullptr != source);
+	std::unordered_map<std::string, size_t> field_map;
+	for (size_t i = 0; i < field_names.size(); ++i)
+		field_map.emplace (std::make_pair (field_names[i], i));
+	CHECK (field_map.size() == field_names.size());
+	std::vector<double> fields (field_names.size());
+
+/* symbols in first appearance order */
+	std::vector<std::string> symbol_names;
+	std::unordered_map<std::string, uint32_t> symbol_map;
+	std::vector<int32_t> timestamps;
+	std::vector<uint32_t> symbols;
+	std::vector<std::vector<double>> columns (field_names.size());
+	if (!source->Open (symbol_set, field_map, &fields, from, till)) {
+		LOG(ERROR) << "Cannot open source of tick file \"" << path << "\".";
+		return false;
+	}
+	while (source->Next()) {
+		const std::string symbol_name (source->GetCurrentSymbolName());
+		auto it = symbol_map.find (symbol_name);
+		if (symbol_map.end() == it) {
+			it = symbol_map.emplace (std::make_pair (symbol_name, static_cast<uint32_t> (symbol_names.size()))).first;
+			symbol_names.push_back (symbol_name);
+		}
+		timestamps.push_back (static_cast<int32_t> (source->GetCurrentTime32()));
+		symbols.push_back (it->second);
+		for (size_t i = 0; i < fields.size(); ++i)
+			columns[i].push_back (fields[i]);
+	}
+	source->Close();
+
+/* cursors seek by timestamp, stable sort a source delivering out of order */
+	if (!std::is_sorted (timestamps.begin(), timestamps.end())) {
+		LOG(WARNING) << "Source of tick file \"" << path << "\" out of timestamp order.";
+		std::vector<size_t> order (timestamps.size());
+		for (size_t i = 0; i < order.size(); ++i)
+			order[i] = i;
+		std::stable_sort (order.begin(), order.end(), [&timestamps](size_t lhs, size_t rhs) {
+			return timestamps[lhs] < timestamps[rhs];
+		});
+		Permute (order, &timestamps);
+		Permute (order, &symbols);
+		std::for_each (columns.begin(), columns.end(), [&order](std::vector<double>& column) { Permute (order, &column); });
+	}
+
+	header_t header;
+	memset (&header, 0, sizeof (header));
+	memcpy (header.magic, kTickFileMagic, sizeof (kTickFileMagic));
+	header.version      = kTickFileVersion;
+	header.symbol_count = static_cast<uint32_t> (symbol_names.size());
+	header.field_count  = static_cast<uint32_t> (field_names.size());
+	header.tick_count   = timestamps.size();
+	std::string names;
+	std::for_each (symbol_names.begin(), symbol_names.end(), [&names](const std::string& name) { names.append (name); names.push_back ('\0'); });
+	std::for_each (field_names.begin(), field_names.end(), [&names](const std::string& name) { names.append (name); names.push_back ('\0'); });
+	header.names_offset      = Align8 (sizeof (header));
+	header.timestamps_offset = Align8 (header.names_offset + names.size());
+	header.symbols_offset    = Align8 (header.timestamps_offset + (timestamps.size() * sizeof (int32_t)));
+	header.values_offset     = Align8 (header.symbols_offset + (symbols.size() * sizeof (uint32_t)));
+
+	std::ofstream out (path.c_str(), std::ios::binary | std::ios::trunc);
+	if (!out) {
+		LOG(ERROR) << "Cannot create tick file \"" << path << "\".";
+		return false;
+	}
+	auto Pad = [&out](uint64_t offset) {
+		static const char kZero[8] = {};
+		out.write (kZero, static_cast<std::streamsize> (offset - static_cast<uint64_t> (out.tellp())));
+	};
+	out.write (reinterpret_cast<const char*> (&header), sizeof (header));
+	Pad (header.names_offset);
+	out.write (names.data(), names.size());
+	Pad (header.timestamps_offset);
+	if (!timestamps.empty()) out.write (reinterpret_cast<const char*> (timestamps.data()), timestamps.size() * sizeof (int32_t));
+	Pad (header.symbols_offset);
+	if (!symbols.empty()) out.write (reinterpret_cast<const char*> (symbols.data()), symbols.size() * sizeof (uint32_t));
+	Pad (header.values_offset);
+	std::for_each (columns.begin(), columns.end(), [&out](const std::vector<double>& column) {
+		if (!column.empty()) out.write (reinterpret_cast<const char*> (column.data()), column.size() * sizeof (double));
+	});
+	out.close();
+	if (!out) {
+		LOG(ERROR) << "Failed writing tick file \"" << path << "\".";
+		return false;
+	}
+	LOG(INFO) << "Wrote tick file \"" << path << "\" #" << timestamps.size() << " ticks.";
+	return true;
+}
+
+/* eof */
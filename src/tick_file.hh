@@ -0,0 +1,100 @@
+/* Memory-mapped columnar tick file.
+ *
+ * Layout, little-endian with every section 8-byte aligned:
+ *
+ *   header_t
+ *   symbol names then field names, each NUL terminated
+ *   int32_t  timestamps[tick_count]     non-decreasing
+ *   uint32_t symbols[tick_count]        index into the symbol names
+ *   double   values[field_count][tick_count], one column per field
+ *
+ * Files are written from any tick source, e.g. a production day through
+ * FlexRecReader, and replayed by any number of concurrent cursors.
+ */
+
+#ifndef __TICK_FILE_HH__
+#define __TICK_FILE_HH__
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* Boost memory mapped files. */
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "tick_source.hh"
+
+namespace hilo
+{
+	class tick_file_t : public tick_source_factory_t
+	{
+	public:
+		struct header_t {
+			char magic[8];
+			uint32_t version;
+			uint32_t symbol_count;
+			uint32_t field_count;
+			uint32_t reserved;
+			uint64_t tick_count;
+			uint64_t names_offset;
+			uint64_t timestamps_offset;
+			uint64_t symbols_offset;
+			uint64_t values_offset;
+		};
+
+		explicit tick_file_t (const std::string& path);
+
+/* False if the file is missing or malformed, cursors then never open. */
+		bool is_open() const {
+			return nullptr != header_;
+		}
+
+		virtual std::unique_ptr<tick_source_t> Create() const override;
+
+/* Read [from, till) of the symbol set from source into a new file at path,
+ * ticks out of timestamp order are stable sorted.  False if the source cannot
+ * open or the file cannot be written.
+ */
+		static bool Write (const std::string& path, tick_source_t* source, std::set<std::string>& symbol_set, const std::vector<std::string>& field_names, __time32_t from, __time32_t till);
+
+		const header_t& GetHeader() const {
+			return *header_;
+		}
+		const std::vector<std::string>& GetSymbolNames() const {
+			return symbol_names_;
+		}
+		const std::vector<std::string>& GetFieldNames() const {
+			return field_names_;
+		}
+		const int32_t* GetTimestamps() const {
+			return timestamps_;
+		}
+		const uint32_t* GetSymbols() const {
+			return symbols_;
+		}
+		const double* GetColumn (size_t field) const {
+			return values_ + (field * header_->tick_count);
+		}
+
+	private:
+		bool Map (const std::string& path);
+
+		boost::interprocess::file_mapping file_;
+		boost::interprocess::mapped_region region_;
+		const header_t* header_;
+		std::vector<std::string> symbol_names_, field_names_;
+		const int32_t* timestamps_;
+		const uint32_t* symbols_;
+		const double* values_;
+	};
+
+} /* namespace hilo */
+
+#endif /* __TICK_FILE_HH__ */
+
+/* eof */
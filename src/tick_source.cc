@@ -0,0 +1,165 @@
+/* Forward cursor over quote ticks independent of the tick store.
+ */
+
+#include "tick_source.hh"
+
+#include <algorithm>
+#include <cmath>
+
+#include "chromium/logging.hh"
+
+/* Period of the synthetic quote cycle, one day in seconds. */
+static const double kSyntheticPeriod = 24.0 * 60.0 * 60.0;
+
+/* Set once before the first scan. */
+static const hilo::tick_source_factory_t* g_default_factory = nullptr;
+
+/* http://xorshift.di.unimi.it/splitmix64.c */
+static inline
+uint64_t
+Mix (
+	uint64_t	x
+	)
+{
+	x += UINT64_C(0x9e3779b97f4a7c15);
+	x = (x ^ (x >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+	x = (x ^ (x >> 27)) * UINT64_C(0x94d049bb133111eb);
+	return x ^ (x >> 31);
+}
+
+/* Uniform in [0, 1). */
+static inline
+double
+Unit (
+	uint64_t	x
+	)
+{
+	return static_cast<double> (x >> 11) / 9007199254740992.0;
+}
+
+namespace {
+
+	class synthetic_source_t : public hilo::tick_source_t
+	{
+	public:
+		synthetic_source_t (uint64_t seed, unsigned ticks_per_second, const std::vector<std::string>& universe) :
+			seed_ (seed),
+			ticks_per_second_ (ticks_per_second),
+			universe_ (universe),
+			fields_ (nullptr),
+			timestamp_ (0),
+			till_ (0),
+			current_time_ (0),
+			draw_ (0),
+			current_ (0)
+		{
+		}
+
+		virtual bool Open (std::set<std::string>& symbol_set, const std::unordered_map<std::string, size_t>& field_map, std::vector<double>*const fields, __time32_t from, __time32_t till) override {
+			CHECK (nullptr != fields);
+			if (universe_.empty())
+				universe_.assign (symbol_set.begin(), symbol_set.end());
+			is_selected_.resize (universe_.size());
+			bool is_any = false;
+			for (size_t i = 0; i < universe_.size(); ++i) {
+				is_selected_[i] = 0 != symbol_set.count (universe_[i]);
+				is_any |= (0 != is_selected_[i]);
+			}
+			bids_.clear(); asks_.clear();
+			std::for_each (field_map.begin(), field_map.end(), [this](const std::pair<const std::string, size_t>& field_pair) {
+				if (std::string::npos != field_pair.first.find ("Ask"))
+					asks_.push_back (field_pair.second);
+				else
+					bids_.push_back (field_pair.second);
+			});
+			fields_    = fields;
+			timestamp_ = from;
+/* a window without ticks opens with no records */
+			till_      = (is_any && 0 != ticks_per_second_) ? till : from;
+			draw_      = 0;
+			return true;
+		}
+
+		virtual bool Next() override {
+			while (timestamp_ < till_) {
+				const uint64_t x = Mix (seed_ ^ Mix ((static_cast<uint64_t> (timestamp_) << 20) | draw_));
+				const __time32_t timestamp = timestamp_;
+				if (++draw_ == ticks_per_second_) {
+					draw_ = 0;
+					++timestamp_;
+				}
+				const size_t symbol = static_cast<size_t> (x % universe_.size());
+				if (!is_selected_[symbol])
+					continue;
+				const uint64_t h = Mix (seed_ + symbol);
+				const double base   = 0.5 + (2.0 * Unit (h));
+				const double phase  = 6.283185307179586 * Unit (Mix (h));
+				const double mid    = base * (1.0 + (0.01 * std::sin (phase + (6.283185307179586 * timestamp / kSyntheticPeriod))) + (0.0005 * (Unit (Mix (x)) - 0.5)));
+				const double spread = mid * 0.0002 * (1.0 + Unit (x));
+				std::for_each (bids_.begin(), bids_.end(), [&](size_t idx) { (*fields_)[idx] = mid - (0.5 * spread); });
+				std::for_each (asks_.begin(), asks_.end(), [&](size_t idx) { (*fields_)[idx] = mid + (0.5 * spread); });
+				current_ = symbol;
+				current_time_ = timestamp;
+				return true;
+			}
+			return false;
+		}
+
+		virtual const char* GetCurrentSymbolName() override {
+			return universe_[current_].c_str();
+		}
+
+		virtual __time32_t GetCurrentTime32() override {
+			return current_time_;
+		}
+
+		virtual void Close() override {
+			fields_ = nullptr;
+		}
+
+	private:
+		uint64_t seed_;
+		unsigned ticks_per_second_;
+		std::vector<std::string> universe_;
+		std::vector<char> is_selected_;
+		std::vector<size_t> bids_, asks_;
+		std::vector<double>* fields_;
+		__time32_t timestamp_, till_, current_time_;
+		unsigned draw_;
+		size_t current_;
+	};
+
+} /* anonymous namespace */
+
+hilo::synthetic_source_factory_t::synthetic_source_factory_t (
+	uint64_t	seed,
+	unsigned	ticks_per_second,
+	const std::vector<std::string>& universe
+	) :
+	seed_ (seed),
+	ticks_per_second_ (ticks_per_second),
+	universe_ (universe)
+{
+}
+
+std::unique_ptr<hilo::tick_source_t>
+hilo::synthetic_source_factory_t::Create() const
+{
+	return std::unique_ptr<tick_source_t> (new synthetic_source_t (seed_, ticks_per_second_, universe_));
+}
+
+void
+hilo::SetDefaultTickSourceFactory (
+	const tick_source_factory_t* factory
+	)
+{
+	g_default_factory = factory;
+}
+
+const hilo::tick_source_factory_t*
+hilo::GetDefaultTickSourceFactory()
+{
+	return g_default_factory;
+}
+
+/* eof */
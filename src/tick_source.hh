@@ -0,0 +1,82 @@
+/* Forward cursor over quote ticks independent of the tick store.
+ *
+ * The engines read every window through a tick source: the Velocity Analytics
+ * FlexRecReader registered by the plugin, or a memory-mapped tick file or
+ * synthetic generator to replay and benchmark outside of the engine.
+ */
+
+#ifndef __TICK_SOURCE_HH__
+#define __TICK_SOURCE_HH__
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* Boost noncopyable base class. */
+#include <boost/utility.hpp>
+
+#ifndef _MSC_VER
+/* Microsoft CRT 32-bit time for the stand-alone benchmarks. */
+typedef int32_t __time32_t;
+#endif
+
+namespace hilo
+{
+	class tick_source_t : boost::noncopyable
+	{
+	public:
+		virtual ~tick_source_t() {}
+
+/* Ticks of the symbol set in [from, till) in timestamp order, each Next()
+ * writes the value of every field in field_map into its fields slot.  A window
+ * without ticks opens with no records, false only if the source fails.
+ */
+		virtual bool Open (std::set<std::string>& symbol_set, const std::unordered_map<std::string, size_t>& field_map, std::vector<double>*const fields, __time32_t from, __time32_t till) = 0;
+		virtual bool Next() = 0;
+		virtual const char* GetCurrentSymbolName() = 0;
+		virtual __time32_t GetCurrentTime32() = 0;
+		virtual void Close() = 0;
+	};
+
+/* New cursor per scan, cursors of one factory may run concurrently. */
+	class tick_source_factory_t
+	{
+	public:
+		virtual ~tick_source_factory_t() {}
+		virtual std::unique_ptr<tick_source_t> Create() const = 0;
+	};
+
+/* Factory of scans without a source in their options.  The engines never
+ * name FlexRecReader so they build without the Velocity Analytics SDK, the
+ * plugin registers it at start-up.  Not owned, must outlive every scan.
+ */
+	void SetDefaultTickSourceFactory (const tick_source_factory_t* factory);
+	const tick_source_factory_t* GetDefaultTickSourceFactory();
+
+/* Deterministic random walk quotes, ticks_per_second draws per second each
+ * from one symbol of the universe.  A tick is a pure function of the seed,
+ * second and draw so any window split yields the same ticks.  Fields named
+ * with "Ask" take the ask price, every other field the bid.
+ */
+	class synthetic_source_factory_t : public tick_source_factory_t
+	{
+	public:
+		synthetic_source_factory_t (uint64_t seed, unsigned ticks_per_second, const std::vector<std::string>& universe);
+
+		virtual std::unique_ptr<tick_source_t> Create() const override;
+
+	private:
+		uint64_t seed_;
+		unsigned ticks_per_second_;
+		std::vector<std::string> universe_;
+	};
+
+} /* namespace hilo */
+
+#endif /* __TICK_SOURCE_HH__ */
+
+/* eof */